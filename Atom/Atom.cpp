@@ -175,6 +175,11 @@ void Atom::GenerateBruecknerOrbitals(bool generate_sigmas)
         }
     }
 
+    // Optionally replace sigma matrices by low-rank approximations for faster application
+    double compression_tolerance = user_input("MBPT/Brueckner/CompressionTolerance", 0.0);
+    if(compression_tolerance > 0.)
+        brueckner->CompressSigmas(compression_tolerance);
+
     // And finally change all our valence orbitals to Brueckner orbitals
     pIntegrator integrator(new SimpsonsIntegrator(lattice));
     pODESolver ode_solver(new AdamsSolver(integrator));
@@ -91,8 +91,10 @@ public:
     /** Calculate levels for given HamiltonianID, generating CI integrals if required via. MakeIntegrals().
         PRE: ChooseHamiltoniansAndRead() must have been run.
         Levels are added to LevelMap levels.
+        If initial_guess is supplied (e.g. levels of the same HamiltonianID from another run),
+        its eigenvectors are used to start the Davidson method.
     */
-    LevelVector CalculateEnergies(pHamiltonianID hID);
+    LevelVector CalculateEnergies(pHamiltonianID hID, const LevelVector* initial_guess = nullptr);
 
     pLevelStore GetLevels() { return levels; }
     pAngularDataLibrary GetAngularDataLibrary() { return angular_library; }
@@ -130,6 +132,16 @@ protected:
      */
     LevelVector SingleElectronConfigurations(pHamiltonianID sym);
 
+    /** Selected CI: starting from the leading configurations, iteratively solve CI in the selected space
+        and add external configurations whose second-order (Epstein-Nesbet) contribution to any of the
+        lowest num_solutions levels exceeds CI/SelectedCI/Threshold.
+        Coupling to the external configurations is only generated for configurations added in each iteration.
+        Returns the selected subset of configs, or configs itself if there is nothing to select,
+        if every configuration is selected, or if the selected space has no levels.
+        PRE: MakeIntegrals() must have been run.
+     */
+    pRelativisticConfigList SelectConfigurations(pHamiltonianID hID, pRelativisticConfigList configs, unsigned int num_solutions);
+
     /** Attempt to read basis from file and generate HF operator.
         Return true if successful, false if file "identifier.basis" not found.
      */
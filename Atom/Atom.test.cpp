@@ -0,0 +1,97 @@
+#include "Atom.h"
+#include "gtest/gtest.h"
+#include "Include.h"
+#include "Configuration/ConfigGenerator.h"
+#include "Atom/MultirunOptions.h"
+#include <cstdio>
+
+using namespace Ambit;
+
+namespace
+{
+/** Run CI for MgI J = 0 even with the given selected CI threshold and return the resulting levels. */
+LevelVector SelectedCILevels(const std::string& identifier, const std::string& threshold, pRelativisticConfigList& full_configs)
+{
+    std::string user_input_string = std::string() +
+        "NuclearRadius = 3.7188\n" +
+        "NuclearThickness = 2.3\n" +
+        "Z = 12\n" +
+        "[HF]\n" +
+        "N = 10\n" +
+        "Configuration = '1s2 2s2 2p6'\n" +
+        "[Basis]\n" +
+        "--bspline-basis\n" +
+        "ValenceBasis = 6spd\n" +
+        "BSpline/Rmax = 45.0\n" +
+        "[CI]\n" +
+        "LeadingConfigurations = '3s2'\n" +
+        "ElectronExcitations = 2\n" +
+        "EvenParityTwoJ = '0'\n" +
+        "NumSolutions = 1\n" +
+        "[CI/SelectedCI]\n" +
+        "Threshold = " + threshold + "\n";
+
+    std::stringstream user_input_stream(user_input_string);
+    MultirunOptions userInput(user_input_stream, "//", "\n", ",");
+
+    pAngularDataLibrary angular_library = std::make_shared<AngularDataLibrary>();
+    Atom atom(userInput, 12, identifier);
+    atom.MakeBasis();
+    atom.ChooseHamiltoniansAndRead(angular_library);
+
+    pHamiltonianID hID = std::make_shared<HamiltonianID>(0, Parity::even);
+    LevelVector levelvec = atom.CalculateEnergies(hID);
+
+    ConfigGenerator config_generator(atom.GetBasis(), userInput);
+    full_configs = config_generator.GenerateRelativisticConfigurations(config_generator.GenerateConfigurations(), hID->GetSymmetry(), angular_library);
+
+    std::remove((identifier + ".basis").c_str());
+    std::remove((identifier + ".levels").c_str());
+
+    return levelvec;
+}
+}
+
+TEST(AtomTester, SelectedCI)
+{
+    pRelativisticConfigList full_configs;
+    NonRelConfiguration leading("3s2");
+
+    // Threshold of zero selects everything: full CI
+    LevelVector full = SelectedCILevels("SelectedCIFull", "0.0", full_configs);
+    ASSERT_EQ(1, full.levels.size());
+    EXPECT_EQ(full_configs->size(), full.configs->size());
+
+    // Nothing is important enough to add to the leading configuration
+    LevelVector leading_only = SelectedCILevels("SelectedCILeading", "1.0", full_configs);
+    ASSERT_EQ(1, leading_only.levels.size());
+    ASSERT_EQ(1, leading_only.configs->size());
+    EXPECT_TRUE(leading == NonRelConfiguration(*leading_only.configs->begin()));
+
+    // Intermediate threshold: a proper subset of the full space, in the same order, including the leading configuration
+    LevelVector selected = SelectedCILevels("SelectedCI", "1.e-4", full_configs);
+    ASSERT_EQ(1, selected.levels.size());
+    EXPECT_LT(1, selected.configs->size());
+    EXPECT_GT(full_configs->size(), selected.configs->size());
+
+    bool found_leading = false;
+    auto full_it = full_configs->begin();
+    for(auto it = selected.configs->begin(); it != selected.configs->end(); it++)
+    {
+        while(full_it != full_configs->end() && !(*full_it == *it))
+            full_it++;
+        ASSERT_TRUE(full_it != full_configs->end());
+
+        if(leading == NonRelConfiguration(*it))
+            found_leading = true;
+    }
+    EXPECT_TRUE(found_leading);
+
+    // Selected space is variational: between the leading configuration and full CI, and close to full CI
+    double E_full = full.levels[0]->GetEnergy();
+    double E_leading = leading_only.levels[0]->GetEnergy();
+    double E_selected = selected.levels[0]->GetEnergy();
+    EXPECT_LE(E_full, E_selected + 1.e-10);
+    EXPECT_LT(E_selected, E_leading);
+    EXPECT_NEAR(E_full, E_selected, 0.1 * (E_leading - E_full));
+}
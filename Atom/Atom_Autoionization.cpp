@@ -523,6 +523,11 @@ void Atom::AutoionizationConfigurationAveraged(const OccupationMap& target)
     double energy_unit_conversion = math->HartreeEnergyIneV();
     double rate_unit_conversion = math->AtomicFrequencySI() * 1.e-9;    // (ns-1)
 
+    // Tabulated orbital energies and pair interactions for compound configuration energies
+    pConfigurationAverageEnergyConst average_energy = nullptr;
+    if(!use_single_particle_energy)
+        average_energy = std::make_shared<ConfigurationAverageEnergy>(orbitals->valence, hf_electron, twobody_electron->GetIntegrals());
+
     // Loop over all configurations
     for(auto& rconfig: *allconfigs)
     {
@@ -544,7 +549,7 @@ void Atom::AutoionizationConfigurationAveraged(const OccupationMap& target)
         }
         else
         {   OccupationMap rcompound = target + rdiff;
-            eps_energy = CalculateConfigurationAverageEnergy(rcompound, orbitals->valence, hf_electron, twobody_electron->GetIntegrals()) - ionization_energy;
+            eps_energy = average_energy->GetEnergy(rcompound) - ionization_energy;
         }
 
         if(energy_limit > 0.0 && (eps_energy > energy_limit))
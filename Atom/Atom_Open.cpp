@@ -331,6 +331,9 @@ pLevelStore Atom::ChooseHamiltoniansAndRead(pAngularDataLibrary angular_lib)
     else
         levels = std::make_shared<LevelMap>(identifier, angular_library);
 
+    if(user_input.search("CI/Output/--float-eigenvectors") || user_input.VariableExists("CI/Output/EigenvectorTruncation"))
+        levels->SetEigenvectorStorage(user_input.search("CI/Output/--float-eigenvectors"), user_input("CI/Output/EigenvectorTruncation", 0.0));
+
     if(user_input.search(2, "--no-ci", "--no-CI"))
     {
         // Use all symmetries from valence set
@@ -566,7 +569,7 @@ pLevelStore Atom::CalculateEnergies()
     return levels;
 }
 
-LevelVector Atom::CalculateEnergies(pHamiltonianID hID)
+LevelVector Atom::CalculateEnergies(pHamiltonianID hID, const LevelVector* initial_guess)
 {
     // This function is public and can call the other CalculateEnergies variants.
     LevelVector levelvec = levels->GetLevels(hID);
@@ -633,6 +636,47 @@ LevelVector Atom::CalculateEnergies(pHamiltonianID hID)
             if(twobody_electron == nullptr)
                 MakeIntegrals();
 
+            // Tabulate reduced sigma3 diagrams for orbitals in the leading configurations
+            if(threebody_electron && user_input.search("MBPT/--sigma3-table"))
+            {
+                pOrbitalMap leading_orbitals = std::make_shared<OrbitalMap>(*orbitals->valence);
+                auto it = leading_orbitals->begin();
+                while(it != leading_orbitals->end())
+                {
+                    bool found = false;
+                    for(const auto& config: leading_configs->first)
+                    {   if(config.GetOccupancy(NonRelInfo(it->first.PQN(), it->first.L())))
+                        {   found = true;
+                            break;
+                        }
+                    }
+
+                    if(found)
+                        it++;
+                    else
+                        it = leading_orbitals->erase(it);
+                }
+
+                if(!threebody_electron->HasReducedTable(leading_orbitals))
+                {
+                    std::string sigma3_filename = identifier + ".sigma3";
+                    threebody_electron->Read(sigma3_filename, leading_orbitals);
+
+                    if(!threebody_electron->HasReducedTable(leading_orbitals))
+                    {
+                        threebody_electron->CalculateReducedTable(leading_orbitals);
+                        threebody_electron->Write(sigma3_filename);
+                    }
+
+                    if(user_input.search("--check-sizes"))
+                        *outstream << "\nSigma3 reduced table size: " << threebody_electron->GetReducedTableSize() << std::endl;
+                }
+            }
+
+            // Restrict CI space to the configurations selected by perturbative importance
+            if(user_input.VariableExists("CI/SelectedCI/Threshold"))
+                configs = SelectConfigurations(hID, configs, num_solutions);
+
             std::unique_ptr<HamiltonianMatrix> H;
             if(threebody_electron)
                 H.reset(new HamiltonianMatrix(hf_electron, twobody_electron, threebody_electron, leading_configs, configs));
@@ -672,6 +716,9 @@ LevelVector Atom::CalculateEnergies(pHamiltonianID hID)
                 *outstream << "Matrix Before:\n" << *H << std::endl;
             }
 
+            if(user_input.search("CI/--no-warm-start"))
+                initial_guess = nullptr;
+
             #ifdef AMBIT_USE_SCALAPACK
             if(user_input.search("CI/--scalapack") || user_input.VariableExists("CI/MaxEnergy"))
             {
@@ -687,7 +734,7 @@ LevelVector Atom::CalculateEnergies(pHamiltonianID hID)
             }
             else
             #endif
-            levelvec = H->SolveMatrix(hID, num_solutions);
+            levelvec = H->SolveMatrix(hID, num_solutions, initial_guess);
             levels->Store(hID, levelvec);
         }
 
@@ -773,6 +820,273 @@ LevelVector Atom::CalculateEnergies(pHamiltonianID hID)
     return levelvec;
 }
 
+pRelativisticConfigList Atom::SelectConfigurations(pHamiltonianID hID, pRelativisticConfigList configs, unsigned int num_solutions)
+{
+    double threshold = user_input("CI/SelectedCI/Threshold", 0.0);
+    int max_iterations = user_input("CI/SelectedCI/MaxIterations", 10);
+    int configs_per_chunk = user_input("CI/ChunkSize", 4);
+
+    if(!leading_configs)
+    {
+        *outstream << "\nSelected CI: no leading configurations to start from; using full CI space." << std::endl;
+        return configs;
+    }
+    else if(configs->small_size() != configs->size())
+    {
+        *outstream << "\nSelected CI: cannot select from a non-square CI matrix; using full CI space." << std::endl;
+        return configs;
+    }
+
+    // Start from the relativistic configurations belonging to the leading configurations
+    std::vector<bool> selected(configs->size(), false);
+    std::vector<unsigned int> config_csf_offset(configs->size());
+    unsigned int num_selected = 0;
+    auto config_it = configs->begin();
+    for(unsigned int i = 0; i < configs->size(); i++, config_it++)
+    {
+        config_csf_offset[i] = config_it.csf_offset();
+        if(std::binary_search(leading_configs->first.begin(), leading_configs->first.end(), NonRelConfiguration(*config_it)))
+        {   selected[i] = true;
+            num_selected++;
+        }
+    }
+
+    if(num_selected == 0)
+    {
+        *outstream << "\nSelected CI: leading configurations have no CSFs with this symmetry; using full CI space." << std::endl;
+        return configs;
+    }
+    else if(num_selected == configs->size())
+    {
+        *outstream << "\nSelected CI: no external configurations to select from; using full CI space." << std::endl;
+        return configs;
+    }
+
+    *outstream << "\nSelected CI: threshold = " << threshold << std::endl;
+
+    // The coupling of external configurations Q to the selected configurations P is built up incrementally.
+    // Each block is the non-square Hamiltonian (A + Q) x A, where A are the configurations added to P in
+    // that iteration, so columns of earlier iterations are never regenerated.
+    struct CouplingBlock
+    {   pRelativisticConfigList configs;
+        std::vector<unsigned int> config_index;     //!< Index in the full list of each config in the block
+        std::unique_ptr<HamiltonianMatrix> H;
+    };
+    std::vector<CouplingBlock> blocks;
+
+    std::vector<bool> newly_selected(selected);
+    std::vector<double> diag(configs->NumCSFs(), 0.);   // Diagonal <q|H|q>, taken from the first block
+
+    std::vector<double> energies;
+    std::vector<double> remainder;
+    bool converged = false;
+
+    for(int iteration = 0; iteration < max_iterations && !converged; iteration++)
+    {
+        // P = selected configurations
+        pRelativisticConfigList P = std::make_shared<RelativisticConfigList>();
+        std::vector<unsigned int> P_csf_offset(configs->size(), 0);
+        unsigned int P_num_csfs = 0;
+
+        config_it = configs->begin();
+        for(unsigned int i = 0; i < configs->size(); i++, config_it++)
+        {
+            if(selected[i])
+            {   P_csf_offset[i] = P_num_csfs;
+                P_num_csfs += config_it->NumCSFs();
+                P->push_back(*config_it);
+            }
+        }
+        P->SetSmallSize(P->size());
+
+        *outstream << "Iteration " << iteration << ": " << P->size() << " configurations;";
+
+        // Solve in the selected space
+        std::unique_ptr<HamiltonianMatrix> H;
+        if(threebody_electron)
+            H.reset(new HamiltonianMatrix(hf_electron, twobody_electron, threebody_electron, leading_configs, P));
+        else
+            H.reset(new HamiltonianMatrix(hf_electron, twobody_electron, P));
+
+        H->GenerateMatrix(configs_per_chunk);
+        LevelVector levelvec = H->SolveMatrix(hID, num_solutions);
+        H.reset();
+
+        unsigned int num_levels = levelvec.levels.size();
+        if(num_levels == 0)
+        {
+            *outstream << "\nSelected CI: no levels found in the selected space; using full CI space." << std::endl;
+            return configs;
+        }
+
+        // New coupling block for the configurations added since the last iteration
+        CouplingBlock block;
+        block.configs = std::make_shared<RelativisticConfigList>();
+
+        config_it = configs->begin();
+        for(unsigned int i = 0; i < configs->size(); i++, config_it++)
+        {
+            if(newly_selected[i])
+            {   block.configs->push_back(*config_it);
+                block.config_index.push_back(i);
+            }
+        }
+        block.configs->SetSmallSize(block.configs->size());
+
+        config_it = configs->begin();
+        for(unsigned int i = 0; i < configs->size(); i++, config_it++)
+        {
+            if(!selected[i])
+            {   block.configs->push_back(*config_it);
+                block.config_index.push_back(i);
+            }
+        }
+
+        if(threebody_electron)
+            block.H.reset(new HamiltonianMatrix(hf_electron, twobody_electron, threebody_electron, leading_configs, block.configs));
+        else
+            block.H.reset(new HamiltonianMatrix(hf_electron, twobody_electron, block.configs));
+        *outstream << std::endl;
+
+        block.H->GenerateMatrix(configs_per_chunk);
+
+        if(blocks.empty())
+        {
+            // The first block contains every configuration, so it supplies the whole diagonal
+            std::vector<double> block_diag(block.configs->NumCSFs());
+            block.H->GetDiagonal(block_diag.data());
+
+        #ifdef AMBIT_USE_MPI
+            std::vector<double> buffer(block_diag);
+            MPI_Allreduce(buffer.data(), block_diag.data(), block_diag.size(), MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+        #endif
+
+            auto block_it = block.configs->begin();
+            for(unsigned int j = 0; j < block.config_index.size(); j++, block_it++)
+                std::copy_n(block_diag.begin() + block_it.csf_offset(), block_it->NumCSFs(), diag.begin() + config_csf_offset[block.config_index[j]]);
+        }
+
+        blocks.push_back(std::move(block));
+        newly_selected.assign(configs->size(), false);
+
+        // Accumulate <q|H|Psi_n> over all blocks, indexed by CSF in the full list
+        unsigned int N = configs->NumCSFs();
+        std::vector<double> c(N * num_levels, 0.);
+
+        energies.resize(num_levels);
+        for(unsigned int n = 0; n < num_levels; n++)
+            energies[n] = levelvec.levels[n]->GetEnergy();
+
+        for(auto& current_block: blocks)
+        {
+            unsigned int block_N = current_block.configs->NumCSFs();
+            std::vector<double> b(block_N * num_levels, 0.);
+            std::vector<double> block_c(block_N * num_levels);
+
+            auto block_it = current_block.configs->begin();
+            for(unsigned int j = 0; j < current_block.configs->small_size(); j++, block_it++)
+            {
+                unsigned int P_start = P_csf_offset[current_block.config_index[j]];
+                for(unsigned int n = 0; n < num_levels; n++)
+                {
+                    const std::vector<double>& eigenvector = levelvec.levels[n]->GetEigenvector();
+                    std::copy_n(eigenvector.begin() + P_start, block_it->NumCSFs(), b.begin() + n * block_N + block_it.csf_offset());
+                }
+            }
+
+            current_block.H->MatrixMultiply(num_levels, b.data(), block_c.data());
+
+            for(unsigned int j = current_block.configs->small_size(); j < current_block.config_index.size(); j++, block_it++)
+            {
+                unsigned int i = current_block.config_index[j];
+                if(selected[i])
+                    continue;
+
+                for(unsigned int n = 0; n < num_levels; n++)
+                    for(unsigned int r = 0; r < block_it->NumCSFs(); r++)
+                        c[n * N + config_csf_offset[i] + r] += block_c[n * block_N + block_it.csf_offset() + r];
+            }
+        }
+
+    #ifdef AMBIT_USE_MPI
+        std::vector<double> buffer(c);
+        MPI_Allreduce(buffer.data(), c.data(), c.size(), MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    #endif
+
+        // Epstein-Nesbet estimate of each external configuration's contribution to the target levels:
+        //      dE_n = sum_q |<q|H|Psi_n>|^2/(E_n - H_qq)
+        // Configurations with max_n |dE_n| above threshold are added to P.
+        remainder.assign(num_levels, 0.);
+        unsigned int num_external = configs->size() - num_selected;
+        unsigned int num_added = 0;
+        config_it = configs->begin();
+        for(unsigned int i = 0; i < configs->size(); i++, config_it++)
+        {
+            if(selected[i])
+                continue;
+
+            double importance = 0.;
+            std::vector<double> contribution(num_levels, 0.);
+            for(unsigned int n = 0; n < num_levels; n++)
+            {
+                unsigned int csf_start = config_csf_offset[i];
+                for(unsigned int r = csf_start; r < csf_start + config_it->NumCSFs(); r++)
+                {
+                    double denominator = energies[n] - diag[r];
+                    if(fabs(denominator) < 1.e-8)
+                        denominator = (denominator < 0.? -1.e-8: 1.e-8);
+
+                    contribution[n] += c[n * N + r] * c[n * N + r]/denominator;
+                }
+                importance = mmax(importance, fabs(contribution[n]));
+            }
+
+            if(importance >= threshold)
+            {   selected[i] = true;
+                newly_selected[i] = true;
+                num_added++;
+            }
+            else
+            {   for(unsigned int n = 0; n < num_levels; n++)
+                    remainder[n] += contribution[n];
+            }
+        }
+        num_selected += num_added;
+
+        *outstream << "    added " << num_added << " of " << num_external << " external configurations." << std::endl;
+
+        if(num_selected == configs->size())
+        {
+            *outstream << "Selected CI: all external configurations were added; using full CI space." << std::endl;
+            return configs;
+        }
+
+        converged = (num_added == 0);
+    }
+
+    if(converged)
+    {
+        *outstream << "Selected CI converged. Second-order estimate of unselected configurations:" << std::endl;
+        *outstream << std::setprecision(8);
+        for(unsigned int n = 0; n < energies.size(); n++)
+            *outstream << "  " << n << ": E = " << energies[n] << ", dE = " << remainder[n] << std::endl;
+    }
+    else
+        *outstream << "Selected CI not converged after " << max_iterations << " iterations; using "
+                   << num_selected << " of " << configs->size() << " configurations." << std::endl;
+
+    pRelativisticConfigList selected_configs = std::make_shared<RelativisticConfigList>();
+    config_it = configs->begin();
+    for(unsigned int i = 0; i < configs->size(); i++, config_it++)
+    {
+        if(selected[i])
+            selected_configs->push_back(*config_it);
+    }
+    selected_configs->SetSmallSize(selected_configs->size());
+
+    return selected_configs;
+}
+
 LevelVector Atom::SingleElectronConfigurations(pHamiltonianID sym)
 {
     LevelVector levelvec = levels->GetLevels(sym);
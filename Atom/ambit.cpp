@@ -351,6 +351,9 @@ void AmbitInterface::EnergyCalculations()
 
         for(auto& key: levels->keys)
         {
+            // Levels of previous run: the CSFs are the same, so use these as a starting point
+            LevelVector previous_levels;
+
             for(int i = 0; i < run_indexes.size(); i++)
             {
                 // This if statement is just to switch off printing the run condition for only one run
@@ -358,7 +361,7 @@ void AmbitInterface::EnergyCalculations()
                 {   user_input.SetRun(run_indexes[i]);
                     user_input.PrintCurrentRunCondition(*outstream, "\n");
                 }
-                atoms[i].CalculateEnergies(key);
+                previous_levels = atoms[i].CalculateEnergies(key, &previous_levels);
             }
         }
     }
@@ -373,6 +376,7 @@ do { \
   { \
     user_input.set_prefix(prefix); \
     TRANSITION_CALCULATOR_TYPE calculon(user_input, atom); \
+    calculon.SetTransitionDensityLibrary(density_library); \
     calculon.CalculateAndPrint(); \
     calculon.PrintAll(); \
   } \
@@ -391,6 +395,33 @@ void AmbitInterface::TransitionCalculations()
             std::make_tuple("E3", MultipolarityType::E, 3),
            };
 
+    // Other operators: rank and parity
+    std::array<std::tuple<std::string, int, Parity>, 5> other_transition_types =
+           {std::make_tuple("HFS1", 1, Parity::even),
+            std::make_tuple("HFS2", 2, Parity::even),
+            std::make_tuple("FS", 0, Parity::even),
+            std::make_tuple("QED", 0, Parity::even),
+            std::make_tuple("Yukawa", 0, Parity::even),
+           };
+
+    // Transition densities are shared between all operators, and those for every requested
+    // rank and parity are calculated together in a single pass over the CI expansion.
+    pTransitionDensityLibrary density_library = std::make_shared<TransitionDensityLibrary>();
+    for(const auto& types: EM_transition_types)
+    {
+        if(user_input.SectionExists("Transitions/" + std::get<0>(types)))
+        {
+            int K = std::get<2>(types);
+            bool odd = (std::get<1>(types) == MultipolarityType::E)? (K%2): !(K%2);
+            density_library->Register(K, (odd? Parity::odd: Parity::even));
+        }
+    }
+    for(const auto& types: other_transition_types)
+    {
+        if(user_input.SectionExists("Transitions/" + std::get<0>(types)))
+            density_library->Register(std::get<1>(types), std::get<2>(types));
+    }
+
     std::vector<std::unique_ptr<EMCalculator>> calculators;
 
     for(const auto& types: EM_transition_types)
@@ -401,6 +432,7 @@ void AmbitInterface::TransitionCalculations()
         {
             user_input.set_prefix(user_string);
             std::unique_ptr<EMCalculator> calculon(new EMCalculator(std::get<1>(types), std::get<2>(types), user_input, atom));
+            calculon->SetTransitionDensityLibrary(density_library);
 
             calculon->CalculateAndPrint();
             calculators.push_back(std::move(calculon));
@@ -346,11 +346,18 @@ pOrbitalMap BSplineBasis::GenerateBSplines(pHFOperatorConst hf, int kappa, int m
         BSpline& Bj = *splines[j];
         SpinorFunction hf_applied_to_Bj = hf->ApplyTo(Bj);
 
+        // All Bi (i >= j) against the same Bj
+        std::vector<const SpinorFunction*> Bi_list;
+        for(i=j; i<n2; i++)
+            Bi_list.push_back(splines[i].get());
+
+        std::vector<double> A_j = integrator->GetInnerProducts(Bi_list, hf_applied_to_Bj);
+        std::vector<double> b_j = integrator->GetInnerProducts(Bi_list, Bj);
+
         for(i=j; i<n2; i++)
         {
-            BSpline& Bi = *splines[i];
-            A(i, j) = A(j, i) = integrator->GetInnerProduct(Bi, hf_applied_to_Bj);
-            b(i, j) = b(j, i) = integrator->GetInnerProduct(Bi, Bj);
+            A(i, j) = A(j, i) = A_j[i-j];
+            b(i, j) = b(j, i) = b_j[i-j];
         }
     }
 
@@ -14,24 +14,25 @@
 namespace Ambit
 {
 AngularData::AngularData(int two_m):
-    two_m(two_m), two_j(-1), num_CSFs(0), CSFs(nullptr), have_CSFs(false)
+    num_projections(0), particle_number(0), two_m(two_m), have_CSFs(false), CSFs(nullptr), num_CSFs(0), two_j(-1)
 {}
 
 AngularData::AngularData(const RelativisticConfiguration& config, int two_m):
-    two_m(two_m), two_j(-1), num_CSFs(0), CSFs(nullptr), have_CSFs(false)
+    num_projections(0), particle_number(0), two_m(two_m), have_CSFs(false), CSFs(nullptr), num_CSFs(0), two_j(-1)
 {
     GenerateProjections(config, two_m);
 }
 
 AngularData::AngularData(const RelativisticConfiguration& config, int two_m, int two_j):
-    two_m(two_m), two_j(-1), num_CSFs(0), CSFs(nullptr), have_CSFs(false)
+    num_projections(0), particle_number(0), two_m(two_m), have_CSFs(false), CSFs(nullptr), num_CSFs(0), two_j(-1)
 {
     GenerateProjections(config, two_m);
     GenerateCSFs(config, two_j);
 }
 
 AngularData::AngularData(const AngularData& other):
-    two_m(other.two_m), two_j(other.two_j), num_CSFs(other.num_CSFs), have_CSFs(other.have_CSFs), projections(other.projections)
+    projections(other.projections), num_projections(other.num_projections), particle_number(other.particle_number), two_m(other.two_m),
+    have_CSFs(other.have_CSFs), CSFs(nullptr), num_CSFs(other.num_CSFs), two_j(other.two_j)
 {
     if(have_CSFs)
     {
@@ -41,8 +42,12 @@ AngularData::AngularData(const AngularData& other):
 }
 
 AngularData::AngularData(AngularData&& other):
-    two_m(other.two_m), two_j(other.two_j), num_CSFs(other.num_CSFs), have_CSFs(other.have_CSFs), projections(other.projections)
+    projections(std::move(other.projections)), num_projections(other.num_projections), particle_number(other.particle_number), two_m(other.two_m),
+    have_CSFs(other.have_CSFs), CSFs(nullptr), num_CSFs(other.num_CSFs), two_j(other.two_j)
 {
+    other.projections.clear();
+    other.num_projections = 0;
+
     if(have_CSFs)
     {
         CSFs = other.CSFs;
@@ -84,13 +89,13 @@ int AngularData::GenerateProjections(const RelativisticConfiguration& config, in
     // At each step populate all possible projections with M-1.
     // Stop when desired M is reached.
 
-    int particle_number = config.ParticleNumber();
+    particle_number = config.ParticleNumber();
 
     // Skip if vacuum
     if(particle_number == 0)
     {
         projections.clear();
-        projections.push_back(std::vector<int>());
+        num_projections = 1;
         return 1;
     }
 
@@ -169,25 +174,36 @@ int AngularData::GenerateProjections(const RelativisticConfiguration& config, in
     }
 
     // Sort and merge projections lists
-    projections.clear();
+    std::vector<std::vector<int>> projection_list;
     int reserve_size = 0;
     for(auto& list: boxes)
         reserve_size += list.size();
-    projections.reserve(reserve_size);
+    projection_list.reserve(reserve_size);
 
     for(auto& list: boxes)
-    {   projections.insert(projections.end(), list.begin(), list.end());
+    {   projection_list.insert(projection_list.end(), list.begin(), list.end());
     }
-    std::sort(projections.begin(), projections.end(), ProjectionCompare);
-    std::unique(projections.begin(), projections.end());
-    projections.shrink_to_fit();
+    std::sort(projection_list.begin(), projection_list.end(), ProjectionCompare);
+    projection_list.erase(std::unique(projection_list.begin(), projection_list.end()), projection_list.end());
+
+    SetProjections(projection_list, particle_number);
+    return num_projections;
+}
+
+void AngularData::SetProjections(const std::vector<std::vector<int>>& projection_list, unsigned int particle_number)
+{
+    this->particle_number = particle_number;
+    num_projections = projection_list.size();
 
-    return projections.size();
+    projections.clear();
+    projections.reserve(num_projections * particle_number);
+    for(const auto& projection: projection_list)
+        projections.insert(projections.end(), projection.begin(), projection.end());
 }
 
 int AngularData::GenerateCSFs(const RelativisticConfiguration& config, int two_j)
 {
-    unsigned int N = projections.size();
+    unsigned int N = num_projections;
     this->two_j = two_j;
 
     // Clear existing
@@ -206,9 +222,9 @@ int AngularData::GenerateCSFs(const RelativisticConfiguration& config, int two_j
 
     // Make vector of Projections.
     std::vector<Projection> real_Projection_list;
-    real_Projection_list.reserve(projections.size());
-    for(const auto& p: projections)
-        real_Projection_list.push_back(Projection(config, p));
+    real_Projection_list.reserve(N);
+    for(auto it = projection_begin(); it != projection_end(); it++)
+        real_Projection_list.push_back(Projection(config, *it));
 
     auto i_it = real_Projection_list.begin();
     auto j_it = i_it;
@@ -276,7 +292,7 @@ int AngularData::GenerateCSFs(const RelativisticConfiguration& config, int two_j
 
 void AngularData::LadderLowering(const RelativisticConfiguration& config, const AngularData& parent)
 {
-    unsigned int N = projections.size();
+    unsigned int N = num_projections;
     this->two_j = parent.two_j;
 
     // Clear existing
@@ -294,15 +310,10 @@ void AngularData::LadderLowering(const RelativisticConfiguration& config, const
     CSFs = new double[N * num_CSFs];
     memset(CSFs, 0, sizeof(double) * N * num_CSFs);
 
-    // Create mapping from projections to CSF index
-    std::map<std::vector<int>, int> projection_positions;
-    int index = 0;
-    for(auto proj_it = projections.begin(); proj_it != projections.end(); proj_it++)
-    {   projection_positions[*proj_it] = index;
-        index++;
-    }
-
-    int particle_number = config.ParticleNumber();
+    // Projections are sorted, so the CSF index of a child projection can be found by binary search
+    auto projection_less = [](const CompactProjection& first, const std::vector<CompactProjection::value_type>& second)
+    {   return std::lexicographical_compare(first.begin(), first.end(), second.begin(), second.end());
+    };
 
     // Create set of boxes, one for each orbital, each with a list of projections to be filled.
     std::vector<int> box_number(particle_number);
@@ -335,8 +346,10 @@ void AngularData::LadderLowering(const RelativisticConfiguration& config, const
     // For each projection in parent, apply J- for all orbitals, find corresponding projection,
     // and update CSFs
     int parent_index = 0;
-    for(auto& parent_proj: parent.projections)
+    std::vector<CompactProjection::value_type> new_proj(particle_number);
+    for(auto parent_it = parent.projection_begin(); parent_it != parent.projection_end(); parent_it++)
     {
+        CompactProjection parent_proj = *parent_it;
         for(int i = 0; i < particle_number; i++)
         {
             int parent_twom = parent_proj[i];
@@ -346,12 +359,12 @@ void AngularData::LadderLowering(const RelativisticConfiguration& config, const
                 box_number[i] != box_number[i+1] ||     // next particle is in a different orbital or
                 parent_proj[i] - parent_proj[i+1] > 2)) // there is room to apply J^-
             {
-                std::vector<int> new_proj(parent_proj);
+                std::copy(parent_proj.begin(), parent_proj.end(), new_proj.begin());
                 new_proj[i] -= 2;
-                auto it = projection_positions.find(new_proj);
-                if(it != projection_positions.end())
+                auto it = std::lower_bound(projection_begin(), projection_end(), new_proj, projection_less);
+                if(it != projection_end() && std::equal(new_proj.begin(), new_proj.end(), (*it).begin()))
                 {
-                    int child_index = it->second;
+                    int child_index = it - projection_begin();
                     double prefactor = sqrt((box_twoj[i] + parent_twom) * (box_twoj[i] - parent_twom + 2))/2.;
                     if(box_ishole[i])
                         prefactor = -prefactor;
@@ -405,20 +418,47 @@ pAngularData AngularDataLibrary::GetData(const RelativisticConfiguration& config
 
 pAngularData AngularDataLibrary::GetData(const KeyType& key)
 {
-    pAngularData& ret = library[key];
-    if(ret != nullptr)
-        return ret;
+    pAngularData ret;
 
-    auto file_info_key = std::make_tuple(GetElectronNumber(key), key[0].first, key[0].second);
-    if(file_info[file_info_key].second.empty())
+    // Library lookup and file reading are serialised, but generating projections is not.
+#ifdef AMBIT_USE_OPENMP
+    #pragma omp critical(ANGULAR_DATA_LIBRARY)
+#endif
     {
-        Read(file_info_key);
+        auto it = library.find(key);
+        if(it != library.end())
+            ret = it->second;
+
+        if(ret == nullptr)
+        {
+            auto file_info_key = std::make_tuple(GetElectronNumber(key), key[0].first, key[0].second);
+            if(file_info[file_info_key].second.empty())
+            {
+                Read(file_info_key);
+
+                it = library.find(key);
+                if(it != library.end())
+                    ret = it->second;
+            }
+        }
     }
 
     if(ret != nullptr)
         return ret;
 
-    ret = std::make_shared<AngularData>(GenerateRelConfig(key), key[0].second);
+    pAngularData generated = std::make_shared<AngularData>(GenerateRelConfig(key), key[0].second);
+
+    // Another thread may have generated the same key in the meantime: keep the first one stored.
+#ifdef AMBIT_USE_OPENMP
+    #pragma omp critical(ANGULAR_DATA_LIBRARY)
+#endif
+    {
+        pAngularData& stored = library[key];
+        if(stored == nullptr)
+            stored = generated;
+        ret = stored;
+    }
+
     return ret;
 }
 
@@ -687,10 +727,13 @@ void AngularDataLibrary::Read(int electron_number, const Symmetry& sym, int two_
         file_err_handler->fread(&particle_number, sizeof(int), 1, fp);
         int projection_array[particle_number];
 
+        ang->num_projections = num_projections;
+        ang->particle_number = particle_number;
+        ang->projections.reserve(num_projections * particle_number);
         for(int i = 0; i < num_projections; i++)
         {
             file_err_handler->fread(projection_array, sizeof(int), particle_number, fp);
-            ang->projections.push_back(std::vector<int>(projection_array, projection_array + particle_number));
+            ang->projections.insert(ang->projections.end(), projection_array, projection_array + particle_number);
         }
 
         // CSFs
@@ -786,17 +829,20 @@ void AngularDataLibrary::Write(int electron_number, const Symmetry& sym, int two
                 }
 
                 // Projections
-                int num_projections = pair.second->projections.size();
+                int num_projections = pair.second->num_projections;
                 file_err_handler->fwrite(&num_projections, sizeof(int), 1, fp);
 
                 int particle_number = 0;
                 if(num_projections)
-                    particle_number = pair.second->projections.front().size();
+                    particle_number = pair.second->particle_number;
                 file_err_handler->fwrite(&particle_number, sizeof(int), 1, fp);
 
-                for(const auto& projection: pair.second->projections)
+                // Stored on disk as int
+                std::vector<int> projection_array(particle_number);
+                for(auto it = pair.second->projection_begin(); it != pair.second->projection_end(); it++)
                 {
-                    file_err_handler->fwrite(&projection[0], sizeof(int), particle_number, fp);
+                    std::copy((*it).begin(), (*it).end(), projection_array.begin());
+                    file_err_handler->fwrite(projection_array.data(), sizeof(int), particle_number, fp);
                 }
 
                 // CSFs
@@ -33,13 +33,40 @@ public:
     AngularData(AngularData&& other);
     ~AngularData();
 
-    typedef std::vector<std::vector<int>>::const_iterator const_projection_iterator;
+    /** Random access iterator over list of "projections". Dereferencing gives a CompactProjection
+        that views the contiguous projection storage.
+     */
+    class const_projection_iterator : public boost::iterator_facade<
+        const_projection_iterator,
+        CompactProjection,
+        boost::random_access_traversal_tag,
+        CompactProjection>
+    {
+    public:
+        const_projection_iterator(): m_data(nullptr), m_stride(0), m_index(0) {}
+        const_projection_iterator(const CompactProjection::value_type* data, unsigned int stride, int index):
+            m_data(data), m_stride(stride), m_index(index) {}
+
+    private:
+        friend class boost::iterator_core_access;
+
+        CompactProjection dereference() const { return CompactProjection(m_data + m_index * m_stride, m_stride); }
+        bool equal(const const_projection_iterator& other) const { return m_index == other.m_index; }
+        void increment() { m_index++; }
+        void decrement() { m_index--; }
+        void advance(std::ptrdiff_t n) { m_index += n; }
+        std::ptrdiff_t distance_to(const const_projection_iterator& other) const { return other.m_index - m_index; }
+
+        const CompactProjection::value_type* m_data;
+        unsigned int m_stride;
+        int m_index;
+    };
+
     typedef const double* const_CSF_iterator;
 
-    /** Bidirectional list iterator over list of "projections", i.e. list of std::vector<int> */
-    const_projection_iterator projection_begin() const { return projections.begin(); }
-    const_projection_iterator projection_end() const { return projections.end(); }
-    unsigned int projection_size() const { return projections.size(); }
+    const_projection_iterator projection_begin() const { return const_projection_iterator(projections.data(), particle_number, 0); }
+    const_projection_iterator projection_end() const { return const_projection_iterator(projections.data(), particle_number, num_projections); }
+    unsigned int projection_size() const { return num_projections; }
 
     /** Return whether CSFs have been calculated (or read in). */
     bool CSFs_calculated() const { return have_CSFs; }
@@ -71,8 +98,15 @@ protected:
     int GenerateProjections(const RelativisticConfiguration& config, int two_m);
     static bool ProjectionCompare(const std::vector<int>& first, const std::vector<int>& second);
 
-    /** List of "projections": in this context, vectors of two_Ms. */
-    std::vector<std::vector<int>> projections;
+    /** Copy list of projections (each of size particle_number) into contiguous storage. */
+    void SetProjections(const std::vector<std::vector<int>>& projection_list, unsigned int particle_number);
+
+    /** List of "projections": in this context, lists of two_Ms for each particle.
+        All projections are stored in one contiguous array: projection i starts at projections[i * particle_number].
+     */
+    std::vector<CompactProjection::value_type> projections;
+    unsigned int num_projections;
+    unsigned int particle_number;
     int two_m;
 
     /** CSF coefficients for a given J. Usually one requires all coefficients for a given projection,
@@ -149,6 +183,7 @@ public:
     ~AngularDataLibrary() {}
 
     /** Retrieve or create an AngularData object for the given configuration, two_m, and two_j.
+        Thread-safe with respect to other calls of GetData().
         PRE: abs(two_m) <= sym.GetTwoJ()
              config is sorted correctly.
      */
@@ -70,6 +70,13 @@ TEST(AngularDataTester, Projections)
     EXPECT_EQ(3, (*it)[2]);
     EXPECT_EQ(-3, (*it)[3]);
     EXPECT_EQ(-9, (*it)[4]);
+
+    // Moving leaves the moved-from object with no projections
+    unsigned int num_projections = ang6g24f3_3.projection_size();
+    AngularData moved(std::move(ang6g24f3_3));
+    EXPECT_EQ(num_projections, moved.projection_size());
+    EXPECT_EQ(0, ang6g24f3_3.projection_size());
+    EXPECT_TRUE(ang6g24f3_3.projection_begin() == ang6g24f3_3.projection_end());
 }
 
 TEST(AngularDataTester, CSFs)
@@ -2,6 +2,11 @@
 #include "ConfigGenerator.h"
 #include "HartreeFock/ConfigurationParser.h"
 #include <numeric>
+#include <unordered_map>
+#include <unordered_set>
+#ifdef AMBIT_USE_OPENMP
+#include <omp.h>
+#endif
 
 namespace Ambit
 {
@@ -151,13 +156,24 @@ pRelativisticConfigList ConfigGenerator::ParseAndGenerateConfigurations(pHFInteg
         SortAndUnique(leading_configs);
     }
 
-    // Get maxenergy
-    bool use_maxenergy = false;
-    double upper_energy = 0.0;
+    // Get ConfigurationAverageEnergyRange. Configurations above upper_energy are removed as they are
+    // generated; the lower limit is only applied once no further excitations will be made.
+    pConfigurationAverageEnergyConst average_energy = nullptr;
+    ConfigurationFilter below_upper_energy = nullptr;
+    ConfigurationFilter within_energy_range = nullptr;
     if(one_body && two_body && user_input.vector_variable_size("ConfigurationAverageEnergyRange") == 2)
     {
-        use_maxenergy = true;
-        upper_energy = user_input("ConfigurationAverageEnergyRange", 0.0, 1);
+        average_energy = std::make_shared<ConfigurationAverageEnergy>(orbitals->valence, one_body, two_body);
+        double lower_energy = user_input("ConfigurationAverageEnergyRange", 0.0, 0);
+        double upper_energy = user_input("ConfigurationAverageEnergyRange", 0.0, 1);
+
+        below_upper_energy = [=](const RelativisticConfiguration& item){
+            return (average_energy->GetEnergy(item) <= upper_energy);
+        };
+        within_energy_range = [=](const RelativisticConfiguration& item){
+            double energy = average_energy->GetEnergy(item);
+            return (energy >= lower_energy && energy <= upper_energy);
+        };
     }
 
     // Total number of excitation steps
@@ -218,27 +234,17 @@ pRelativisticConfigList ConfigGenerator::ParseAndGenerateConfigurations(pHFInteg
             }
         }
 
-        GenerateExcitations(rlist, valence_electrons, valence_holes);
-
-        if(use_maxenergy && excitation_step < total_num_excitations-1)
-        {   auto newend = std::remove_if(rlist->begin(), rlist->end(),
-                            [&](RelativisticConfiguration& item){
-                                return (item.CalculateConfigurationAverageEnergy(orbitals->valence, one_body, two_body) > upper_energy);
-                            });
-            rlist->erase(newend, rlist->end());
-        }
+        if(excitation_step < total_num_excitations-1)
+            GenerateExcitations(rlist, valence_electrons, valence_holes, below_upper_energy);
+        else
+            GenerateExcitations(rlist, valence_electrons, valence_holes, within_energy_range);
     }
 
-    // Trim configurations outside of ConfigurationAverageEnergyRange
-    if(one_body && two_body && user_input.vector_variable_size("ConfigurationAverageEnergyRange") == 2)
+    // Trim configurations outside of ConfigurationAverageEnergyRange if no excitations were made
+    if(within_energy_range && total_num_excitations == 0)
     {
-        double lower_energy = user_input("ConfigurationAverageEnergyRange", 0.0, 0);
-
         auto newend = std::remove_if(rlist->begin(), rlist->end(),
-                        [&](RelativisticConfiguration& item){
-                            double energy = item.CalculateConfigurationAverageEnergy(orbitals->valence, one_body, two_body);
-                            return (energy < lower_energy || energy > upper_energy);
-                        });
+                        [&](RelativisticConfiguration& item){ return !within_energy_range(item); });
         rlist->erase(newend, rlist->end());
     }
 
@@ -301,10 +307,13 @@ pRelativisticConfigList ConfigGenerator::ParseAndGenerateConfigurations(pHFInteg
 
             if(user_input.search("--print-relativistic-configurations"))
             {
+                if(!average_energy)
+                    average_energy = std::make_shared<ConfigurationAverageEnergy>(orbitals->valence, one_body, two_body);
+
                 for(auto& config: *rlist)
                 {
                     *outstream << config << "; "
-                               << config.CalculateConfigurationAverageEnergy(orbitals->valence, one_body, two_body)
+                               << average_energy->GetEnergy(config)
                                << "; " << config.GetNumberOfLevels() << "\n";
                 }
             }
@@ -432,97 +441,160 @@ pRelativisticConfigList ConfigGenerator::GenerateRelativisticConfigurations(pRel
     return prlist;
 }
 
-void ConfigGenerator::GenerateExcitations(pRelativisticConfigList configlist, OrbitalMap& electron_valence, OrbitalMap& hole_valence) const
+void ConfigGenerator::GenerateExcitations(pRelativisticConfigList configlist, OrbitalMap& electron_valence, OrbitalMap& hole_valence, const ConfigurationFilter& filter) const
 {
-    // Go through the set of initial configurations
-    RelativisticConfigList old_list(*configlist);
+    // Unique set of initial configurations. Excitations that lead back into this set are
+    // discarded immediately, before any filtering.
+    std::unordered_set<RelativisticConfiguration, ConfigurationHasher> old_set;
+    std::vector<RelativisticConfiguration> old_list;
+    old_list.reserve(configlist->size());
+    for(const auto& config: *configlist)
+    {
+        if(old_set.insert(config).second)
+            old_list.push_back(config);
+    }
+
+    int num_threads = 1;
+#ifdef AMBIT_USE_OPENMP
+    num_threads = omp_get_max_threads();
+#endif
 
-    auto config_it = old_list.begin();
-    while(config_it != old_list.end())
+    // Whether each initial configuration passes the filter, and the accepted new configurations
+    // found by each thread.
+    std::vector<char> keep_old(old_list.size(), true);
+    std::vector<std::vector<RelativisticConfiguration>> thread_configs(num_threads);
+
+#ifdef AMBIT_USE_OPENMP
+    #pragma omp parallel
+#endif
     {
-        // Move electrons and holes:
-        // For each single particle state in the configuration
-        auto particle_it = config_it->begin();
-        while(particle_it != config_it->end())
+        int thread_id = 0;
+#ifdef AMBIT_USE_OPENMP
+        thread_id = omp_get_thread_num();
+#endif
+        std::vector<RelativisticConfiguration>& accepted = thread_configs[thread_id];
+
+        // Every candidate seen by this thread, and whether it passed the filter.
+        std::unordered_map<RelativisticConfiguration, bool, ConfigurationHasher> candidates;
+
+        auto add_candidate = [&](const RelativisticConfiguration& new_config)
         {
-            // Electron or hole?
-            if(particle_it->second > 0)
+            if(old_set.count(new_config))
+                return;
+
+            auto inserted = candidates.insert(std::make_pair(new_config, false));
+            if(inserted.second && (!filter || filter(new_config)))
+            {   inserted.first->second = true;
+                accepted.push_back(new_config);
+            }
+        };
+
+        // Go through the set of initial configurations
+#ifdef AMBIT_USE_OPENMP
+        #pragma omp for schedule(dynamic)
+#endif
+        for(unsigned int i = 0; i < old_list.size(); i++)
+        {
+            const RelativisticConfiguration& config = old_list[i];
+            if(filter)
+                keep_old[i] = filter(config);
+
+            // Move electrons and holes:
+            // For each single particle state in the configuration
+            auto particle_it = config.begin();
+            while(particle_it != config.end())
             {
-                // Get another single particle state to move to
-                for(const auto& electron: electron_valence)
+                // Electron or hole?
+                if(particle_it->second > 0)
                 {
-                    if(electron.first != particle_it->first)
+                    // Get another single particle state to move to
+                    for(const auto& electron: electron_valence)
                     {
-                        RelativisticConfiguration new_config(*config_it);
-                        new_config.RemoveSingleParticle(particle_it->first);
-                        if(new_config.AddSingleParticle(electron.first))
-                            configlist->push_back(new_config);
+                        if(electron.first != particle_it->first)
+                        {
+                            RelativisticConfiguration new_config(config);
+                            new_config.RemoveSingleParticle(particle_it->first);
+                            if(new_config.AddSingleParticle(electron.first))
+                                add_candidate(new_config);
+                        }
                     }
                 }
-            }
-            else
-            {   // Get another single particle state to move to
-                for(const auto& hole: hole_valence)
-                {
-                    if(hole.first != particle_it->first)
+                else
+                {   // Get another single particle state to move to
+                    for(const auto& hole: hole_valence)
                     {
-                        RelativisticConfiguration new_config(*config_it);
-                        new_config.AddSingleParticle(particle_it->first);
-                        if(new_config.RemoveSingleParticle(hole.first))
-                            configlist->push_back(new_config);
+                        if(hole.first != particle_it->first)
+                        {
+                            RelativisticConfiguration new_config(config);
+                            new_config.AddSingleParticle(particle_it->first);
+                            if(new_config.RemoveSingleParticle(hole.first))
+                                add_candidate(new_config);
+                        }
                     }
                 }
-            }
 
-            particle_it++;
-        }
+                particle_it++;
+            }
 
-        // Pair creation
-        for(const auto& electron: electron_valence)
-        {
-            RelativisticConfiguration config_with_extra_electron(*config_it);
-            if(config_with_extra_electron.AddSingleParticle(electron.first))
+            // Pair creation
+            for(const auto& electron: electron_valence)
             {
-                for(const auto& hole: hole_valence)
+                RelativisticConfiguration config_with_extra_electron(config);
+                if(config_with_extra_electron.AddSingleParticle(electron.first))
                 {
-                    RelativisticConfiguration new_config(config_with_extra_electron);
-                    if(new_config.RemoveSingleParticle(hole.first))
-                        configlist->push_back(new_config);
+                    for(const auto& hole: hole_valence)
+                    {
+                        RelativisticConfiguration new_config(config_with_extra_electron);
+                        if(new_config.RemoveSingleParticle(hole.first))
+                            add_candidate(new_config);
+                    }
                 }
             }
-        }
-
-        // Pair annihilation
-        particle_it = config_it->begin();
-        while(particle_it != config_it->end())
-        {
-            auto other_particle_it = particle_it;
-            other_particle_it++;
 
-            while(other_particle_it != config_it->end())
+            // Pair annihilation
+            particle_it = config.begin();
+            while(particle_it != config.end())
             {
-                if((particle_it->second < 0) && (other_particle_it->second > 0))
-                {
-                    RelativisticConfiguration new_config(*config_it);
-                    new_config.AddSingleParticle(particle_it->first);
-                    new_config.RemoveSingleParticle(other_particle_it->first);
-                    configlist->push_back(new_config);
-                }
-                else if((particle_it->second > 0) && (other_particle_it->second < 0))
+                auto other_particle_it = particle_it;
+                other_particle_it++;
+
+                while(other_particle_it != config.end())
                 {
-                    RelativisticConfiguration new_config(*config_it);
-                    new_config.RemoveSingleParticle(particle_it->first);
-                    new_config.AddSingleParticle(other_particle_it->first);
-                    configlist->push_back(new_config);
+                    if((particle_it->second < 0) && (other_particle_it->second > 0))
+                    {
+                        RelativisticConfiguration new_config(config);
+                        new_config.AddSingleParticle(particle_it->first);
+                        new_config.RemoveSingleParticle(other_particle_it->first);
+                        add_candidate(new_config);
+                    }
+                    else if((particle_it->second > 0) && (other_particle_it->second < 0))
+                    {
+                        RelativisticConfiguration new_config(config);
+                        new_config.RemoveSingleParticle(particle_it->first);
+                        new_config.AddSingleParticle(other_particle_it->first);
+                        add_candidate(new_config);
+                    }
+
+                    other_particle_it++;
                 }
 
-                other_particle_it++;
+                particle_it++;
             }
-
-            particle_it++;
         }
+    }
 
-        config_it++;
+    // Rebuild list from surviving initial configurations and new ones.
+    // Different threads may have found the same configuration; these are removed by unique().
+    configlist->erase(configlist->begin(), configlist->end());
+    for(unsigned int i = 0; i < old_list.size(); i++)
+    {
+        if(keep_old[i])
+            configlist->push_back(std::move(old_list[i]));
+    }
+    for(auto& accepted: thread_configs)
+    {
+        for(auto& new_config: accepted)
+            configlist->push_back(std::move(new_config));
     }
 
     configlist->SetSmallSize(configlist->size());
@@ -535,14 +607,19 @@ void ConfigGenerator::GenerateProjections(pRelativisticConfigList rlist, const S
     if(rlist == nullptr || rlist->size() == 0)
         return;
 
-    // Get correct library
-    auto it = rlist->begin();
-    while(it != rlist->end())
+    // Projections of each configuration are independent; AngularDataLibrary::GetData() is thread-safe.
+    std::vector<RelativisticConfiguration*> config_pointers;
+    config_pointers.reserve(rlist->size());
+    for(auto& config: *rlist)
+        config_pointers.push_back(&config);
+
+    unsigned int i;
+#ifdef AMBIT_USE_OPENMP
+    #pragma omp parallel for private(i) schedule(dynamic)
+#endif
+    for(i = 0; i < config_pointers.size(); i++)
     {
-        if(it->GetProjections(angular_library, sym, two_m))
-            it++;
-        else
-            it = rlist->erase(it);
+        config_pointers[i]->GetProjections(angular_library, sym, two_m);
     }
 
     angular_library->GenerateCSFs();
@@ -550,14 +627,7 @@ void ConfigGenerator::GenerateProjections(pRelativisticConfigList rlist, const S
     // Write even if there are no CSFs for a given J since this is not so obvious
     angular_library->Write();
 
-    // Remove from list if there are no CSFs for a particular RelativisticConfiguration.
-    it = rlist->begin();
-    while(it != rlist->end())
-    {
-        if(it->NumCSFs())
-            it++;
-        else
-            it = rlist->erase(it);
-    }
+    // Remove from list if there are no projections or no CSFs for a particular RelativisticConfiguration.
+    rlist->remove_if([](const RelativisticConfiguration& config){ return config.NumCSFs() == 0; });
 }
 }
@@ -5,11 +5,13 @@
 #include "Basis/OrbitalManager.h"
 #include "NonRelConfiguration.h"
 #include "RelativisticConfigList.h"
+#include "ConfigurationAverageEnergy.h"
 #include "Projection.h"
 #include "HartreeFock/NonRelInfo.h"
 #include "Symmetry.h"
 #include "MBPT/OneElectronIntegrals.h"
 #include "MBPT/TwoElectronCoulombOperator.h"
+#include <functional>
 
 namespace Ambit
 {
@@ -73,10 +75,15 @@ protected:
      */
     pRelativisticConfigList ParseAndGenerateConfigurations(pHFIntegrals one_body = nullptr, pSlaterIntegrals two_body = nullptr);
 
+    /** Predicate that decides whether a configuration is kept in the list. */
+    typedef std::function<bool(const RelativisticConfiguration&)> ConfigurationFilter;
+
     /** Generate all configurations possible by exciting one electron of the original list.
         Append the new configurations to the list.
+        Candidates are deduplicated as they are generated and, if a filter is supplied, only
+        configurations passing the filter (including those of the original list) are kept.
      */
-    void GenerateExcitations(pRelativisticConfigList configlist, OrbitalMap& electron_valence, OrbitalMap& hole_valence) const;
+    void GenerateExcitations(pRelativisticConfigList configlist, OrbitalMap& electron_valence, OrbitalMap& hole_valence, const ConfigurationFilter& filter = nullptr) const;
 
 protected:
     // Inputs
@@ -199,3 +199,86 @@ TEST(ConfigGeneratorTester, NonSquare)
     EXPECT_EQ(5322, N);
     EXPECT_EQ(43, Nsmall);
 }
+
+TEST(ConfigGeneratorTester, ConfigurationAverageEnergy)
+{
+    pLattice lattice(new Lattice(1000, 1.e-6, 50.));
+
+    // CuIII
+    std::string user_input_string = std::string() +
+        "NuclearRadius = 3.7188\n" +
+        "NuclearThickness = 2.3\n" +
+        "Z = 29\n" +
+        "[HF]\n" +
+        "N = 28\n" +
+        "Configuration = '1s2 2s2 2p6 3s2 3p6 3d10'\n" +
+        "[Basis]\n" +
+        "--bspline-basis\n" +
+        "ValenceBasis = 4spd\n" +
+        "FrozenCore = 3s\n" +
+        "BSpline/Rmax = 50.0\n" +
+        "[CI]\n" +
+        "LeadingConfigurations = '3d-2'\n" +
+        "ElectronExcitations = 1\n" +
+        "HoleExcitations = 1\n";
+
+    std::stringstream user_input_stream(user_input_string);
+    MultirunOptions userInput(user_input_stream, "//", "\n", ",");
+
+    // Get core and excited basis
+    BasisGenerator basis_generator(lattice, userInput);
+    basis_generator.GenerateHFCore();
+    pOrbitalManagerConst orbitals = basis_generator.GenerateBasis();
+
+    // Generate integrals
+    pHFOperator hf = basis_generator.GetClosedHFOperator();
+    pHFIntegrals hf_electron(new HFIntegrals(orbitals, hf));
+    hf_electron->CalculateOneElectronIntegrals(orbitals->valence, orbitals->valence);
+
+    pCoulombOperator coulomb(new CoulombOperator(lattice));
+    pHartreeY hartreeY(new HartreeY(hf->GetIntegrator(), coulomb));
+    pSlaterIntegrals integrals(new SlaterIntegralsMap(orbitals, hartreeY));
+    integrals->CalculateTwoElectronIntegrals(orbitals->valence, orbitals->valence, orbitals->valence, orbitals->valence);
+
+    ConfigGenerator gen(orbitals, userInput);
+    pRelativisticConfigList relconfigs = gen.GenerateConfigurations();
+    ConfigurationAverageEnergy average_energy(orbitals->valence, hf_electron, integrals);
+
+    for(const auto& config: *relconfigs)
+    {
+        double energy = average_energy.GetEnergy(config);
+        EXPECT_NEAR(config.CalculateConfigurationAverageEnergy(orbitals->valence, hf_electron, integrals), energy, 1.e-10);
+
+        // Incremental energies of moving an electron (hole) to another orbital
+        for(const auto& particle: config)
+        {
+            for(const auto& orbital: *orbitals->valence)
+            {
+                RelativisticConfiguration new_config(config);
+                bool allowed;
+                double change;
+                if(particle.second > 0)
+                {   new_config.RemoveSingleParticle(particle.first);
+                    allowed = new_config.AddSingleParticle(orbital.first);
+                    change = average_energy.GetExcitationEnergy(config, particle.first, orbital.first);
+                }
+                else
+                {   new_config.AddSingleParticle(particle.first);
+                    allowed = new_config.RemoveSingleParticle(orbital.first);
+                    change = average_energy.GetExcitationEnergy(config, orbital.first, particle.first);
+                }
+
+                if(allowed)
+                {   EXPECT_NEAR(average_energy.GetEnergy(new_config) - energy, change, 1.e-10);
+                }
+            }
+        }
+    }
+
+    // Orbitals outside the valence set are ignored
+    const RelativisticConfiguration& config = relconfigs->front();
+    RelativisticConfiguration with_core(config);
+    with_core.AddSingleParticle(OrbitalInfo(2, 1));
+    EXPECT_NEAR(average_energy.GetEnergy(config), average_energy.GetEnergy(with_core), 1.e-10);
+    EXPECT_EQ(0., average_energy.GetEnergyChange(with_core, OrbitalInfo(2, 1), 1));
+}
@@ -0,0 +1,55 @@
+#include "Include.h"
+#include "ConfigurationAverageEnergy.h"
+#include "Universal/MathConstant.h"
+
+namespace Ambit
+{
+ConfigurationAverageEnergy::ConfigurationAverageEnergy(pOrbitalMapConst orbitals, pHFIntegrals one_body, pSlaterIntegrals two_body)
+{
+    std::vector<OrbitalInfo> infos;
+    for(const auto& pair: *orbitals)
+    {
+        index[pair.first] = infos.size();
+        infos.push_back(pair.first);
+    }
+
+    num_orbitals = infos.size();
+    one_body_energy.resize(num_orbitals);
+    self_factor.resize(num_orbitals);
+    pair_energy.resize(num_orbitals * num_orbitals);
+
+    MathConstant* math = MathConstant::Instance();
+
+    for(unsigned int i = 0; i < num_orbitals; i++)
+    {
+        const OrbitalInfo& a = infos[i];
+        one_body_energy[i] = one_body->GetMatrixElement(a, a);
+        self_factor[i] = a.MaxNumElectrons()/double(a.MaxNumElectrons() - 1.);
+
+        for(unsigned int j = i; j < num_orbitals; j++)
+        {
+            const OrbitalInfo& b = infos[j];
+
+            // R^0_abab
+            double U_ab = two_body->GetTwoElectronIntegral(0, a, b, a, b);
+
+            // Sum_l R^k_abba (j_a  j_b k)^2 \xi(l_a + l_b + k)
+            //                (1/2 -1/2 0)
+            int k = abs(a.TwoJ() - b.TwoJ())/2;
+            if((a.L() + b.L() + k)%2)
+                k++;
+            int kmax = (a.TwoJ() + b.TwoJ())/2;
+            while(k <= kmax)
+            {
+                double threej = math->Electron3j(a.TwoJ(), b.TwoJ(), k);
+                U_ab -= threej * threej * two_body->GetTwoElectronIntegral(k, a, b, b, a);
+
+                k += 2;
+            }
+
+            pair_energy[i * num_orbitals + j] = U_ab;
+            pair_energy[j * num_orbitals + i] = U_ab;
+        }
+    }
+}
+}
@@ -0,0 +1,144 @@
+#ifndef CONFIGURATION_AVERAGE_ENERGY_H
+#define CONFIGURATION_AVERAGE_ENERGY_H
+
+#include "HartreeFock/Configuration.h"
+#include "HartreeFock/OrbitalInfo.h"
+#include "HartreeFock/OrbitalMap.h"
+#include "Basis/OrbitalManager.h"
+#include "MBPT/OneElectronIntegrals.h"
+#include "MBPT/SlaterIntegrals.h"
+#include <vector>
+
+namespace Ambit
+{
+/** Evaluate configuration average energies without radial integral lookups.
+    The configuration average energy is a quadratic form in the occupation numbers
+        \f[ E = \sum_a n_a \epsilon_a + \sum_a w_a U_{aa} + \sum_{a<b} n_a n_b U_{ab} \f]
+    with
+        \f[ U_{ab} = R^0_{abab} - \sum_k \left( \begin{array}{ccc} j_a & j_b & k \\
+                                                   1/2 & -1/2 & 0 \end{array} \right)^2 R^k_{abba} \f]
+    and \f$ w_a = n_a(n_a - 1)/2 \cdot g_a/(g_a - 1) \f$ for electrons
+    (\f$ n_a(n_a + 1)/2 \cdot g_a/(g_a - 1) \f$ for holes).
+    The \f$ \epsilon_a \f$ and \f$ U_{ab} \f$ are calculated once for all orbitals in the constructor,
+    after which each configuration costs O(N^2) in the number of occupied orbitals,
+    and single occupancy changes cost O(N).
+    All functions are const and hence safe to call from multiple threads.
+ */
+class ConfigurationAverageEnergy
+{
+public:
+    ConfigurationAverageEnergy(pOrbitalMapConst orbitals, pHFIntegrals one_body, pSlaterIntegrals two_body);
+    virtual ~ConfigurationAverageEnergy() = default;
+
+    /** Configuration average energy; equivalent to CalculateConfigurationAverageEnergy().
+        Orbitals that were not given to the constructor are ignored, as though their integrals were zero.
+     */
+    template<class OccupancyType>
+    double GetEnergy(const Configuration<OrbitalInfo, OccupancyType>& config) const;
+
+    /** Change in configuration average energy when the occupancy of orbital in config changes by delta. */
+    template<class OccupancyType>
+    double GetEnergyChange(const Configuration<OrbitalInfo, OccupancyType>& config, const OrbitalInfo& orbital, OccupancyType delta) const;
+
+    /** Change in configuration average energy when a single electron is moved from orbital "from" to orbital "to"
+        (equivalently, a hole is moved from "to" to "from").
+     */
+    template<class OccupancyType>
+    double GetExcitationEnergy(const Configuration<OrbitalInfo, OccupancyType>& config, const OrbitalInfo& from, const OrbitalInfo& to) const;
+
+protected:
+    /** Pair weight w_a for orbital index i with occupancy n. */
+    template<class OccupancyType>
+    inline double GetSelfWeight(unsigned int i, OccupancyType n) const
+    {   if(n > 0)
+            return n * (n - 1)/2. * self_factor[i];
+        else
+            return n * (n + 1)/2. * self_factor[i];
+    }
+
+    inline double GetPairEnergy(unsigned int i, unsigned int j) const { return pair_energy[i * num_orbitals + j]; }
+
+    OrbitalIndex index;                 //!< Index of orbital in tables
+    unsigned int num_orbitals;
+    std::vector<double> one_body_energy;    //!< epsilon_a
+    std::vector<double> self_factor;        //!< g_a/(g_a - 1)
+    std::vector<double> pair_energy;        //!< U_ab (symmetric, num_orbitals * num_orbitals)
+};
+
+typedef std::shared_ptr<ConfigurationAverageEnergy> pConfigurationAverageEnergy;
+typedef std::shared_ptr<const ConfigurationAverageEnergy> pConfigurationAverageEnergyConst;
+
+template<class OccupancyType>
+double ConfigurationAverageEnergy::GetEnergy(const Configuration<OrbitalInfo, OccupancyType>& config) const
+{
+    // Table index and occupancy of each known orbital
+    std::vector<std::pair<unsigned int, OccupancyType>> occupied;
+    occupied.reserve(config.size());
+    for(const auto& pair: config)
+    {
+        auto found = index.find(pair.first);
+        if(found != index.end())
+            occupied.push_back(std::make_pair(found->second, pair.second));
+    }
+
+    double energy = 0.;
+    for(auto it_a = occupied.begin(); it_a != occupied.end(); it_a++)
+    {
+        unsigned int i = it_a->first;
+        energy += it_a->second * one_body_energy[i] + GetSelfWeight(i, it_a->second) * GetPairEnergy(i, i);
+
+        for(auto it_b = std::next(it_a); it_b != occupied.end(); it_b++)
+            energy += it_a->second * it_b->second * GetPairEnergy(i, it_b->first);
+    }
+
+    return energy;
+}
+
+template<class OccupancyType>
+double ConfigurationAverageEnergy::GetEnergyChange(const Configuration<OrbitalInfo, OccupancyType>& config, const OrbitalInfo& orbital, OccupancyType delta) const
+{
+    const OrbitalInfo info(orbital.PQN(), orbital.Kappa());
+    auto found = index.find(info);
+    if(found == index.end())
+        return 0.;
+
+    unsigned int i = found->second;
+    OccupancyType n = config.GetOccupancy(info);
+
+    double change = delta * one_body_energy[i]
+                    + (GetSelfWeight(i, n + delta) - GetSelfWeight(i, n)) * GetPairEnergy(i, i);
+
+    for(const auto& pair: config)
+    {
+        if(pair.first != info)
+        {   auto found_other = index.find(pair.first);
+            if(found_other != index.end())
+                change += delta * pair.second * GetPairEnergy(i, found_other->second);
+        }
+    }
+
+    return change;
+}
+
+template<class OccupancyType>
+double ConfigurationAverageEnergy::GetExcitationEnergy(const Configuration<OrbitalInfo, OccupancyType>& config, const OrbitalInfo& from, const OrbitalInfo& to) const
+{
+    const OrbitalInfo info_from(from.PQN(), from.Kappa());
+    const OrbitalInfo info_to(to.PQN(), to.Kappa());
+    if(info_from == info_to)
+        return 0.;
+
+    // Remove from "from", then add to "to" in the modified configuration:
+    // the only extra term relative to two independent changes is the (from, to) pair interaction.
+    double change = GetEnergyChange(config, info_from, OccupancyType(-1)) + GetEnergyChange(config, info_to, OccupancyType(1));
+
+    auto found_from = index.find(info_from);
+    auto found_to = index.find(info_to);
+    if(found_from != index.end() && found_to != index.end())
+        change -= GetPairEnergy(found_from->second, found_to->second);
+
+    return change;
+}
+
+}
+#endif
@@ -243,7 +243,7 @@ void HamiltonianMatrix::GenerateMatrix(unsigned int configs_per_chunk)
         matrix_section.Symmetrize();
 }
 
-LevelVector HamiltonianMatrix::SolveMatrix(pHamiltonianID hID, unsigned int num_solutions)
+LevelVector HamiltonianMatrix::SolveMatrix(pHamiltonianID hID, unsigned int num_solutions, const LevelVector* initial_guess)
 {
     LevelVector levelvec(hID);
     levelvec.configs = configs;
@@ -282,11 +282,30 @@ LevelVector HamiltonianMatrix::SolveMatrix(pHamiltonianID hID, unsigned int num_
             double* V = new double[NumSolutions * N];
             double* E = new double[NumSolutions];
 
+            // Start from eigenvectors of initial_guess if they are in the same CSF basis
+            unsigned int num_initial_vectors = 0;
+            if(initial_guess && initial_guess->configs
+               && initial_guess->configs->size() == configs->size()
+               && initial_guess->configs->NumCSFs() == N
+               && std::equal(configs->begin(), configs->end(), initial_guess->configs->begin()))
+            {
+                num_initial_vectors = mmin(NumSolutions, initial_guess->levels.size());
+                for(unsigned int i = 0; i < num_initial_vectors; i++)
+                {
+                    const std::vector<double>& eigenvector = initial_guess->levels[i]->GetEigenvector();
+                    if(eigenvector.size() != N)
+                    {   num_initial_vectors = i;
+                        break;
+                    }
+                    std::copy(eigenvector.begin(), eigenvector.end(), V + N * i);
+                }
+            }
+
             Eigensolver solver;
             #ifdef AMBIT_USE_MPI
-                solver.MPISolveLargeSymmetric(this, E, V, N, NumSolutions);
+                solver.MPISolveLargeSymmetric(this, E, V, N, NumSolutions, num_initial_vectors);
             #else
-                solver.SolveLargeSymmetric(this, E, V, N, NumSolutions);
+                solver.SolveLargeSymmetric(this, E, V, N, NumSolutions, num_initial_vectors);
             #endif
 
             for(unsigned int i = 0; i < NumSolutions; i++)
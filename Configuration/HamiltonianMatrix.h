@@ -50,8 +50,11 @@ public:
     /** Return proportion of elements that have magnitude greater than epsilon. */
     virtual double PollMatrix(double epsilon = 1.e-15) const;
 
-    /** Solve the matrix that has been generated. Note that this may destroy the matrix. */
-    virtual LevelVector SolveMatrix(pHamiltonianID hID, unsigned int num_solutions);
+    /** Solve the matrix that has been generated. Note that this may destroy the matrix.
+        If initial_guess has the same configurations (e.g. from a similar calculation in another run),
+        its eigenvectors are used as starting vectors for the Davidson method.
+     */
+    virtual LevelVector SolveMatrix(pHamiltonianID hID, unsigned int num_solutions, const LevelVector* initial_guess = nullptr);
 
 #ifdef AMBIT_USE_SCALAPACK
     /** Solve using ScaLAPACK. Note that this destroys the matrix.
@@ -674,3 +674,83 @@ TEST(HamiltonianMatrixTester, NonStretchedStates)
         }
     }
 }
+
+TEST(HamiltonianMatrixTester, WarmStart)
+{
+    pLattice lattice(new Lattice(1000, 1.e-6, 50.));
+
+    // MgI
+    std::string user_input_string = std::string() +
+        "NuclearRadius = 3.7188\n" +
+        "NuclearThickness = 2.3\n" +
+        "Z = 12\n" +
+        "[HF]\n" +
+        "N = 10\n" +
+        "Configuration = '1s2 2s2 2p6'\n" +
+        "[Basis]\n" +
+        "--bspline-basis\n" +
+        "ValenceBasis = 8spdf\n" +
+        "BSpline/Rmax = 45.0\n" +
+        "[CI]\n" +
+        "LeadingConfigurations = '3s2, 3s1 3p1'\n" +
+        "ElectronExcitations = 2\n";
+
+    std::stringstream user_input_stream(user_input_string);
+    MultirunOptions userInput(user_input_stream, "//", "\n", ",");
+
+    // Get core and excited basis
+    BasisGenerator basis_generator(lattice, userInput);
+    pCore core = basis_generator.GenerateHFCore();
+    pOrbitalManagerConst orbitals = basis_generator.GenerateBasis();
+
+    // Generate integrals
+    pHFOperator hf = basis_generator.GetClosedHFOperator();
+    pHFIntegrals hf_electron(new HFIntegrals(orbitals, hf));
+    hf_electron->CalculateOneElectronIntegrals(orbitals->valence, orbitals->valence);
+
+    pCoulombOperator coulomb(new CoulombOperator(lattice));
+    pHartreeY hartreeY(new HartreeY(hf->GetIntegrator(), coulomb));
+    pSlaterIntegrals integrals(new SlaterIntegralsMap(orbitals, hartreeY));
+    integrals->CalculateTwoElectronIntegrals(orbitals->valence, orbitals->valence, orbitals->valence, orbitals->valence);
+    pTwoElectronCoulombOperator twobody_electron = std::make_shared<TwoElectronCoulombOperator>(integrals);
+
+    ConfigGenerator config_generator(orbitals, userInput);
+    pAngularDataLibrary angular_library = std::make_shared<AngularDataLibrary>();
+    Symmetry sym(2, Parity::odd);
+    pHamiltonianID key = std::make_shared<HamiltonianID>(sym);
+
+    auto configs = config_generator.GenerateConfigurations();
+    pRelativisticConfigList relconfigs = config_generator.GenerateRelativisticConfigurations(configs, sym, angular_library);
+    ASSERT_GT(relconfigs->NumCSFs(), 200);     // Large enough to use Davidson method
+
+    HamiltonianMatrix H_cold(hf_electron, twobody_electron, relconfigs);
+    H_cold.GenerateMatrix();
+    LevelVector cold_levels = H_cold.SolveMatrix(key, 4);
+    ASSERT_EQ(4, cold_levels.levels.size());
+
+    // Second calculation in an identical CSF basis, starting from the first solutions
+    pRelativisticConfigList relconfigs_copy = std::make_shared<RelativisticConfigList>(*relconfigs);
+    HamiltonianMatrix H_warm(hf_electron, twobody_electron, relconfigs_copy);
+    H_warm.GenerateMatrix();
+    LevelVector warm_levels = H_warm.SolveMatrix(key, 4, &cold_levels);
+    ASSERT_EQ(4, warm_levels.levels.size());
+
+    // Incomplete starting guess must be filled up
+    LevelVector partial_guess(key, relconfigs, cold_levels.levels[0]);
+    LevelVector partial_levels = H_warm.SolveMatrix(key, 4, &partial_guess);
+    ASSERT_EQ(4, partial_levels.levels.size());
+
+    unsigned int N = relconfigs->NumCSFs();
+    for(unsigned int i = 0; i < 4; i++)
+    {
+        EXPECT_NEAR(cold_levels.levels[i]->GetEnergy(), warm_levels.levels[i]->GetEnergy(), 1.e-10);
+        EXPECT_NEAR(cold_levels.levels[i]->GetEnergy(), partial_levels.levels[i]->GetEnergy(), 1.e-10);
+
+        const std::vector<double>& cold = cold_levels.levels[i]->GetEigenvector();
+        const std::vector<double>& warm = warm_levels.levels[i]->GetEigenvector();
+        double overlap = 0.;
+        for(unsigned int j = 0; j < N; j++)
+            overlap += cold[j] * warm[j];
+        EXPECT_NEAR(1., fabs(overlap), 1.e-6);
+    }
+}
@@ -3,6 +3,10 @@
 #include "Universal/MathConstant.h"
 #include "NonRelConfiguration.h"
 
+#ifdef AMBIT_USE_OPENMP
+#include <omp.h>
+#endif
+
 namespace Ambit
 {
 HamiltonianID::HamiltonianID(const std::string& name):
@@ -57,9 +61,57 @@ void HamiltonianID::Read(FILE* fp)
 }
 
 Level::Level(const double& energy, const double* csf_eigenvector, pHamiltonianID hamiltonian_id, unsigned int numCSFs):
-    eigenvalue(energy), eigenvector(numCSFs), hamiltonian(hamiltonian_id)
+    eigenvalue(energy), eigenvector(numCSFs), num_CSFs(numCSFs), hamiltonian(hamiltonian_id)
 {
     memcpy(eigenvector.data(), csf_eigenvector, numCSFs * sizeof(double));
     gFactor = std::numeric_limits<double>::quiet_NaN();
 }
+
+const std::vector<double>& Level::GetEigenvector() const
+{
+    if(eigenvector_loader)
+    {
+    #ifdef AMBIT_USE_OPENMP
+        #pragma omp critical(LEVEL_EIGENVECTOR)
+    #endif
+        if(eigenvector.empty() && num_CSFs)
+        {
+            std::vector<double> loaded;
+            eigenvector_loader(loaded);
+            eigenvector.swap(loaded);
+        }
+    }
+
+    return eigenvector;
+}
+
+void Level::ReleaseEigenvector() const
+{
+#ifdef AMBIT_USE_OPENMP
+    // Other threads may hold references from GetEigenvector()
+    if(omp_in_parallel())
+        return;
+#endif
+
+    if(eigenvector_loader)
+    {
+    #ifdef AMBIT_USE_OPENMP
+        #pragma omp critical(LEVEL_EIGENVECTOR)
+    #endif
+        {   std::vector<double> empty;
+            eigenvector.swap(empty);
+            norm_loss = loader_norm_loss;
+        }
+    }
+}
+
+void Level::SetEigenvectorLoader(EigenvectorLoader loader, double eigenvector_norm_loss)
+{
+    eigenvector_loader = loader;
+    loader_norm_loss = eigenvector_norm_loss;
+
+    // Eigenvector held in memory (e.g. straight from the solver) is unchanged
+    if(eigenvector.empty())
+        norm_loss = loader_norm_loss;
+}
 }
@@ -5,6 +5,7 @@
 #include "RelativisticConfigList.h"
 #include "Universal/Enums.h"
 #include <boost/iterator/filter_iterator.hpp>
+#include <functional>
 
 namespace Ambit
 {
@@ -64,27 +65,61 @@ inline std::ostream& operator<<(std::ostream& stream, const pHamiltonianID& hID)
 {   return stream << hID->Print();
 }
 
+/** Function that fills the eigenvector of a Level on request (e.g. by reading it from file). */
+typedef std::function<void(std::vector<double>&)> EigenvectorLoader;
+
 /** A Level is an eigenstate of the Hamiltonian with eigenvector of length NumCSFs.
     The symmetry of the eigenstate is given by the stored HamiltonianID.
+    The eigenvector may be held in memory or, if an EigenvectorLoader is provided, loaded on
+    first request by GetEigenvector() and released again with ReleaseEigenvector().
  */
 class Level : public std::enable_shared_from_this<Level>
 {
 public:
     /** Initialise Level with energy eigenvalue, eigenvector, and pointer to relativistic configurations (CSFs).
+        norm_loss is the norm, sqrt(sum of squares), of any coefficients already missing from csf_eigenvector.
         PRE: length(csf_eigenvector) == configlist->NumCSFs() == numCSFs (if supplied).
      */
-    Level(const double& energy, const std::vector<double>& csf_eigenvector, pHamiltonianID hamiltonian_id, const double& gFactor):
-        eigenvalue(energy), eigenvector(csf_eigenvector), hamiltonian(hamiltonian_id), gFactor(gFactor) {}
+    Level(const double& energy, const std::vector<double>& csf_eigenvector, pHamiltonianID hamiltonian_id, const double& gFactor, double norm_loss = 0.):
+        eigenvalue(energy), eigenvector(csf_eigenvector), num_CSFs(csf_eigenvector.size()), hamiltonian(hamiltonian_id), gFactor(gFactor),
+        norm_loss(norm_loss), loader_norm_loss(norm_loss) {}
     Level(const double& energy, const double* csf_eigenvector, pHamiltonianID hamiltonian_id, unsigned int numCSFs);
 
+    /** Initialise Level whose eigenvector is not loaded until it is needed.
+        norm_loss is the norm, sqrt(sum of squares), of any eigenvector coefficients discarded in storage.
+     */
+    Level(const double& energy, unsigned int numCSFs, EigenvectorLoader loader, pHamiltonianID hamiltonian_id, const double& gFactor, double norm_loss = 0.):
+        eigenvalue(energy), num_CSFs(numCSFs), eigenvector_loader(loader), hamiltonian(hamiltonian_id), gFactor(gFactor),
+        norm_loss(norm_loss), loader_norm_loss(norm_loss) {}
+
     double GetEnergy() const { return eigenvalue; }
     void SetEnergy(double energy) { eigenvalue = energy; }
 
     double GetgFactor() const { return gFactor; }
     void SetgFactor(double g_factor) { gFactor = g_factor; }
 
-    const std::vector<double>& GetEigenvector() const { return eigenvector; }
-    unsigned int GetEigenvectorLength() const { return eigenvector.size(); }     //!< Eigenvector length = NumCSFs
+    /** Get eigenvector, loading it first if required. Safe to call from several threads at once.
+        The reference remains valid until ReleaseEigenvector() is called.
+     */
+    const std::vector<double>& GetEigenvector() const;
+    unsigned int GetEigenvectorLength() const { return num_CSFs; }     //!< Eigenvector length = NumCSFs
+
+    /** Free memory used by eigenvector. Only has effect if it can be loaded again, and only outside
+        OpenMP parallel regions, so that no other thread can be holding a reference from GetEigenvector().
+     */
+    void ReleaseEigenvector() const;
+    bool EigenvectorLoaded() const { return num_CSFs == 0 || !eigenvector.empty(); }
+
+    /** Set source of eigenvector for subsequent loading (replacing any previous source).
+        eigenvector_norm_loss is the norm loss of the eigenvector provided by loader. An eigenvector
+        already held in memory keeps its own norm loss until it is released.
+     */
+    void SetEigenvectorLoader(EigenvectorLoader loader, double eigenvector_norm_loss = 0.);
+
+    /** Norm, sqrt(sum of squares), of coefficients lost in storage (e.g. by truncation of small
+        coefficients) from the eigenvector returned by GetEigenvector().
+     */
+    double GetNormLoss() const { return norm_loss; }
 
     Parity GetParity() const { return hamiltonian->GetParity(); }
     unsigned int GetTwoJ() const { return hamiltonian->GetTwoJ(); }
@@ -94,9 +129,13 @@ public:
 
 protected:
     double eigenvalue;
-    std::vector<double> eigenvector;        // length of eigenvector = hamiltonian->configs->NumCSFs()
+    mutable std::vector<double> eigenvector;    // length of eigenvector = hamiltonian->configs->NumCSFs()
+    unsigned int num_CSFs;
+    EigenvectorLoader eigenvector_loader;   // source of eigenvector if not held in memory
     pHamiltonianID hamiltonian = nullptr;   // identifier for the Hamiltonian that *this is an eigenvalue of
     double gFactor = std::numeric_limits<double>::quiet_NaN();
+    mutable double norm_loss = 0.;          // of eigenvector, whether held or still to be loaded
+    double loader_norm_loss = 0.;           // of eigenvector provided by eigenvector_loader
 };
 
 typedef std::shared_ptr<Level> pLevel;
@@ -1,9 +1,193 @@
 #include "LevelMap.h"
 #include "Include.h"
 #include <thread>
+#include <cstdio>
+#ifdef AMBIT_USE_MPI
+    #include <mpi.h>
+#endif
 
 namespace Ambit
 {
+/** Eigenvector storage on file:
+        - (unsigned int) N, with EIGENVECTOR_COMPRESSED_FLAG set if compressed
+        - uncompressed: (double) coefficients * N
+        - compressed:   (unsigned int) bytes per coefficient (4 or 8)
+                        (unsigned int) number of coefficients stored = M
+                        (double) norm of discarded coefficients
+                        (unsigned int) indices * M (only if M < N)
+                        (float or double) coefficients * M
+ */
+static const unsigned int EIGENVECTOR_COMPRESSED_FLAG = 0x80000000;
+
+long LevelStore::WriteLevel(FILE* fp, const Level& level, double& norm_loss) const
+{
+    double eigenvalue = level.GetEnergy();
+    double gfactor = level.GetgFactor();
+
+    file_err_handler->fwrite(&eigenvalue, sizeof(double), 1, fp);
+    long offset = WriteEigenvector(fp, level, norm_loss);
+    file_err_handler->fwrite(&gfactor, sizeof(double), 1, fp);
+
+    return offset;
+}
+
+long LevelStore::WriteEigenvector(FILE* fp, const Level& level, double& norm_loss) const
+{
+    const std::vector<double>& eigenvector = level.GetEigenvector();
+    unsigned int N = eigenvector.size();
+    long offset = ftell(fp);
+
+    // Loss already missing from the eigenvector in memory: zero if it came straight from the solver,
+    // even if it has been written before.
+    norm_loss = level.GetNormLoss();
+    double squared_norm_loss = norm_loss * norm_loss;
+
+    if(!float_eigenvectors && eigenvector_truncation <= 0.)
+    {
+        file_err_handler->fwrite(&N, sizeof(unsigned int), 1, fp);
+        file_err_handler->fwrite(eigenvector.data(), sizeof(double), N, fp);
+    }
+    else
+    {
+        std::vector<unsigned int> indices;
+        std::vector<double> values;
+        for(unsigned int i = 0; i < N; i++)
+        {
+            if(fabs(eigenvector[i]) >= eigenvector_truncation)
+            {   indices.push_back(i);
+                values.push_back(eigenvector[i]);
+            }
+            else
+                squared_norm_loss += eigenvector[i] * eigenvector[i];
+        }
+        norm_loss = sqrt(squared_norm_loss);
+
+        unsigned int flagged_N = N | EIGENVECTOR_COMPRESSED_FLAG;
+        unsigned int bytes = (float_eigenvectors? sizeof(float): sizeof(double));
+        unsigned int num_stored = values.size();
+
+        file_err_handler->fwrite(&flagged_N, sizeof(unsigned int), 1, fp);
+        file_err_handler->fwrite(&bytes, sizeof(unsigned int), 1, fp);
+        file_err_handler->fwrite(&num_stored, sizeof(unsigned int), 1, fp);
+        file_err_handler->fwrite(&norm_loss, sizeof(double), 1, fp);
+        if(num_stored < N)
+            file_err_handler->fwrite(indices.data(), sizeof(unsigned int), num_stored, fp);
+
+        if(float_eigenvectors)
+        {   std::vector<float> float_values(values.begin(), values.end());
+            file_err_handler->fwrite(float_values.data(), sizeof(float), num_stored, fp);
+        }
+        else
+            file_err_handler->fwrite(values.data(), sizeof(double), num_stored, fp);
+    }
+
+    return offset;
+}
+
+pLevel LevelStore::ReadLevel(FILE* fp, pHamiltonianID key, const std::string& lazy_filename)
+{
+    double eigenvalue;
+    double gfactor;
+    double norm_loss;
+    pLevel level;
+
+    file_err_handler->fread(&eigenvalue, sizeof(double), 1, fp);
+
+    if(lazy_filename.empty())
+    {
+        std::vector<double> eigenvector;
+        ReadEigenvector(fp, &eigenvector, norm_loss);
+        file_err_handler->fread(&gfactor, sizeof(double), 1, fp);
+
+        level = std::make_shared<Level>(eigenvalue, eigenvector, key, gfactor, norm_loss);
+    }
+    else
+    {
+        long offset = ftell(fp);
+        unsigned int N = ReadEigenvector(fp, nullptr, norm_loss);
+        file_err_handler->fread(&gfactor, sizeof(double), 1, fp);
+
+        level = std::make_shared<Level>(eigenvalue, N, FileEigenvectorLoader(lazy_filename, offset), key, gfactor, norm_loss);
+    }
+
+    return level;
+}
+
+unsigned int LevelStore::ReadEigenvector(FILE* fp, std::vector<double>* eigenvector, double& norm_loss)
+{
+    unsigned int N;
+    file_err_handler->fread(&N, sizeof(unsigned int), 1, fp);
+    norm_loss = 0.;
+
+    if(!(N & EIGENVECTOR_COMPRESSED_FLAG))
+    {
+        if(eigenvector)
+        {   eigenvector->resize(N);
+            file_err_handler->fread(eigenvector->data(), sizeof(double), N, fp);
+        }
+        else
+            fseek(fp, long(N) * sizeof(double), SEEK_CUR);
+
+        return N;
+    }
+
+    N &= ~EIGENVECTOR_COMPRESSED_FLAG;
+    unsigned int bytes, num_stored;
+    file_err_handler->fread(&bytes, sizeof(unsigned int), 1, fp);
+    file_err_handler->fread(&num_stored, sizeof(unsigned int), 1, fp);
+    file_err_handler->fread(&norm_loss, sizeof(double), 1, fp);
+
+    if(!eigenvector)
+    {   long size = long(num_stored) * bytes;
+        if(num_stored < N)
+            size += long(num_stored) * sizeof(unsigned int);
+        fseek(fp, size, SEEK_CUR);
+        return N;
+    }
+
+    std::vector<unsigned int> indices;
+    if(num_stored < N)
+    {   indices.resize(num_stored);
+        file_err_handler->fread(indices.data(), sizeof(unsigned int), num_stored, fp);
+    }
+
+    std::vector<double> values(num_stored);
+    if(bytes == sizeof(float))
+    {   std::vector<float> float_values(num_stored);
+        file_err_handler->fread(float_values.data(), sizeof(float), num_stored, fp);
+        std::copy(float_values.begin(), float_values.end(), values.begin());
+    }
+    else
+        file_err_handler->fread(values.data(), sizeof(double), num_stored, fp);
+
+    eigenvector->assign(N, 0.);
+    if(num_stored < N)
+    {   for(unsigned int i = 0; i < num_stored; i++)
+            (*eigenvector)[indices[i]] = values[i];
+    }
+    else
+        eigenvector->swap(values);
+
+    return N;
+}
+
+EigenvectorLoader LevelStore::FileEigenvectorLoader(const std::string& filename, long offset)
+{
+    return [filename, offset](std::vector<double>& eigenvector)
+    {
+        FILE* fp = file_err_handler->fopen(filename.c_str(), "rb");
+        if(!fp)
+        {   *errstream << "LevelStore: cannot open " << filename << " to read eigenvector." << std::endl;
+            exit(1);
+        }
+
+        double norm_loss;
+        fseek(fp, offset, SEEK_SET);
+        ReadEigenvector(fp, &eigenvector, norm_loss);
+        file_err_handler->fclose(fp);
+    };
+}
+
 LevelMap::LevelMap(pAngularDataLibrary lib): angular_library(lib) {}
 
 LevelMap::LevelMap(const std::string& file_id, pAngularDataLibrary lib):
@@ -19,64 +203,337 @@ LevelMap::LevelMap(pHamiltonianIDConst hamiltonian_example, const std::string& f
 LevelVector LevelMap::GetLevels(pHamiltonianID key)
 {
     auto it = m_map.find(key);
-    if(it == m_map.end())
-        return LevelVector(key);
-    else
+    if(it != m_map.end())
         return it->second;
+
+    auto index_it = index.find(key);
+    if(index_it == index.end())
+        return LevelVector(key);
+
+    // Read configs from indexed file; eigenvectors are only read when needed
+    std::string filename = filename_prefix + ".levels";
+    FILE* fp = file_err_handler->fopen(filename.c_str(), "rb");
+    if(!fp)
+        return LevelVector(key);
+
+    pHamiltonianID read_key = index_it->first;
+    IndexEntry& entry = index_it->second;
+    LevelVector& levelvec = m_map[read_key];
+    levelvec.hID = read_key;
+    levelvec.configs = std::make_shared<RelativisticConfigList>();
+
+    fseek(fp, entry.configs_offset, SEEK_SET);
+    levelvec.configs->Read(fp);
+    file_err_handler->fclose(fp);
+
+    for(auto& relconfig: *levelvec.configs)
+        relconfig.GetProjections(angular_library, read_key->GetSymmetry(), read_key->GetTwoJ());
+
+    // These should be generated already, but in case they weren't saved...
+    angular_library->GenerateCSFs();
+
+    levelvec.levels.reserve(entry.levels.size());
+    for(const auto& level_index: entry.levels)
+    {
+        EigenvectorLoader loader = FileEigenvectorLoader(filename, level_index.eigenvector_offset);
+        levelvec.levels.push_back(std::make_shared<Level>(level_index.energy, entry.num_CSFs, loader, read_key, level_index.gfactor, level_index.norm_loss));
+    }
+    entry.written_levels = levelvec.levels;
+
+    return levelvec;
 }
 
+/** Indexed .levels file header:
+        - (char[8]) LEVEL_FILE_MAGIC
+        - (unsigned int) version, (unsigned int) reserved
+        - (long long) offset of table of contents
+ */
+static const char LEVEL_FILE_MAGIC[8] = {'A', 'M', 'B', 'i', 'T', 'L', 'V', 'L'};
+static const unsigned int LEVEL_FILE_VERSION = 1;
+static const long long LEVEL_FILE_INDEX_POSITION = sizeof(LEVEL_FILE_MAGIC) + 2 * sizeof(unsigned int);
+
 void LevelMap::Store(pHamiltonianID key, const LevelVector& level_vector)
 {
     keys.insert(key);
     m_map.insert(std::make_pair(key, level_vector));
 
-    if(ProcessorRank == 0 && level_vector.levels.size() && !filename_prefix.empty())
+    if(level_vector.levels.size() && !filename_prefix.empty())
     {
         std::string filename = filename_prefix + ".levels";
-        FILE* fp = file_err_handler->fopen(filename.c_str(), "wb");
-        
-        // Write number of entries in LevelMap
-        unsigned int num_hamiltonians = 0;
-        for(auto& pair: m_map)
-        {
-            // Write all HamiltonianIDs that have been calculated
-            if((pair.second.configs != nullptr) && pair.second.levels.size())
-                num_hamiltonians++;
-        }
-        file_err_handler->fwrite(&num_hamiltonians, sizeof(unsigned int), 1, fp);
-        
-        // Write all HamiltonianIDs and Level information
-        for(auto& pair: m_map)
+
+        if(ProcessorRank == 0)
         {
-            if((pair.second.configs != nullptr) && pair.second.levels.size())
+            // Levels of a HamiltonianID already in the file have changed: rewriting them would leave a dead block
+            bool rewrite = false;
+            for(auto& pair: m_map)
             {
-                // Write HamiltonianID
-                pair.first->Write(fp);
+                auto index_it = index.find(pair.first);
+                if(pair.second.configs && pair.second.levels.size() && index_it != index.end()
+                   && index_it->second.written_levels != pair.second.levels)
+                    rewrite = true;
+            }
 
-                // Write configs
-                pair.second.configs->Write(fp);
+            FILE* fp = nullptr;
+            if(index_offset && !rewrite)
+                fp = file_err_handler->fopen(filename.c_str(), "r+b");
 
-                // Write all level information
-                unsigned int num_levels = pair.second.levels.size();
-                file_err_handler->fwrite(&num_levels, sizeof(unsigned int), 1, fp);
-                
-                for(auto& pl: pair.second.levels)
+            if(fp)
+            {   // Append LevelVectors that have not been written, followed by a new table of contents.
+                // The old table of contents remains valid until the header is updated.
+                fseek(fp, 0, SEEK_END);
+                for(auto& pair: m_map)
                 {
-                    const std::vector<double>& eigenvector = pl->GetEigenvector();
-                    unsigned int N = eigenvector.size();
-                    double eigenvalue = pl->GetEnergy();
-                    double gfactor = pl->GetgFactor();
-                    
-                    file_err_handler->fwrite(&eigenvalue, sizeof(double), 1, fp);
-                    file_err_handler->fwrite(&N, sizeof(unsigned int), 1, fp);
-                    file_err_handler->fwrite(eigenvector.data(), sizeof(double), N, fp);
-                    file_err_handler->fwrite(&gfactor, sizeof(double), 1, fp);
+                    const LevelVector& levelvec = pair.second;
+                    if(levelvec.configs && levelvec.levels.size() && index.find(pair.first) == index.end())
+                        WriteLevelVector(fp, levelvec, index[pair.first]);
                 }
+
+                WriteIndex(fp);
+                file_err_handler->fclose(fp);
             }
+            else
+                WriteLevelFile(filename);
+        }
+
+    #ifdef AMBIT_USE_MPI
+        // Other processors read the new table of contents once root has finished writing,
+        // whether the file was appended to or compacted.
+        MPI_Barrier(MPI_COMM_WORLD);
+        if(ProcessorRank != 0)
+            ReloadIndex(key);
+    #endif
+
+        // Eigenvectors can now be reloaded from file: keep only those of the current key in memory.
+        // This is the same on all processors, so they all use the same (possibly truncated) eigenvectors.
+        for(auto& pair: index)
+        {
+            IndexEntry& entry = pair.second;
+            for(unsigned int i = 0; i < entry.written_levels.size(); i++)
+            {
+                pLevel& pl = entry.written_levels[i];
+                pl->SetEigenvectorLoader(FileEigenvectorLoader(filename, entry.levels[i].eigenvector_offset), entry.levels[i].norm_loss);
+                if(!(*pair.first == *key))
+                    pl->ReleaseEigenvector();
+            }
+        }
+    }
+}
+
+void LevelMap::WriteLevelVector(FILE* fp, const LevelVector& levelvec, IndexEntry& entry)
+{
+    entry.configs_offset = ftell(fp);
+    entry.num_CSFs = levelvec.configs->NumCSFs();
+    levelvec.configs->Write(fp);
+
+    entry.levels.clear();
+    for(auto& pl: levelvec.levels)
+    {
+        // Align eigenvector coefficients (which follow the length) to 8 bytes
+        const char padding[sizeof(double)] = {0};
+        long misalignment = (ftell(fp) + sizeof(unsigned int)) % sizeof(double);
+        if(misalignment)
+            file_err_handler->fwrite(padding, sizeof(char), sizeof(double) - misalignment, fp);
+
+        LevelIndex level_index;
+        level_index.eigenvector_offset = WriteEigenvector(fp, *pl, level_index.norm_loss);
+        entry.levels.push_back(level_index);
+    }
+    entry.written_levels = levelvec.levels;
+}
+
+void LevelMap::CopyLevelVector(FILE* from, FILE* to, IndexEntry& entry)
+{
+    // Block runs from the configs to the end of the last eigenvector
+    double norm_loss;
+    fseek(from, entry.levels.back().eigenvector_offset, SEEK_SET);
+    ReadEigenvector(from, nullptr, norm_loss);
+    long long block_end = ftell(from);
+
+    // Keep the same alignment so that eigenvectors stay 8-byte aligned
+    const char padding[sizeof(double)] = {0};
+    long misalignment = (ftell(to) - entry.configs_offset) % long(sizeof(double));
+    if(misalignment < 0)
+        misalignment += sizeof(double);
+    if(misalignment)
+        file_err_handler->fwrite(padding, sizeof(char), sizeof(double) - misalignment, to);
+
+    long long shift = ftell(to) - entry.configs_offset;
+
+    std::vector<char> buffer(1 << 20);
+    fseek(from, entry.configs_offset, SEEK_SET);
+    long long remaining = block_end - entry.configs_offset;
+    while(remaining > 0)
+    {
+        size_t count = mmin(remaining, (long long)buffer.size());
+        file_err_handler->fread(buffer.data(), sizeof(char), count, from);
+        file_err_handler->fwrite(buffer.data(), sizeof(char), count, to);
+        remaining -= count;
+    }
+
+    entry.configs_offset += shift;
+    for(auto& level_index: entry.levels)
+        level_index.eigenvector_offset += shift;
+}
+
+void LevelMap::WriteLevelFile(const std::string& filename)
+{
+    // Write complete file under a temporary name, then replace the old file
+    std::string temp_filename = filename + ".tmp";
+    FILE* fp = file_err_handler->fopen(temp_filename.c_str(), "wb");
+    FILE* old_fp = nullptr;
+    if(index_offset)
+        old_fp = file_err_handler->fopen(filename.c_str(), "rb");
+
+    unsigned int reserved = 0;
+    long long no_index = 0;
+    file_err_handler->fwrite(LEVEL_FILE_MAGIC, sizeof(char), sizeof(LEVEL_FILE_MAGIC), fp);
+    file_err_handler->fwrite(&LEVEL_FILE_VERSION, sizeof(unsigned int), 1, fp);
+    file_err_handler->fwrite(&reserved, sizeof(unsigned int), 1, fp);
+    file_err_handler->fwrite(&no_index, sizeof(long long), 1, fp);
+
+    // Current levels are written from memory (loading eigenvectors from the old file if required);
+    // HamiltonianIDs that are only in the old file are copied unchanged.
+    decltype(index) new_index;
+    for(auto& pair: m_map)
+    {
+        const LevelVector& levelvec = pair.second;
+        if(levelvec.configs && levelvec.levels.size())
+        {
+            auto index_it = index.find(pair.first);
+            if(old_fp && index_it != index.end() && index_it->second.written_levels == levelvec.levels)
+            {   IndexEntry& entry = new_index[index_it->first];
+                entry = index_it->second;
+                CopyLevelVector(old_fp, fp, entry);
+            }
+            else
+                WriteLevelVector(fp, levelvec, new_index[pair.first]);
+        }
+    }
+
+    if(old_fp)
+    {
+        for(auto& pair: index)
+        {
+            if(new_index.find(pair.first) == new_index.end())
+            {   IndexEntry& entry = new_index[pair.first];
+                entry = pair.second;
+                CopyLevelVector(old_fp, fp, entry);
+            }
+        }
+        file_err_handler->fclose(old_fp);
+    }
+
+    index.swap(new_index);
+    WriteIndex(fp);
+    file_err_handler->fclose(fp);
+
+    if(rename(temp_filename.c_str(), filename.c_str()))
+    {   *errstream << "LevelMap::Store() cannot replace " << filename << " with " << temp_filename << std::endl;
+        exit(1);
+    }
+}
+
+void LevelMap::ReloadIndex(pHamiltonianIDConst hamiltonian_example)
+{
+    std::string filename = filename_prefix + ".levels";
+    FILE* fp = file_err_handler->fopen(filename.c_str(), "rb");
+    if(!fp)
+        return;
+
+    char magic[sizeof(LEVEL_FILE_MAGIC)];
+    file_err_handler->fread(magic, sizeof(char), sizeof(magic), fp);
+    ReadIndex(fp, hamiltonian_example);
+    file_err_handler->fclose(fp);
+
+    // Root has written all current LevelVectors (see Store())
+    for(auto& pair: m_map)
+    {
+        auto index_it = index.find(pair.first);
+        if(pair.second.configs && pair.second.levels.size() && index_it != index.end())
+            index_it->second.written_levels = pair.second.levels;
+    }
+}
+
+void LevelMap::WriteIndex(FILE* fp)
+{
+    long long offset = ftell(fp);
+
+    unsigned int num_hamiltonians = index.size();
+    file_err_handler->fwrite(&num_hamiltonians, sizeof(unsigned int), 1, fp);
+
+    for(auto& pair: index)
+    {
+        IndexEntry& entry = pair.second;
+
+        // Energies and g-factors may have been updated since the levels were written
+        for(unsigned int i = 0; i < entry.written_levels.size(); i++)
+        {   entry.levels[i].energy = entry.written_levels[i]->GetEnergy();
+            entry.levels[i].gfactor = entry.written_levels[i]->GetgFactor();
+        }
+
+        pair.first->Write(fp);
+        unsigned int num_levels = entry.levels.size();
+        file_err_handler->fwrite(&entry.configs_offset, sizeof(long long), 1, fp);
+        file_err_handler->fwrite(&entry.num_CSFs, sizeof(unsigned int), 1, fp);
+        file_err_handler->fwrite(&num_levels, sizeof(unsigned int), 1, fp);
+
+        for(const auto& level_index: entry.levels)
+        {
+            file_err_handler->fwrite(&level_index.energy, sizeof(double), 1, fp);
+            file_err_handler->fwrite(&level_index.gfactor, sizeof(double), 1, fp);
+            file_err_handler->fwrite(&level_index.norm_loss, sizeof(double), 1, fp);
+            file_err_handler->fwrite(&level_index.eigenvector_offset, sizeof(long long), 1, fp);
         }
-        
-        file_err_handler->fclose(fp);
     }
+
+    // Point header to new table of contents, only once it is complete
+    fflush(fp);
+    fseek(fp, LEVEL_FILE_INDEX_POSITION, SEEK_SET);
+    file_err_handler->fwrite(&offset, sizeof(long long), 1, fp);
+    index_offset = offset;
+}
+
+void LevelMap::ReadIndex(FILE* fp, pHamiltonianIDConst hamiltonian_example)
+{
+    unsigned int version, reserved;
+    long long offset;
+    file_err_handler->fread(&version, sizeof(unsigned int), 1, fp);
+    file_err_handler->fread(&reserved, sizeof(unsigned int), 1, fp);
+    file_err_handler->fread(&offset, sizeof(long long), 1, fp);
+
+    fseek(fp, offset, SEEK_SET);
+    unsigned int num_hamiltonians;
+    file_err_handler->fread(&num_hamiltonians, sizeof(unsigned int), 1, fp);
+
+    if(num_hamiltonians)
+        gfactors_needed = false;    // Assume the file has g-factors unless one or more of them is NaN
+
+    for(unsigned int i = 0; i < num_hamiltonians; i++)
+    {
+        pHamiltonianID key = hamiltonian_example->Clone();
+        key->Read(fp);
+        keys.insert(key);
+
+        IndexEntry& entry = index[key];
+        unsigned int num_levels;
+        file_err_handler->fread(&entry.configs_offset, sizeof(long long), 1, fp);
+        file_err_handler->fread(&entry.num_CSFs, sizeof(unsigned int), 1, fp);
+        file_err_handler->fread(&num_levels, sizeof(unsigned int), 1, fp);
+
+        entry.levels.resize(num_levels);
+        for(auto& level_index: entry.levels)
+        {
+            file_err_handler->fread(&level_index.energy, sizeof(double), 1, fp);
+            file_err_handler->fread(&level_index.gfactor, sizeof(double), 1, fp);
+            file_err_handler->fread(&level_index.norm_loss, sizeof(double), 1, fp);
+            file_err_handler->fread(&level_index.eigenvector_offset, sizeof(long long), 1, fp);
+
+            if(std::isnan(level_index.gfactor))
+                gfactors_needed = true;
+        }
+    }
+
+    index_offset = offset;
 }
 
 void LevelMap::ReadLevelMap(pHamiltonianIDConst hamiltonian_example)
@@ -86,6 +543,18 @@ void LevelMap::ReadLevelMap(pHamiltonianIDConst hamiltonian_example)
     if(!fp)
         return;
 
+    // Indexed file: just read table of contents
+    char magic[sizeof(LEVEL_FILE_MAGIC)];
+    if(fread(magic, sizeof(char), sizeof(magic), fp) == sizeof(magic) && memcmp(magic, LEVEL_FILE_MAGIC, sizeof(magic)) == 0)
+    {
+        ReadIndex(fp, hamiltonian_example);
+        file_err_handler->fclose(fp);
+        return;
+    }
+
+    // Older sequential file: read everything
+    fseek(fp, 0, SEEK_SET);
+
     // Read number of entries in LevelMap
     unsigned int num_hamiltonians;
     file_err_handler->fread(&num_hamiltonians, sizeof(unsigned int), 1, fp);
@@ -116,26 +585,17 @@ void LevelMap::ReadLevelMap(pHamiltonianIDConst hamiltonian_example)
         file_err_handler->fread(&num_levels, sizeof(unsigned int), 1, fp);
 
         levelvec.levels.reserve(num_levels);
-
-        double eigenvalue;
-        unsigned int N;
-        std::vector<double> eigenvector;
-        double gfactor;
         gfactors_needed = false; // Assume the file has g-factors unless one or more of them is NaN
 
         for(unsigned int index = 0; index < num_levels; index++)
         {
-            file_err_handler->fread(&eigenvalue, sizeof(double), 1, fp);
-            file_err_handler->fread(&N, sizeof(unsigned int), 1, fp);
-            eigenvector.resize(N);
-            file_err_handler->fread(eigenvector.data(), sizeof(double), N, fp);
-            file_err_handler->fread(&gfactor, sizeof(double), 1, fp);
-            
+            pLevel level = ReadLevel(fp, key);
+
             // Check if we need to re-calculate this g-factor
-            if(std::isnan(gfactor))
+            if(std::isnan(level->GetgFactor()))
                 gfactors_needed = true;
 
-            levelvec.levels.emplace_back(std::make_shared<Level>(eigenvalue, eigenvector, key, gfactor));
+            levelvec.levels.push_back(level);
         }
     }
 
@@ -198,26 +658,18 @@ LevelVector FileSystemLevelStore::GetLevels(pHamiltonianID key)
         file_err_handler->fread(&num_levels, sizeof(unsigned int), 1, fp);
 
         levelvec.levels.reserve(num_levels);
-
-        double eigenvalue;
-        unsigned int N;
-        std::vector<double> eigenvector;
-        double gfactor;
         gfactors_needed = false; // Assume the file has g-factors unless one or more of them is NaN
 
+        // Eigenvectors are only read when needed
         for(unsigned int index = 0; index < num_levels; index++)
         {
-            file_err_handler->fread(&eigenvalue, sizeof(double), 1, fp);
-            file_err_handler->fread(&N, sizeof(unsigned int), 1, fp);
-            eigenvector.resize(N);
-            file_err_handler->fread(eigenvector.data(), sizeof(double), N, fp);
-            file_err_handler->fread(&gfactor, sizeof(double), 1, fp);
+            pLevel level = ReadLevel(fp, read_key, filename);
 
             // Check if we need to re-calculate this g-factor
-            if(std::isnan(gfactor))
+            if(std::isnan(level->GetgFactor()))
                 gfactors_needed = true;
 
-            levelvec.levels.emplace_back(std::make_shared<Level>(eigenvalue, eigenvector, read_key, gfactor));
+            levelvec.levels.push_back(level);
         }
     }
 
@@ -235,6 +687,10 @@ void FileSystemLevelStore::Store(pHamiltonianID key, const LevelVector& level_ve
     std::string filename = filename_prefix + "." + key->Name() + ".levels";
     filename = (directory / filename).string();
 
+    // Eigenvectors may still be waiting to be loaded from the file we are about to overwrite
+    for(auto& pl: level_vector.levels)
+        pl->GetEigenvector();
+
     FILE* fp = file_err_handler->fopen(filename.c_str(), "wb");
     if(!fp)
     {   *errstream << "FileSystemLevelStore::Store() cannot open " << filename << " for writing." << std::endl;
@@ -248,19 +704,15 @@ void FileSystemLevelStore::Store(pHamiltonianID key, const LevelVector& level_ve
     unsigned int num_levels = level_vector.levels.size();
     file_err_handler->fwrite(&num_levels, sizeof(unsigned int), 1, fp);
 
-    for(auto& pl: level_vector.levels)
-    {
-        const std::vector<double>& eigenvector = pl->GetEigenvector();
-        unsigned int N = eigenvector.size();
-        double eigenvalue = pl->GetEnergy();
-        double gfactor = pl->GetgFactor();
-
-        file_err_handler->fwrite(&eigenvalue, sizeof(double), 1, fp);
-        file_err_handler->fwrite(&N, sizeof(unsigned int), 1, fp);
-        file_err_handler->fwrite(eigenvector.data(), sizeof(double), N, fp);
-        file_err_handler->fwrite(&gfactor, sizeof(double), 1, fp);
-    }
+    std::vector<long> offsets;
+    std::vector<double> norm_losses(num_levels);
+    for(unsigned int i = 0; i < num_levels; i++)
+        offsets.push_back(WriteLevel(fp, *level_vector.levels[i], norm_losses[i]));
 
     file_err_handler->fclose(fp);
+
+    // Eigenvectors can now be released and reloaded from the new file
+    for(unsigned int i = 0; i < num_levels; i++)
+        level_vector.levels[i]->SetEigenvectorLoader(FileEigenvectorLoader(filename, offsets[i]), norm_losses[i]);
 }
 }
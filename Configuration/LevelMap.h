@@ -69,14 +69,59 @@ public:
     {   return gfactors_needed;
     }
 
+    /** Set format of eigenvectors written to file. If use_float, coefficients are stored in single precision.
+        Coefficients with magnitude below truncation_threshold are discarded; the norm lost is recorded with the level.
+     */
+    void SetEigenvectorStorage(bool use_float, double truncation_threshold = 0.)
+    {   float_eigenvectors = use_float;
+        eigenvector_truncation = truncation_threshold;
+    }
+
+protected:
+    /** Write eigenvalue, eigenvector (in storage format) and g-factor of level.
+        Return file position of eigenvector and set norm_loss to norm of discarded coefficients.
+     */
+    long WriteLevel(FILE* fp, const Level& level, double& norm_loss) const;
+
+    /** Write eigenvector only (as part of WriteLevel()). Return file position of eigenvector. */
+    long WriteEigenvector(FILE* fp, const Level& level, double& norm_loss) const;
+
+    /** Read level written by WriteLevel(). If lazy_filename is not empty, the eigenvector is skipped
+        and instead loaded from lazy_filename when requested.
+     */
+    pLevel ReadLevel(FILE* fp, pHamiltonianID key, const std::string& lazy_filename = "");
+
+    /** Read eigenvector at current file position and return its length (NumCSFs).
+        If eigenvector is null, skip over it instead.
+     */
+    static unsigned int ReadEigenvector(FILE* fp, std::vector<double>* eigenvector, double& norm_loss);
+
+    /** Loader that reads eigenvector at position offset in filename. */
+    static EigenvectorLoader FileEigenvectorLoader(const std::string& filename, long offset);
+
 protected:
     bool gfactors_needed = true;
 
+    bool float_eigenvectors = false;
+    double eigenvector_truncation = 0.;
 };
 
 typedef std::shared_ptr<LevelStore> pLevelStore;
 
-/** Implementation of LevelStore for when all levels can be stored simultaneously in memory. */
+/** Implementation of LevelStore for when all levels can be stored simultaneously in memory.
+    Levels are kept in a single indexed file <file_id>.levels:
+        - header: magic, version, offset of table of contents
+        - for each HamiltonianID: RelativisticConfigList followed by eigenvectors of all levels
+        - table of contents: for each HamiltonianID, offset of configs and for each level its energy,
+          g-factor and eigenvector offset.
+    New levels are appended followed by a new table of contents; the header is only pointed at the new
+    table once it is complete, so an interrupted Store() leaves the previous contents readable.
+    If the levels of a stored HamiltonianID change, the file is instead rewritten without the old
+    blocks under a temporary name, which then replaces the old file.
+    On reading, configurations of a HamiltonianID are only loaded when requested by GetLevels(),
+    and eigenvectors when requested by Level::GetEigenvector().
+    Uncompressed eigenvectors are stored as 8-byte aligned arrays of doubles, suitable for mmap.
+ */
 class LevelMap : public LevelStore
 {
     typedef std::map<pHamiltonianID, LevelVector, DereferenceComparator<pHamiltonianID>> MapType;
@@ -98,18 +143,59 @@ public:
     virtual void Store(pHamiltonianID key, const LevelVector& level_vector) override;
 
 protected:
-    /** Read entire LevelMap in single file. */
+    /** Read LevelMap from single file: indexed files are read lazily, older files entirely. */
     void ReadLevelMap(pHamiltonianIDConst hamiltonian_example);
 
+    /** Read table of contents of indexed file. */
+    void ReadIndex(FILE* fp, pHamiltonianIDConst hamiltonian_example);
+
+    /** Write table of contents at current position of fp and update header. */
+    void WriteIndex(FILE* fp);
+
+    /** Write compacted file containing all current LevelVectors and replace filename with it. */
+    void WriteLevelFile(const std::string& filename);
+
+    /** Read table of contents again after root has appended to or rewritten the file. */
+    void ReloadIndex(pHamiltonianIDConst hamiltonian_example);
+
 protected:
     std::string filename_prefix;
     pAngularDataLibrary angular_library;
 
     MapType m_map;
+
+    /** Location of level in indexed file. */
+    struct LevelIndex
+    {   double energy;
+        double gfactor;
+        double norm_loss;
+        long long eigenvector_offset;
+    };
+
+    /** Location of LevelVector in indexed file. written_levels are the Level objects that were
+        stored there (if known), so that repeated Store() of the same levels needs only a new index.
+     */
+    struct IndexEntry
+    {   long long configs_offset;
+        unsigned int num_CSFs;
+        std::vector<LevelIndex> levels;
+        std::vector<pLevel> written_levels;
+    };
+
+    std::map<pHamiltonianID, IndexEntry, DereferenceComparator<pHamiltonianID>> index;
+    long long index_offset = 0;     //!< Offset of table of contents in file; zero if there is no indexed file
+
+protected:
+    /** Write configs and eigenvectors of levelvec at current position of fp, recording offsets in entry. */
+    void WriteLevelVector(FILE* fp, const LevelVector& levelvec, IndexEntry& entry);
+
+    /** Copy block of entry from file "from" to current position of "to", and update offsets in entry. */
+    void CopyLevelVector(FILE* from, FILE* to, IndexEntry& entry);
 };
 
 /** Implementation of LevelStore that writes everything to files and stores almost nothing.
     Files are separated by Key, in order to speed up retrieval.
+    Eigenvectors of levels retrieved by GetLevels() are only read from file when they are requested.
  */
 class FileSystemLevelStore : public LevelStore
 {
@@ -0,0 +1,253 @@
+#include "LevelMap.h"
+#include "gtest/gtest.h"
+#include "Include.h"
+#include <cstdio>
+
+using namespace Ambit;
+
+namespace
+{
+/** Configurations of 4d^4, with projections and CSFs for the symmetry of key generated in library. */
+pRelativisticConfigList MakeConfigs(pHamiltonianID key, pAngularDataLibrary library)
+{
+    pRelativisticConfigList configs = std::make_shared<RelativisticConfigList>();
+    for(int num_minus = 0; num_minus <= 4; num_minus += 2)
+    {
+        RelativisticConfiguration rconfig;
+        if(num_minus)
+            rconfig.insert(std::make_pair(OrbitalInfo(4, 2), num_minus));
+        if(num_minus < 4)
+            rconfig.insert(std::make_pair(OrbitalInfo(4, -3), 4 - num_minus));
+        configs->push_back(rconfig);
+    }
+
+    for(auto& rconfig: *configs)
+        rconfig.GetProjections(library, key->GetSymmetry(), key->GetTwoJ());
+    library->GenerateCSFs();
+
+    return configs;
+}
+
+/** Eigenvector in which every second coefficient is below a truncation threshold of 1.e-3. */
+std::vector<double> MakeTruncatableEigenvector(unsigned int N, double& squared_loss)
+{
+    std::vector<double> eigenvector(N);
+    squared_loss = 0.;
+    for(unsigned int i = 0; i < N; i++)
+    {
+        if(i%2)
+        {   eigenvector[i] = 1.e-5 * (i + 1);
+            squared_loss += eigenvector[i] * eigenvector[i];
+        }
+        else
+            eigenvector[i] = 1./(i + 1);
+    }
+
+    return eigenvector;
+}
+}
+
+TEST(LevelMapTester, CompressedEigenvectors)
+{
+    pAngularDataLibrary library = std::make_shared<AngularDataLibrary>();
+    pHamiltonianID key = std::make_shared<HamiltonianID>(0, Parity::even);
+    pRelativisticConfigList configs = MakeConfigs(key, library);
+    unsigned int N = configs->NumCSFs();
+    ASSERT_LE(2, N);
+
+    double squared_loss;
+    std::vector<double> eigenvector = MakeTruncatableEigenvector(N, squared_loss);
+
+    std::string file_id = "LevelMapTest_Compressed";
+    {
+        LevelMap store(file_id, library);
+        store.SetEigenvectorStorage(true, 1.e-3);
+        store.Store(key, LevelVector(key, configs, std::make_shared<Level>(-1.5, eigenvector, key, 0.5)));
+    }
+
+    LevelMap read(key, file_id, library);
+    LevelVector levelvec = read.GetLevels(key);
+    ASSERT_EQ(1, levelvec.levels.size());
+    pLevel level = levelvec.levels[0];
+
+    EXPECT_DOUBLE_EQ(-1.5, level->GetEnergy());
+    EXPECT_DOUBLE_EQ(0.5, level->GetgFactor());
+    EXPECT_NEAR(sqrt(squared_loss), level->GetNormLoss(), 1.e-15);
+
+    const std::vector<double>& read_eigenvector = level->GetEigenvector();
+    ASSERT_EQ(N, read_eigenvector.size());
+    for(unsigned int i = 0; i < N; i++)
+    {
+        if(i%2)
+            EXPECT_EQ(0., read_eigenvector[i]);
+        else
+            EXPECT_NEAR(eigenvector[i], read_eigenvector[i], 1.e-6 * fabs(eigenvector[i]));   // single precision
+    }
+
+    std::remove((file_id + ".levels").c_str());
+}
+
+TEST(LevelMapTester, StoreTwiceNormLoss)
+{
+    pAngularDataLibrary library = std::make_shared<AngularDataLibrary>();
+    pHamiltonianID key = std::make_shared<HamiltonianID>(0, Parity::even);
+    pRelativisticConfigList configs = MakeConfigs(key, library);
+    unsigned int N = configs->NumCSFs();
+    ASSERT_LE(2, N);
+
+    double squared_loss;
+    std::vector<double> eigenvector = MakeTruncatableEigenvector(N, squared_loss);
+
+    std::string file_id = "LevelMapTest_StoreTwice";
+    FileSystemLevelStore store(file_id, library);
+    store.SetEigenvectorStorage(true, 1.e-3);
+
+    // Levels are stored again once g-factors are calculated, with the full eigenvector still in memory
+    pLevel level = std::make_shared<Level>(-1.5, eigenvector, key, 0.5);
+    LevelVector levelvec(key, configs, level);
+    store.Store(key, levelvec);
+    EXPECT_EQ(0., level->GetNormLoss());
+    store.Store(key, levelvec);
+
+    LevelVector read_levelvec = store.GetLevels(key);
+    ASSERT_EQ(1, read_levelvec.levels.size());
+    EXPECT_NEAR(sqrt(squared_loss), read_levelvec.levels[0]->GetNormLoss(), 1.e-15);
+
+    // Once released, the stored eigenvector is used instead
+    level->ReleaseEigenvector();
+    EXPECT_NEAR(sqrt(squared_loss), level->GetNormLoss(), 1.e-15);
+
+    std::remove((file_id + "." + key->Name() + ".levels").c_str());
+}
+
+TEST(LevelMapTester, LazyEigenvectors)
+{
+    pAngularDataLibrary library = std::make_shared<AngularDataLibrary>();
+    pHamiltonianID key = std::make_shared<HamiltonianID>(0, Parity::even);
+    pRelativisticConfigList configs = MakeConfigs(key, library);
+    unsigned int N = configs->NumCSFs();
+    ASSERT_LE(2, N);
+
+    std::vector<double> eigenvector(N);
+    for(unsigned int i = 0; i < N; i++)
+        eigenvector[i] = 1./(i + 1);
+
+    std::string file_id = "LevelMapTest_Lazy";
+    {
+        LevelMap store(file_id, library);
+        store.Store(key, LevelVector(key, configs, std::make_shared<Level>(-1.5, eigenvector, key, 0.5)));
+    }
+
+    LevelMap read(key, file_id, library);
+    pLevel level = read.GetLevels(key).levels[0];
+
+    // Not loaded until requested
+    EXPECT_FALSE(level->EigenvectorLoaded());
+    EXPECT_EQ(N, level->GetEigenvectorLength());
+    EXPECT_TRUE(level->GetEigenvector() == eigenvector);
+    EXPECT_TRUE(level->EigenvectorLoaded());
+
+    // Released and loaded again
+    level->ReleaseEigenvector();
+    EXPECT_FALSE(level->EigenvectorLoaded());
+    EXPECT_TRUE(level->GetEigenvector() == eigenvector);
+
+    // Threads may load concurrently; release has no effect inside a parallel region
+    level->ReleaseEigenvector();
+    int num_mismatched = 0;
+#ifdef AMBIT_USE_OPENMP
+    #pragma omp parallel reduction(+:num_mismatched)
+#endif
+    {
+        const std::vector<double>& thread_eigenvector = level->GetEigenvector();
+        level->ReleaseEigenvector();
+        if(thread_eigenvector != eigenvector)
+            num_mismatched++;
+    }
+    EXPECT_EQ(0, num_mismatched);
+    EXPECT_TRUE(level->EigenvectorLoaded());
+
+    std::remove((file_id + ".levels").c_str());
+}
+
+TEST(LevelMapTester, StoreReloadRoundTrip)
+{
+    pAngularDataLibrary library = std::make_shared<AngularDataLibrary>();
+    pHamiltonianID key0 = std::make_shared<HamiltonianID>(0, Parity::even);
+    pHamiltonianID key2 = std::make_shared<HamiltonianID>(2, Parity::even);
+    pRelativisticConfigList configs0 = MakeConfigs(key0, library);
+    pRelativisticConfigList configs2 = MakeConfigs(key2, library);
+    unsigned int N0 = configs0->NumCSFs();
+    unsigned int N2 = configs2->NumCSFs();
+    ASSERT_LE(1, N0);
+    ASSERT_LE(1, N2);
+
+    auto make_eigenvector = [](unsigned int N, double scale)
+    {   std::vector<double> eigenvector(N);
+        for(unsigned int i = 0; i < N; i++)
+            eigenvector[i] = scale/(i + 1);
+        return eigenvector;
+    };
+
+    std::string file_id = "LevelMapTest_RoundTrip";
+    std::string filename = file_id + ".levels";
+
+    // Store
+    {
+        LevelMap store(file_id, library);
+        store.Store(key0, LevelVector(key0, configs0, std::make_shared<Level>(-1.0, make_eigenvector(N0, 1.), key0, 0.5)));
+    }
+
+    // Reload and store another symmetry: appended to file
+    {
+        LevelMap store(key0, file_id, library);
+        EXPECT_EQ(1, store.keys.size());
+        store.Store(key2, LevelVector(key2, configs2, std::make_shared<Level>(-2.0, make_eigenvector(N2, 2.), key2, 1.5)));
+    }
+
+    // Reload: both symmetries present
+    {
+        LevelMap read(key0, file_id, library);
+        EXPECT_EQ(2, read.keys.size());
+
+        LevelVector levels0 = read.GetLevels(key0);
+        ASSERT_EQ(1, levels0.levels.size());
+        EXPECT_DOUBLE_EQ(-1.0, levels0.levels[0]->GetEnergy());
+        EXPECT_DOUBLE_EQ(0.5, levels0.levels[0]->GetgFactor());
+        EXPECT_TRUE(levels0.levels[0]->GetEigenvector() == make_eigenvector(N0, 1.));
+
+        LevelVector levels2 = read.GetLevels(key2);
+        ASSERT_EQ(1, levels2.levels.size());
+        EXPECT_DOUBLE_EQ(-2.0, levels2.levels[0]->GetEnergy());
+        EXPECT_TRUE(levels2.levels[0]->GetEigenvector() == make_eigenvector(N2, 2.));
+    }
+
+    // Rewrite a stored symmetry: file is compacted rather than growing
+    uintmax_t size_before = boost::filesystem::file_size(filename);
+    {
+        LevelMap store(key0, file_id, library);
+        store.Store(key0, LevelVector(key0, configs0, std::make_shared<Level>(-3.0, make_eigenvector(N0, 3.), key0, 2.5)));
+    }
+    EXPECT_LE(boost::filesystem::file_size(filename), size_before);
+    EXPECT_FALSE(boost::filesystem::exists(filename + ".tmp"));
+
+    // Reload: new levels for key0 and unchanged levels for key2
+    {
+        LevelMap read(key0, file_id, library);
+        EXPECT_EQ(2, read.keys.size());
+
+        LevelVector levels0 = read.GetLevels(key0);
+        ASSERT_EQ(1, levels0.levels.size());
+        EXPECT_DOUBLE_EQ(-3.0, levels0.levels[0]->GetEnergy());
+        EXPECT_DOUBLE_EQ(2.5, levels0.levels[0]->GetgFactor());
+        EXPECT_TRUE(levels0.levels[0]->GetEigenvector() == make_eigenvector(N0, 3.));
+
+        LevelVector levels2 = read.GetLevels(key2);
+        ASSERT_EQ(1, levels2.levels.size());
+        EXPECT_DOUBLE_EQ(-2.0, levels2.levels[0]->GetEnergy());
+        EXPECT_DOUBLE_EQ(1.5, levels2.levels[0]->GetgFactor());
+        EXPECT_TRUE(levels2.levels[0]->GetEigenvector() == make_eigenvector(N2, 2.));
+    }
+
+    std::remove(filename.c_str());
+}
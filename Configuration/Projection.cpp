@@ -5,7 +5,8 @@
 
 namespace Ambit
 {
-Projection::Projection(const RelativisticConfiguration& relconfig, const std::vector<int>& TwoMs)
+template<class TwoMList>
+void Projection::SetTwoMs(const RelativisticConfiguration& relconfig, const TwoMList& TwoMs)
 {
     config.reserve(relconfig.ParticleNumber());
 
@@ -23,6 +24,16 @@ Projection::Projection(const RelativisticConfiguration& relconfig, const std::ve
     config.shrink_to_fit();
 }
 
+Projection::Projection(const RelativisticConfiguration& relconfig, const CompactProjection& TwoMs)
+{
+    SetTwoMs(relconfig, TwoMs);
+}
+
+Projection::Projection(const RelativisticConfiguration& relconfig, const std::vector<int>& TwoMs)
+{
+    SetTwoMs(relconfig, TwoMs);
+}
+
 ElectronInfo& Projection::operator[](unsigned int i)
 {
     return config[i];
@@ -5,11 +5,35 @@
 #include "HartreeFock/Configuration.h"
 #include <vector>
 #include <list>
+#include <cstdint>
 
 namespace Ambit
 {
 class RelativisticConfiguration;
 
+/** List of two_M for each particle in a projection, as stored in AngularData.
+    A CompactProjection does not own its data: it views a section of the contiguous projection
+    storage of an AngularData object, and is only valid while that object exists.
+ */
+class CompactProjection
+{
+public:
+    typedef int8_t value_type;  //!< Individual two_M always fit in a byte
+    typedef const value_type* const_iterator;
+
+    CompactProjection(const value_type* data, unsigned int size): m_data(data), m_size(size) {}
+
+    const_iterator begin() const { return m_data; }
+    const_iterator end() const { return m_data + m_size; }
+
+    unsigned int size() const { return m_size; }
+    int operator[](unsigned int i) const { return m_data[i]; }
+
+protected:
+    const value_type* m_data;
+    unsigned int m_size;
+};
+
 /** A projection is kind of like a configuration, however there
     is no occupancy: either a state has one electron or it isn't
     part of the configuration.
@@ -19,6 +43,7 @@ class RelativisticConfiguration;
 class Projection
 {
 public:
+    Projection(const RelativisticConfiguration& relconfig, const CompactProjection& twoMs);
     Projection(const RelativisticConfiguration& relconfig, const std::vector<int>& twoMs);
     virtual ~Projection() = default;
 
@@ -46,6 +71,10 @@ public:
     std::string Name() const;
 
 protected:
+    /** Build list of ElectronInfo from relconfig and two_M of each particle. */
+    template<class TwoMList>
+    void SetTwoMs(const RelativisticConfiguration& relconfig, const TwoMList& TwoMs);
+
     std::vector<ElectronInfo> config;
 };
 
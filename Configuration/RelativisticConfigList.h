@@ -2,6 +2,7 @@
 #define RELATIVISTIC_CONFIG_LIST_H
 
 #include "RelativisticConfiguration.h"
+#include <boost/functional/hash.hpp>
 
 namespace Ambit
 {
@@ -212,6 +213,12 @@ public:
      */
     void unique();
 
+    /** Remove all configurations for which pred is true in a single pass,
+        preserving order and the separation between the first Nsmall configs and the rest.
+     */
+    template<class Predicate>
+    void remove_if(Predicate pred);
+
 public:
     unsigned int NumCSFs() const;   //!< Total number of CSFs stored in entire list
     unsigned int NumCSFsSmall() const;  //!< Number of CSFs stored in subset [0, Nsmall)
@@ -277,6 +284,25 @@ public:
     }
 };
 
+/** Hash of the (orbital, occupancy) pairs of a configuration, consistent with operator==.
+    Allows RelativisticConfigurations to be stored in unordered containers.
+ */
+class ConfigurationHasher
+{
+public:
+    std::size_t operator()(const RelativisticConfiguration& config) const
+    {
+        std::size_t seed = config.size();
+        for(const auto& pair: config)
+        {
+            boost::hash_combine(seed, pair.first.PQN());
+            boost::hash_combine(seed, pair.first.Kappa());
+            boost::hash_combine(seed, pair.second);
+        }
+        return seed;
+    }
+};
+
 template<class Comparator>
 void RelativisticConfigList::sort(Comparator comp)
 {
@@ -285,6 +311,19 @@ void RelativisticConfigList::sort(Comparator comp)
     std::sort(itsmall, m_list.end(), comp);
 }
 
+template<class Predicate>
+void RelativisticConfigList::remove_if(Predicate pred)
+{
+    auto itsmall = std::next(m_list.begin(), Nsmall);
+    auto small_end = std::remove_if(m_list.begin(), itsmall, pred);
+    auto large_end = std::remove_if(itsmall, m_list.end(), pred);
+
+    // Close gap between small and large sections
+    large_end = std::move(itsmall, large_end, small_end);
+    Nsmall = small_end - m_list.begin();
+    m_list.erase(large_end, m_list.end());
+}
+
 typedef std::shared_ptr<RelativisticConfigList> pRelativisticConfigList;
 typedef std::shared_ptr<const RelativisticConfigList> pRelativisticConfigListConst;
 
@@ -0,0 +1,301 @@
+#include "Include.h"
+#include "TransitionDensity.h"
+#include "Universal/MathConstant.h"
+#ifdef AMBIT_USE_MPI
+#include <mpi.h>
+#endif
+
+#ifdef AMBIT_USE_OPENMP
+#include<omp.h>
+#endif
+
+namespace Ambit
+{
+TransitionDensity::TransitionDensity(pSpinorMatrixElementConst op, const LevelVector& left_levels, const LevelVector& right_levels):
+    TransitionDensity(op->GetK(), op->GetParity(), left_levels, right_levels)
+{
+    std::vector<TransitionDensity*> single(1, this);
+    CalculateDensities(single, left_levels, right_levels);
+}
+
+TransitionDensity::TransitionDensity(int K, Parity P, const LevelVector& left_levels, const LevelVector& right_levels):
+    K(K), P(P), num_left(left_levels.levels.size()), num_right(right_levels.levels.size())
+{}
+
+std::vector<pTransitionDensity> TransitionDensity::Calculate(const std::vector<pSpinorMatrixElementConst>& ops, const LevelVector& left_levels, const LevelVector& right_levels)
+{
+    std::vector<pTransitionDensity> ret(ops.size());
+    std::vector<TransitionDensity*> unique_densities;
+
+    for(unsigned int i = 0; i < ops.size(); i++)
+    {
+        // Operators with the same rank and parity share densities
+        for(unsigned int j = 0; j < i; j++)
+            if(ret[j]->IsCompatible(ops[i]))
+            {   ret[i] = ret[j];
+                break;
+            }
+
+        if(!ret[i])
+        {   ret[i].reset(new TransitionDensity(ops[i]->GetK(), ops[i]->GetParity(), left_levels, right_levels));
+            unique_densities.push_back(ret[i].get());
+        }
+    }
+
+    CalculateDensities(unique_densities, left_levels, right_levels);
+    return ret;
+}
+
+void TransitionDensity::CalculateDensities(std::vector<TransitionDensity*>& densities, const LevelVector& left_levels, const LevelVector& right_levels)
+{
+    unsigned int num_left = left_levels.levels.size();
+    unsigned int num_right = right_levels.levels.size();
+    unsigned int num_solutions = num_left * num_right;
+    unsigned int num_densities = densities.size();
+    if(num_solutions == 0 || num_densities == 0)
+        return;
+
+    const RelativisticConfigList& configs_left = *left_levels.configs;
+    const RelativisticConfigList& configs_right = *right_levels.configs;
+
+    // Index all orbitals in both sets of configurations and all pairs allowed by symmetry
+    std::map<OrbitalInfo, unsigned int> orbital_index;
+    for(const RelativisticConfigList* configs: {&configs_left, &configs_right})
+        for(const auto& config: *configs)
+            for(const auto& pair: config)
+                orbital_index.insert(std::make_pair(pair.first, 0));
+
+    std::vector<OrbitalInfo> orbital_list;
+    orbital_list.reserve(orbital_index.size());
+    for(auto& pair: orbital_index)
+    {   pair.second = orbital_list.size();
+        orbital_list.push_back(pair.first);
+    }
+
+    unsigned int num_orbitals = orbital_list.size();
+    std::vector<std::vector<int>> pair_index(num_densities, std::vector<int>(num_orbitals * num_orbitals, -1));
+    for(unsigned int d = 0; d < num_densities; d++)
+    {
+        TransitionDensity& density = *densities[d];
+        SpinorMatrixElement symmetry(density.K, density.P);
+        for(unsigned int a = 0; a < num_orbitals; a++)
+            for(unsigned int b = 0; b < num_orbitals; b++)
+                if(symmetry.IsNonZero(orbital_list[a], orbital_list[b]))
+                {   pair_index[d][a * num_orbitals + b] = density.orbital_pairs.size();
+                    density.orbital_pairs.push_back(std::make_pair(orbital_list[a], orbital_list[b]));
+                }
+
+        density.density.resize(density.orbital_pairs.size() * num_solutions, 0.);
+    }
+
+    // The CSF sums factorise, so only need projection amplitudes in each level
+    std::vector<double> left_amplitudes, right_amplitudes;
+    std::vector<unsigned int> left_offsets, right_offsets;
+    GetProjectionAmplitudes(left_levels, left_amplitudes, left_offsets);
+    GetProjectionAmplitudes(right_levels, right_amplitudes, right_offsets);
+
+    std::vector<RelativisticConfigList::const_iterator> left_configs;
+    left_configs.reserve(configs_left.size());
+    for(auto config_it = configs_left.begin(); config_it != configs_left.end(); config_it++)
+        left_configs.push_back(config_it);
+
+    // ManyBodyOperator is only used here to find differences between projections
+    ManyBodyOperator<pTransitionIntegrals> differences(nullptr);
+
+#ifdef AMBIT_USE_OPENMP
+    #pragma omp parallel
+#endif
+    {
+        // MathConstant caches 3j symbols and is not thread-safe: each thread uses its own instance
+        MathConstant* math = MathConstant::Instance();
+        std::vector<std::vector<double>> my_density(num_densities);
+        for(unsigned int d = 0; d < num_densities; d++)
+            my_density[d].resize(densities[d]->density.size(), 0.);
+        ManyBodyOperator<pTransitionIntegrals>::IndirectProjectionStruct indirects;
+
+        // Add < e1 || o || e2 > contribution with angular factor from OneElectronIntegrals::GetMatrixElement()
+        // for every density, sharing the projection differences and amplitudes
+        auto add_density = [&](const ElectronInfo& e1, const ElectronInfo& e2, double factor, const double* left_amplitude, const double* right_amplitude)
+        {
+            unsigned int a = orbital_index.at(OrbitalInfo(e1.PQN(), e1.Kappa()));
+            unsigned int b = orbital_index.at(OrbitalInfo(e2.PQN(), e2.Kappa()));
+            double sign = factor * math->minus_one_to_the_power((e1.TwoJ() - e1.TwoM())/2);
+
+            for(unsigned int d = 0; d < num_densities; d++)
+            {
+                int index = pair_index[d][a * num_orbitals + b];
+                if(index < 0)
+                    continue;
+
+                double angular = sign * math->Electron3j(e2.TwoJ(), e1.TwoJ(), densities[d]->K, e2.TwoM(), -e1.TwoM());
+                if(!angular)
+                    continue;
+
+                double* pdensity = &my_density[d][index * num_solutions];
+                for(unsigned int i = 0; i < num_left; i++)
+                {
+                    double left_factor = angular * left_amplitude[i];
+                    for(unsigned int j = 0; j < num_right; j++)
+                        pdensity[i * num_right + j] += left_factor * right_amplitude[j];
+                }
+            }
+        };
+
+#ifdef AMBIT_USE_OPENMP
+        #pragma omp for schedule(dynamic)
+#endif
+        for(unsigned int ii = 0; ii < left_configs.size(); ii++)
+        {
+            auto config_it = left_configs[ii];
+            int config_index = ii * configs_right.size();
+
+            unsigned int jj = 0;
+            for(auto config_jt = configs_right.begin(); config_jt != configs_right.end(); config_jt++, jj++)
+            {
+                if(config_it->GetConfigDifferencesCount(*config_jt) > 1)
+                    continue;
+
+                if(config_index%NumProcessors == ProcessorRank)
+                {
+                    unsigned int left_proj = left_offsets[ii];
+                    for(auto proj_it = config_it.projection_begin(); proj_it != config_it.projection_end(); proj_it++, left_proj++)
+                    {
+                        const double* left_amplitude = &left_amplitudes[left_proj * num_left];
+
+                        unsigned int right_proj = right_offsets[jj];
+                        for(auto proj_jt = config_jt.projection_begin(); proj_jt != config_jt.projection_end(); proj_jt++, right_proj++)
+                        {
+                            const double* right_amplitude = &right_amplitudes[right_proj * num_right];
+
+                            differences.make_indirect_projection(*proj_it, indirects.left);
+                            differences.make_indirect_projection(*proj_jt, indirects.right);
+                            int num_diffs = differences.GetProjectionDifferences<1>(indirects);
+
+                            if(num_diffs == 0)
+                            {
+                                for(const ElectronInfo* e: indirects.left)
+                                    add_density(*e, *e, (e->IsHole()? -1.: 1.), left_amplitude, right_amplitude);
+                            }
+                            else if(abs(num_diffs) == 1)
+                            {
+                                add_density(*indirects.left[0], *indirects.right[0], double(num_diffs), left_amplitude, right_amplitude);
+                            }
+                        }
+                    }
+                } // MPI work distribution
+
+                config_index++;
+            }
+        }
+
+#ifdef AMBIT_USE_OPENMP
+        #pragma omp critical(TRANSITION_DENSITY)
+#endif
+        for(unsigned int d = 0; d < num_densities; d++)
+            for(unsigned int i = 0; i < my_density[d].size(); i++)
+                densities[d]->density[i] += my_density[d][i];
+    }
+
+    for(TransitionDensity* pdensity: densities)
+    {
+        TransitionDensity& density = *pdensity;
+
+#ifdef AMBIT_USE_MPI
+        if(NumProcessors > 1)
+        {
+            std::vector<double> reduced_density(density.density.size(), 0.);
+            MPI_Allreduce(density.density.data(), reduced_density.data(), density.density.size(), MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+            density.density.swap(reduced_density);
+        }
+#endif
+
+        // Remove orbital pairs that don't contribute
+        unsigned int num_kept = 0;
+        for(unsigned int index = 0; index < density.orbital_pairs.size(); index++)
+        {
+            auto start = density.density.begin() + index * num_solutions;
+            if(std::any_of(start, start + num_solutions, [](double x){ return x != 0.; }))
+            {
+                if(num_kept != index)
+                {   density.orbital_pairs[num_kept] = density.orbital_pairs[index];
+                    std::copy(start, start + num_solutions, density.density.begin() + num_kept * num_solutions);
+                }
+                num_kept++;
+            }
+        }
+        density.orbital_pairs.resize(num_kept);
+        density.density.resize(num_kept * num_solutions);
+    }
+}
+
+std::vector<double> TransitionDensity::GetMatrixElements(pTransitionIntegralsConst integrals) const
+{
+    unsigned int num_solutions = num_left * num_right;
+    std::vector<double> total(num_solutions, 0.);
+
+    const double* pdensity = density.data();
+    for(const auto& pair: orbital_pairs)
+    {
+        double integral = integrals->GetReducedMatrixElement(pair.first, pair.second);
+        if(integral)
+        {   for(unsigned int i = 0; i < num_solutions; i++)
+                total[i] += integral * pdensity[i];
+        }
+        pdensity += num_solutions;
+    }
+
+    return total;
+}
+
+double TransitionDensity::GetMatrixElement(pTransitionIntegralsConst integrals, unsigned int left_index, unsigned int right_index) const
+{
+    unsigned int num_solutions = num_left * num_right;
+    unsigned int offset = left_index * num_right + right_index;
+    double total = 0.;
+
+    for(unsigned int index = 0; index < orbital_pairs.size(); index++)
+    {
+        double rho = density[index * num_solutions + offset];
+        if(rho)
+            total += rho * integrals->GetReducedMatrixElement(orbital_pairs[index].first, orbital_pairs[index].second);
+    }
+
+    return total;
+}
+
+void TransitionDensity::GetProjectionAmplitudes(const LevelVector& levelvec, std::vector<double>& amplitudes, std::vector<unsigned int>& config_offsets)
+{
+    const RelativisticConfigList& configs = *levelvec.configs;
+    unsigned int num_levels = levelvec.levels.size();
+
+    std::vector<const double*> eigenvectors;
+    eigenvectors.reserve(num_levels);
+    for(const auto& level: levelvec.levels)
+        eigenvectors.push_back(level->GetEigenvector().data());
+
+    amplitudes.clear();
+    amplitudes.reserve(configs.projection_size() * num_levels);
+    config_offsets.clear();
+    config_offsets.reserve(configs.size());
+
+    unsigned int projection_index = 0;
+    for(auto config_it = configs.begin(); config_it != configs.end(); config_it++)
+    {
+        config_offsets.push_back(projection_index);
+
+        for(auto proj_it = config_it.projection_begin(); proj_it != config_it.projection_end(); proj_it++)
+        {
+            for(unsigned int level_index = 0; level_index < num_levels; level_index++)
+            {
+                double amplitude = 0.;
+                for(auto coeff = proj_it.CSF_begin(); coeff != proj_it.CSF_end(); coeff++)
+                    amplitude += (*coeff) * eigenvectors[level_index][coeff.index()];
+
+                amplitudes.push_back(amplitude);
+            }
+            projection_index++;
+        }
+    }
+}
+
+}
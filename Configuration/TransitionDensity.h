@@ -0,0 +1,76 @@
+#ifndef TRANSITION_DENSITY_H
+#define TRANSITION_DENSITY_H
+
+#include "ManyBodyOperator.h"
+#include "MBPT/OneElectronIntegrals.h"
+
+namespace Ambit
+{
+/** Reduced one-body transition density matrices between all levels of two LevelVectors.
+    For any one-body operator O of rank K and parity P,
+        < left_i | O | right_j > = Sum_{a,b} rho_ab(i, j) < a || o || b >
+    where < a || o || b > are the reduced one-electron integrals stored by TransitionIntegrals and
+    the many-body matrix element is between stretched states, as in ManyBodyOperator::GetMatrixElement().
+    The densities cost about the same as a single ManyBodyOperator::GetMatrixElement(), but then matrix
+    elements of any operator with the same K and P (e.g. at a different frequency or with RPA)
+    require only a contraction with its integrals.
+ */
+class TransitionDensity
+{
+public:
+    /** Calculate densities for operators with the same rank and parity as op. */
+    TransitionDensity(pSpinorMatrixElementConst op, const LevelVector& left_levels, const LevelVector& right_levels);
+
+    /** Calculate densities for several operators in a single pass over the configurations,
+        sharing the projection differences and amplitudes. Returns a density for each operator in ops;
+        operators with the same rank and parity share the same density.
+     */
+    static std::vector<std::shared_ptr<TransitionDensity>> Calculate(const std::vector<pSpinorMatrixElementConst>& ops, const LevelVector& left_levels, const LevelVector& right_levels);
+
+    /** True if op has the same rank and parity as the operator used to make the densities. */
+    bool IsCompatible(pSpinorMatrixElementConst op) const
+    {   return (op->GetK() == K && op->GetParity() == P);
+    }
+
+    int GetK() const { return K; }
+    Parity GetParity() const { return P; }
+
+    /** Number of orbital pairs (a, b) with non-zero density. */
+    unsigned int size() const { return orbital_pairs.size(); }
+
+    /** Returns < left | O | right > for each pair of levels, indexed by left_index * (num_right) + right_index.
+        PRE: integrals include all orbital pairs of the configurations.
+     */
+    std::vector<double> GetMatrixElements(pTransitionIntegralsConst integrals) const;
+
+    /** Returns < left_levels[left_index] | O | right_levels[right_index] >. */
+    double GetMatrixElement(pTransitionIntegralsConst integrals, unsigned int left_index, unsigned int right_index) const;
+
+protected:
+    /** Empty density (no orbital pairs) with rank K and parity P. */
+    TransitionDensity(int K, Parity P, const LevelVector& left_levels, const LevelVector& right_levels);
+
+    /** Fill all densities, which must be empty and have different symmetries, in a single pass. */
+    static void CalculateDensities(std::vector<TransitionDensity*>& densities, const LevelVector& left_levels, const LevelVector& right_levels);
+
+    /** Get amplitude of each projection in each level: Sum over CSFs of (CSF coefficient * eigenvector coefficient).
+        amplitudes[projection_index * num_levels + level_index], where projections of the ith config
+        start at config_offsets[i].
+     */
+    static void GetProjectionAmplitudes(const LevelVector& levelvec, std::vector<double>& amplitudes, std::vector<unsigned int>& config_offsets);
+
+protected:
+    int K;
+    Parity P;
+    unsigned int num_left;
+    unsigned int num_right;
+
+    std::vector<std::pair<OrbitalInfo, OrbitalInfo>> orbital_pairs;
+    std::vector<double> density;    //!< density[pair_index * num_left * num_right + left_index * num_right + right_index]
+};
+
+typedef std::shared_ptr<TransitionDensity> pTransitionDensity;
+typedef std::shared_ptr<const TransitionDensity> pTransitionDensityConst;
+
+}
+#endif
@@ -7,6 +7,58 @@
 
 namespace Ambit
 {
+BesselKernel::BesselKernel(int K, double p, const double* R, unsigned int size):
+    p(p), jK(size), jK1(size), jK2(size), djKdr(size), djK1dr(size)
+{
+    MathConstant* math = MathConstant::Instance();
+
+    for(unsigned int i = 0; i < size; i++)
+    {
+        double pR = p * R[i];
+        jK[i] = math->sph_bessel(K, pR);
+        jK1[i] = math->sph_bessel(K + 1, pR);
+        jK2[i] = math->sph_bessel(K + 2, pR);
+
+        // j_n'(z) = (n/z) j_n(z) - j_{n+1}(z)
+        djKdr[i] = p * (K/pR * jK[i] - jK1[i]);
+        djK1dr[i] = p * ((K + 1)/pR * jK1[i] - jK2[i]);
+    }
+}
+
+void MultipoleOperator::SetFrequency(double frequency)
+{
+    TimeDependentSpinorOperator::SetFrequency(frequency);
+
+    // p = omega/c, in atomic units
+    double p = fabs(omega)/MathConstant::Instance()->SpeedOfLightAU();
+    if(p < 1.e-6)
+    {   kernel = nullptr;
+        return;
+    }
+
+    pLattice lattice = integrator->GetLattice();
+    auto it = kernel_cache.find(p);
+    if(it != kernel_cache.end() && it->second->size() >= lattice->size())
+    {   kernel = it->second;
+        return;
+    }
+
+    if(kernel_cache.size() >= max_cached_kernels)
+        kernel_cache.clear();
+
+    kernel = std::make_shared<BesselKernel>(K, p, lattice->R(), lattice->size());
+    kernel_cache[p] = kernel;
+}
+
+pBesselKernelConst MultipoleOperator::GetBesselKernel(unsigned int size) const
+{
+    double p = fabs(omega)/MathConstant::Instance()->SpeedOfLightAU();
+    if(kernel && kernel->p == p && kernel->size() >= size)
+        return kernel;
+
+    return std::make_shared<BesselKernel>(K, p, integrator->GetLattice()->R(), size);
+}
+
 SpinorFunction EJOperator::ReducedApplyTo(const SpinorFunction& a, int kappa_b, bool conjugate) const
 {
     SpinorFunction ret(kappa_b);
@@ -52,15 +104,15 @@ SpinorFunction EJOperator::ReducedApplyTo(const SpinorFunction& a, int kappa_b,
                 kappa_diff_minus_one = -kappa_diff_minus_one;
             }
 
+            pBesselKernelConst bessel = GetBesselKernel(a.size());
             ret.resize(a.size());
             for(unsigned int i = 0; i < a.size(); i++)
             {
-                double pR = p * R[i];
-                double jK = math->sph_bessel(K, pR);
-                double djKdr = p * math->sph_bessel_prime(K, pR);
+                double jK = bessel->jK[i];
+                double djKdr = bessel->djKdr[i];
 
-                double jK1 = math->sph_bessel(K + 1, pR);
-                double djK1dr = p * math->sph_bessel_prime(K + 1, pR);
+                double jK1 = bessel->jK1[i];
+                double djK1dr = bessel->djK1dr[i];
 
                 ret.f[i] = a.f[i] * jK + a.g[i] * jK1 * kappa_diff_plus_one;
                 ret.dfdr[i] = a.dfdr[i] * jK + a.f[i] * djKdr
@@ -80,13 +132,14 @@ SpinorFunction EJOperator::ReducedApplyTo(const SpinorFunction& a, int kappa_b,
         {
             double kappa_diff = - double(kappa_b - a.Kappa())/double(K + 1);
 
+            pBesselKernelConst bessel = GetBesselKernel(a.size());
             ret.resize(a.size());
             for(unsigned int i = 0; i < ret.size(); i++)
             {
                 double pR = p * R[i];
-                double jK = math->sph_bessel(K, pR);
-                double jK1 = math->sph_bessel(K+1, pR);
-                double jK2 = math->sph_bessel(K+2, pR);
+                double jK = bessel->jK[i];
+                double jK1 = bessel->jK1[i];
+                double jK2 = bessel->jK2[i];
 
                 // Get primes and derivatives by recursion for speed
                 double jKp = K/pR * jK - jK1;                                   // j_K'
@@ -155,12 +208,12 @@ SpinorFunction MJOperator::ReducedApplyTo(const SpinorFunction& a, int kappa_b)
     {
         double kappa_plus = double(kappa_b + a.Kappa())/double(K + 1);
 
+        pBesselKernelConst bessel = GetBesselKernel(a.size());
         ret.resize(a.size());
         for(unsigned int i = 0; i < ret.size(); i++)
         {
-            double pR = p * R[i];
-            double jK = math->sph_bessel(K, pR);
-            double djKdr = p * math->sph_bessel_prime(K, pR);
+            double jK = bessel->jK[i];
+            double djKdr = bessel->djKdr[i];
 
             ret.f[i] = a.g[i] * jK;
             ret.dfdr[i] = a.dgdr[i] * jK + a.g[i] * djKdr;
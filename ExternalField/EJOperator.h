@@ -8,11 +8,52 @@
 
 namespace Ambit
 {
-class EJOperator : public TimeDependentSpinorOperator
+/** Spherical Bessel functions j_L(pr) on the lattice for L = K, K+1, K+2 with p = omega/c,
+    along with their radial derivatives d/dr j_L(pr) for L = K, K+1.
+ */
+struct BesselKernel
+{
+    BesselKernel(int K, double p, const double* R, unsigned int size);
+
+    unsigned int size() const { return jK.size(); }
+
+    double p;
+    std::vector<double> jK, jK1, jK2;
+    std::vector<double> djKdr, djK1dr;
+};
+
+typedef std::shared_ptr<const BesselKernel> pBesselKernelConst;
+
+/** Base class for electromagnetic multipole operators. The Bessel functions j_L(omega r/c) are
+    calculated once for each frequency and shared by all orbitals, so that applying the operator is
+    just a multiplication. Kernels of recently used frequencies are kept for reuse.
+ */
+class MultipoleOperator : public TimeDependentSpinorOperator
+{
+public:
+    MultipoleOperator(int J, Parity P, pIntegrator integration_strategy):
+        TimeDependentSpinorOperator(J, P, integration_strategy)
+    {}
+
+    /** Set frequency and get Bessel kernel for the current lattice. */
+    virtual void SetFrequency(double frequency) override;
+
+protected:
+    /** Get Bessel kernel at the current frequency with at least size points.
+        If the lattice has grown since SetFrequency(), a new kernel is calculated (but not stored).
+     */
+    pBesselKernelConst GetBesselKernel(unsigned int size) const;
+
+    pBesselKernelConst kernel;
+    std::map<double, pBesselKernelConst> kernel_cache;
+    static constexpr unsigned int max_cached_kernels = 16;
+};
+
+class EJOperator : public MultipoleOperator
 {
 public:
     EJOperator(int J, pIntegrator integration_strategy, TransitionGauge gauge = TransitionGauge::Length):
-        TimeDependentSpinorOperator(J, (J%2? Parity::odd: Parity::even), integration_strategy), gauge(gauge)
+        MultipoleOperator(J, (J%2? Parity::odd: Parity::even), integration_strategy), gauge(gauge)
     {}
 
     void SetGauge(TransitionGauge gauge_type) { gauge = gauge_type; }
@@ -40,11 +81,11 @@ protected:
     TransitionGauge gauge;
 };
 
-class MJOperator : public TimeDependentSpinorOperator
+class MJOperator : public MultipoleOperator
 {
 public:
     MJOperator(int J, pIntegrator integration_strategy):
-        TimeDependentSpinorOperator(J, (J%2? Parity::even: Parity::odd), integration_strategy)
+        MultipoleOperator(J, (J%2? Parity::even: Parity::odd), integration_strategy)
     {}
 
     /** M(J) || a > for our operator M(J). */
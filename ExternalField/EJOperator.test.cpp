@@ -10,8 +10,13 @@
 #include "Configuration/HamiltonianMatrix.h"
 #include "Configuration/ConfigGenerator.h"
 #include "Configuration/GFactor.h"
+#include "Configuration/TransitionDensity.h"
 #include "RPAOperator.h"
 
+#ifdef AMBIT_USE_OPENMP
+#include <omp.h>
+#endif
+
 using namespace Ambit;
 
 TEST(EJOperatorTester, LiTransitions)
@@ -318,6 +323,20 @@ TEST(EJOperatorTester, HeTransitions)
     reduced_matrix_element = matrix_element/MathConstant::Instance()->Electron3j(2, 0, 1, 2, 0);
     *logstream << "1s2 1S0 -> 1s2p 3P1: S_E1 = " << reduced_matrix_element * reduced_matrix_element << std::endl;
     EXPECT_NEAR(5.4e-8, reduced_matrix_element * reduced_matrix_element, 1.e-4);
+
+    // Contraction of transition densities should give the same matrix elements in both directions
+    TransitionDensity E1_density(E1, Even3, Odd3);
+    TransitionDensity E1_density_reverse(E1, Odd3, Even3);
+    std::vector<double> expected = E1_many_body.GetMatrixElement(Even3, Odd3);
+    std::vector<double> contracted = E1_density.GetMatrixElements(E1_matrix_elements);
+    ASSERT_EQ(expected.size(), contracted.size());
+    for(unsigned int i = 0; i < expected.size(); i++)
+        EXPECT_NEAR(expected[i], contracted[i], 1.e-10);
+
+    expected = E1_many_body.GetMatrixElement(Odd3, Even3);
+    for(unsigned int i = 0; i < Odd3.levels.size(); i++)
+        for(unsigned int j = 0; j < Even3.levels.size(); j++)
+            EXPECT_NEAR(expected[i * Even3.levels.size() + j], E1_density_reverse.GetMatrixElement(E1_matrix_elements, i, j), 1.e-10);
 }
 
 TEST(MJOperatorTester, HolesVsElectrons)
@@ -452,6 +471,53 @@ TEST(MJOperatorTester, HolesVsElectrons)
 
         m1_hole = M1_many_body.GetMatrixElement(levels, levels)[levels.levels.size() * 2 + 1];
 
+        // Diagonal terms of the transition density include holes
+        TransitionDensity M1_density(M1, levels, levels);
+        std::vector<double> expected = M1_many_body.GetMatrixElement(levels, levels);
+        std::vector<double> contracted = M1_density.GetMatrixElements(M1_matrix_elements);
+        for(unsigned int i = 0; i < expected.size(); i++)
+            EXPECT_NEAR(expected[i], contracted[i], 1.e-10);
+
+        // Densities of several operators calculated together, sharing M1 and E2 with the same parity
+        pTimeDependentSpinorOperator E2 = std::make_shared<EJOperator>(2, integrator);
+        pTransitionIntegrals E2_matrix_elements(new TransitionIntegrals(orbitals, E2));
+        E2_matrix_elements->CalculateOneElectronIntegrals(orbitals->valence, orbitals->valence);
+        ManyBodyOperator<pTransitionIntegrals> E2_many_body(E2_matrix_elements);
+
+        std::vector<pTransitionDensity> fused = TransitionDensity::Calculate({M1, E2, M1}, levels, levels);
+        ASSERT_EQ(3, fused.size());
+        EXPECT_EQ(fused[0], fused[2]);
+        EXPECT_EQ(M1_density.size(), fused[0]->size());
+
+        contracted = fused[0]->GetMatrixElements(M1_matrix_elements);
+        for(unsigned int i = 0; i < expected.size(); i++)
+            EXPECT_NEAR(expected[i], contracted[i], 1.e-10);
+
+        expected = E2_many_body.GetMatrixElement(levels, levels);
+        contracted = fused[1]->GetMatrixElements(E2_matrix_elements);
+        for(unsigned int i = 0; i < expected.size(); i++)
+            EXPECT_NEAR(expected[i], contracted[i], 1.e-10);
+
+#ifdef AMBIT_USE_OPENMP
+        // Several threads should give the same densities as one
+        int max_threads = omp_get_max_threads();
+        omp_set_num_threads(1);
+        std::vector<pTransitionDensity> serial = TransitionDensity::Calculate({M1, E2}, levels, levels);
+        omp_set_num_threads(mmax(4, max_threads));
+        std::vector<pTransitionDensity> threaded = TransitionDensity::Calculate({M1, E2}, levels, levels);
+        omp_set_num_threads(max_threads);
+
+        for(unsigned int d = 0; d < 2; d++)
+        {
+            pTransitionIntegrals d_matrix_elements = (d == 0? M1_matrix_elements: E2_matrix_elements);
+            std::vector<double> serial_contracted = serial[d]->GetMatrixElements(d_matrix_elements);
+            std::vector<double> threaded_contracted = threaded[d]->GetMatrixElements(d_matrix_elements);
+            ASSERT_EQ(serial_contracted.size(), threaded_contracted.size());
+            for(unsigned int i = 0; i < serial_contracted.size(); i++)
+                EXPECT_NEAR(serial_contracted[i], threaded_contracted[i], 1.e-12);
+        }
+#endif
+
         // Convert to strength = (reduced matrix element)^2
         m1_hole = m1_hole/math->Electron3j(sym.GetTwoJ(), sym.GetTwoJ(), 1, sym.GetTwoJ(), -sym.GetTwoJ());
         m1_hole = m1_hole * m1_hole;
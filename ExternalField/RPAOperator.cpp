@@ -82,15 +82,25 @@ void RPAOperator::ClearRPACore()
 
 SpinorFunction RPAOperator::ReducedApplyTo(const SpinorFunction& a, int kappa_b) const
 {
-    return ReducedApplyTo(a, kappa_b, false);
+    return ReducedApplyTo(a, kappa_b, false, *hartreeY);
 }
 
 SpinorFunction RPAOperator::ConjugateReducedApplyTo(const SpinorFunction& a, int kappa_b) const
 {
-    return ReducedApplyTo(a, kappa_b, !static_rpa);
+    return ReducedApplyTo(a, kappa_b, !static_rpa, *hartreeY);
 }
 
-SpinorFunction RPAOperator::ReducedApplyTo(const SpinorFunction& a, int kappa_b, bool conjugate) const
+SpinorFunction RPAOperator::ReducedApplyTo(const SpinorFunction& a, int kappa_b, HartreeYBase& hartreeY_op) const
+{
+    return ReducedApplyTo(a, kappa_b, false, hartreeY_op);
+}
+
+SpinorFunction RPAOperator::ConjugateReducedApplyTo(const SpinorFunction& a, int kappa_b, HartreeYBase& hartreeY_op) const
+{
+    return ReducedApplyTo(a, kappa_b, !static_rpa, hartreeY_op);
+}
+
+SpinorFunction RPAOperator::ReducedApplyTo(const SpinorFunction& a, int kappa_b, bool conjugate, HartreeYBase& hartreeY_op) const
 {
     SpinorFunction ret(kappa_b);
     MathConstant* math = MathConstant::Instance();
@@ -149,16 +159,16 @@ SpinorFunction RPAOperator::ReducedApplyTo(const SpinorFunction& a, int kappa_b,
 
                     if(static_rpa)
                     {
-                        hartreeY->SetParameters(K, b, beta);
-                        ret += hartreeY->ApplyTo(a, ret.Kappa()) * coeff * 2.;
+                        hartreeY_op.SetParameters(K, b, beta);
+                        ret += hartreeY_op.ApplyTo(a, ret.Kappa()) * coeff * 2.;
                     }
                     else
                     {
-                        hartreeY->SetParameters(K, b, beta);
-                        ret += hartreeY->ApplyTo(a, ret.Kappa()) * coeff;
+                        hartreeY_op.SetParameters(K, b, beta);
+                        ret += hartreeY_op.ApplyTo(a, ret.Kappa()) * coeff;
 
-                        hartreeY->SetParameters(K, betaplus, b);
-                        ret += hartreeY->ApplyTo(a, ret.Kappa()) * coeff;
+                        hartreeY_op.SetParameters(K, betaplus, b);
+                        ret += hartreeY_op.ApplyTo(a, ret.Kappa()) * coeff;
                     }
                 }
             }
@@ -183,13 +193,13 @@ SpinorFunction RPAOperator::ReducedApplyTo(const SpinorFunction& a, int kappa_b,
 
                         if(static_rpa)
                         {
-                            hartreeY->SetParameters(k, beta, pa);
-                            ret += hartreeY->ApplyTo(*b, ret.Kappa()) * coeff;
+                            hartreeY_op.SetParameters(k, beta, pa);
+                            ret += hartreeY_op.ApplyTo(*b, ret.Kappa()) * coeff;
                         }
                         else
                         {
-                            hartreeY->SetParameters(k, betaplus, pa);
-                            ret += hartreeY->ApplyTo(*b, ret.Kappa()) * coeff;
+                            hartreeY_op.SetParameters(k, betaplus, pa);
+                            ret += hartreeY_op.ApplyTo(*b, ret.Kappa()) * coeff;
                         }
                     }
                 }
@@ -213,8 +223,8 @@ SpinorFunction RPAOperator::ReducedApplyTo(const SpinorFunction& a, int kappa_b,
                     {
                         coeff *= occupancy_factor;
 
-                        hartreeY->SetParameters(k, b, pa);
-                        ret += hartreeY->ApplyTo(*beta, ret.Kappa()) * coeff;
+                        hartreeY_op.SetParameters(k, b, pa);
+                        ret += hartreeY_op.ApplyTo(*beta, ret.Kappa()) * coeff;
                     }
                 }
             }
@@ -40,11 +40,20 @@ public:
     /** Return (f + deltaVhf)^{\dagger}||a> */
     SpinorFunction ConjugateReducedApplyTo(const SpinorFunction& a, int kappa_b) const override;
 
+    /** As ReducedApplyTo() and ConjugateReducedApplyTo(), but use hartreeY_op to calculate deltaVhf.
+        HartreeY is not thread-safe, so each thread should use its own clone of GetHartreeY().
+     */
+    SpinorFunction ReducedApplyTo(const SpinorFunction& a, int kappa_b, HartreeYBase& hartreeY_op) const;
+    SpinorFunction ConjugateReducedApplyTo(const SpinorFunction& a, int kappa_b, HartreeYBase& hartreeY_op) const;
+
+    /** Get HartreeY operator used for deltaVhf. */
+    pHartreeY GetHartreeY() const { return hartreeY; }
+
     /** Return direct expectation value <deltaVhf> */
     RadialFunction GetRPAField() const;
 
 protected:
-    SpinorFunction ReducedApplyTo(const SpinorFunction& a, int kappa_b, bool conjugate) const;
+    SpinorFunction ReducedApplyTo(const SpinorFunction& a, int kappa_b, bool conjugate, HartreeYBase& hartreeY_op) const;
 
 protected:
     pSpinorOperator external;
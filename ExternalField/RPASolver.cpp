@@ -3,6 +3,10 @@
 #include "Include.h"
 #include "Basis/BSplineBasis.h"
 
+#ifdef AMBIT_USE_OPENMP
+#include <omp.h>
+#endif
+
 namespace Ambit
 {
 void RPASolver::SolveRPACore(pHFOperatorConst hf, pRPAOperator rpa)
@@ -11,6 +15,7 @@ void RPASolver::SolveRPACore(pHFOperatorConst hf, pRPAOperator rpa)
 
     // Get basis for DeltaOrbitals: map from kappa to complete basis
     basis.clear();
+    basis_projection.clear();
     pLattice lattice = hf->GetLattice();
     pIntegrator integrator = hf->GetIntegrator();
 
@@ -44,6 +49,7 @@ void RPASolver::SolveRPACore(pHFOperatorConst hf, pRPAOperator rpa)
                     }
 
                     basis[kappa] = spline_basis;
+                    MakeBasisProjection(kappa);
                 }
             }
         }
@@ -57,7 +63,34 @@ void RPASolver::SolveRPACore(pHFOperatorConst hf, pRPAOperator rpa)
 
     pCore next_states(rpa_core->Clone());
 
-    double deltaE, max_deltaE;
+    // The deltaOrbitals of next_states are independent within each iteration,
+    // so collect them all and iterate them in parallel
+    std::vector<pRPAOrbital> channel_parents;
+    std::vector<std::pair<pDeltaOrbital, pDeltaOrbital>> channels;
+    for(auto pair: *next_states)
+    {
+        pRPAOrbital rpa_orbital = std::dynamic_pointer_cast<RPAOrbital>(pair.second);
+        if(rpa_orbital)
+        {
+            for(auto& deltapsi: rpa_orbital->deltapsi)
+            {   channel_parents.push_back(rpa_orbital);
+                channels.push_back(deltapsi);
+            }
+        }
+    }
+
+    int num_channels = channels.size();
+    std::vector<double> old_energies(num_channels);
+    std::vector<double> deltaEs(num_channels);
+
+#ifdef AMBIT_USE_OPENMP
+    // The HartreeY operator is not thread-safe, so make a separate clone for each thread
+    std::vector<pHartreeY> hartreeY_operators;
+    for(int ii = 0; ii < omp_get_max_threads(); ++ii)
+        hartreeY_operators.emplace_back(rpa->GetHartreeY()->Clone());
+#endif
+
+    double max_deltaE;
     double max_norm;
     unsigned int loop = 0;
 
@@ -72,36 +105,44 @@ void RPASolver::SolveRPACore(pHFOperatorConst hf, pRPAOperator rpa)
             *logstream << "RPA Iteration: " << loop << std::endl;
 
         // Calculate new states
-        for(auto pair: *next_states)
+        int i;
+    #ifdef AMBIT_USE_OPENMP
+        #pragma omp parallel for private(i) schedule(dynamic)
+    #endif
+        for(i = 0; i < num_channels; i++)
         {
-            pRPAOrbital rpa_orbital = std::dynamic_pointer_cast<RPAOrbital>(pair.second);
-            if(rpa_orbital)
-            {
-                if(debug)
-                    *logstream << "  RPA orbital " << std::setw(4) << rpa_orbital->Name() << std::endl;
+        #ifdef AMBIT_USE_OPENMP
+            pHartreeY my_hartreeY = hartreeY_operators[omp_get_thread_num()];
+        #else
+            pHartreeY my_hartreeY = rpa->GetHartreeY();
+        #endif
 
-                for(auto deltapsi: rpa_orbital->deltapsi)
-                {
-                    pDeltaOrbital orbital = deltapsi.first;
-                    double old_energy = orbital->DeltaEnergy();
+            old_energies[i] = channels[i].first->DeltaEnergy();
 
-                    if(is_static)
-                        deltaE = IterateDeltaOrbital(orbital, rpa, TDHF_propnew);
-                    else
-                        deltaE = IterateDeltaOrbital(deltapsi, rpa, TDHF_propnew);
-
-                    double norm = orbital->Norm(integrator);
-                    max_norm = mmax(norm, max_norm);
-                    max_deltaE = mmax(fabs(deltaE), max_deltaE);
-
-                    if(debug)
-                        *logstream << "    kappa = " << std::setw(3) << orbital->Kappa()
-                                   << "  DE = " << std::setprecision(12) << old_energy
-                                   << "  deltaDE = " << std::setprecision(4) << deltaE
-                                   << "  size: (" << orbital->size()
-                                   << ") " << lattice->R(orbital->size())
-                                   << "  norm = " << orbital->Norm(integrator) << std::endl;
-                }
+            if(is_static)
+                deltaEs[i] = IterateDeltaOrbital(channels[i].first, rpa, TDHF_propnew, my_hartreeY);
+            else
+                deltaEs[i] = IterateDeltaOrbital(channels[i], rpa, TDHF_propnew, my_hartreeY);
+        }
+
+        for(i = 0; i < num_channels; i++)
+        {
+            pDeltaOrbital orbital = channels[i].first;
+            double norm = orbital->Norm(integrator);
+            max_norm = mmax(norm, max_norm);
+            max_deltaE = mmax(fabs(deltaEs[i]), max_deltaE);
+
+            if(debug)
+            {
+                if(i == 0 || channel_parents[i] != channel_parents[i-1])
+                    *logstream << "  RPA orbital " << std::setw(4) << channel_parents[i]->Name() << std::endl;
+
+                *logstream << "    kappa = " << std::setw(3) << orbital->Kappa()
+                           << "  DE = " << std::setprecision(12) << old_energies[i]
+                           << "  deltaDE = " << std::setprecision(4) << deltaEs[i]
+                           << "  size: (" << orbital->size()
+                           << ") " << lattice->R(orbital->size())
+                           << "  norm = " << norm << std::endl;
             }
         }
 
@@ -137,6 +178,7 @@ double RPASolver::CalculateRPAExcited(pRPAOrbital orbital, pRPAOperatorConst rpa
                 spline_basis = basis_maker->GeneratePositiveBasis(hf0, kappa);
 
             basis[kappa] = spline_basis;
+            MakeBasisProjection(kappa);
         }
     }
 
@@ -184,7 +226,7 @@ void RPASolver::CreateDeltaOrbitals(pRPAOrbital orbital, pRPAOperatorConst rpa)
     }
 }
 
-double RPASolver::IterateDeltaOrbital(pDeltaOrbital orbital, pRPAOperatorConst rpa, double propnew) const
+double RPASolver::IterateDeltaOrbital(pDeltaOrbital orbital, pRPAOperatorConst rpa, double propnew, pHartreeY hartreeY) const
 {
     int kappa = orbital->Kappa();
     double start_DE = orbital->DeltaEnergy();
@@ -196,8 +238,11 @@ double RPASolver::IterateDeltaOrbital(pDeltaOrbital orbital, pRPAOperatorConst r
 
     pIntegrator integrator = rpa->GetIntegrator();
 
+    if(!hartreeY)
+        hartreeY = rpa->GetHartreeY();
+
     // Apply (f + deltaV)||a>
-    SpinorFunction X_a = rpa->ReducedApplyTo(*parent, orbital->Kappa());
+    SpinorFunction X_a = rpa->ReducedApplyTo(*parent, orbital->Kappa(), *hartreeY);
 
     double new_DE = start_DE * (1. - propnew);
 
@@ -210,34 +255,38 @@ double RPASolver::IterateDeltaOrbital(pDeltaOrbital orbital, pRPAOperatorConst r
 
     (*orbital) *= (1.-propnew);
 
-    for(const auto& basis_pair: *basis.at(kappa))
+    const BasisProjection& projection = basis_projection.at(kappa);
+    Eigen::VectorXd coefficients = GetBasisOverlaps(kappa, X_a, *integrator);
+
+    for(unsigned int i = 0; i < projection.orbitals.size(); i++)
     {
         // Remove parent from basis if necessary since deltaOrbital must be orthogonal to parent
-        if((parent_info.PQN() != basis_pair.first.PQN()) ||
-           (parent_info.Kappa() != basis_pair.first.Kappa()))
+        if((parent_info.PQN() != projection.info[i].PQN()) ||
+           (parent_info.Kappa() != projection.info[i].Kappa()))
         {
-            pOrbitalConst beta = basis_pair.second;
-
-            double coeff = integrator->GetInnerProduct(*beta, X_a);
-            coeff = -coeff/(beta->Energy() - parent_energy);
-
-            (*orbital) += (*beta) * coeff * propnew;
+            double beta_energy = projection.orbitals[i]->Energy();
+            double coeff = -coefficients[i]/(beta_energy - parent_energy);
+            coefficients[i] = coeff * propnew;
 
             // Get new deltaEnergy
             if(kappa != parent->Kappa())
             {
-                new_DE += propnew * beta->Energy() * coeff * coeff;
+                new_DE += propnew * beta_energy * coeff * coeff;
             }
         }
+        else
+            coefficients[i] = 0.;
     }
 
+    AddBasisExpansion(kappa, coefficients, *orbital);
+
     orbital->SetDeltaEnergy(new_DE);
     delta_DE = new_DE - start_DE;
 
     return delta_DE;
 }
 
-double RPASolver::IterateDeltaOrbital(std::pair<pDeltaOrbital, pDeltaOrbital>& orbitals, pRPAOperatorConst rpa, double propnew) const
+double RPASolver::IterateDeltaOrbital(std::pair<pDeltaOrbital, pDeltaOrbital>& orbitals, pRPAOperatorConst rpa, double propnew, pHartreeY hartreeY) const
 {
     pDeltaOrbital alpha = orbitals.first;
     pDeltaOrbital alphaplus = orbitals.second;
@@ -252,9 +301,12 @@ double RPASolver::IterateDeltaOrbital(std::pair<pDeltaOrbital, pDeltaOrbital>& o
 
     pIntegrator integrator = rpa->GetIntegrator();
 
+    if(!hartreeY)
+        hartreeY = rpa->GetHartreeY();
+
     // Apply (f + deltaV)||a>
-    SpinorFunction X_a = rpa->ReducedApplyTo(*parent, kappa);
-    SpinorFunction Y_a = rpa->ConjugateReducedApplyTo(*parent, kappa);
+    SpinorFunction X_a = rpa->ReducedApplyTo(*parent, kappa, *hartreeY);
+    SpinorFunction Y_a = rpa->ConjugateReducedApplyTo(*parent, kappa, *hartreeY);
 
     double new_DE = start_DE * (1. - propnew);
 
@@ -269,33 +321,100 @@ double RPASolver::IterateDeltaOrbital(std::pair<pDeltaOrbital, pDeltaOrbital>& o
 
     double omega = rpa->GetFrequency();
 
-    for(const auto& basis_pair: *basis.at(kappa))
+    const BasisProjection& projection = basis_projection.at(kappa);
+    Eigen::VectorXd coefficients = GetBasisOverlaps(kappa, X_a, *integrator);
+    Eigen::VectorXd coefficients_plus = GetBasisOverlaps(kappa, Y_a, *integrator);
+
+    for(unsigned int i = 0; i < projection.orbitals.size(); i++)
     {
         // Remove parent from basis if necessary since deltaOrbital must be orthogonal to parent
-        if((parent_info.PQN() != basis_pair.first.PQN()) ||
-           (parent_info.Kappa() != basis_pair.first.Kappa()))
+        if((parent_info.PQN() != projection.info[i].PQN()) ||
+           (parent_info.Kappa() != projection.info[i].Kappa()))
         {
-            pOrbitalConst beta = basis_pair.second;
+            double beta_energy = projection.orbitals[i]->Energy();
 
-            double coeff = integrator->GetInnerProduct(*beta, X_a);
-            coeff = -coeff/(beta->Energy() - parent_energy - omega);
-            (*alpha) += (*beta) * coeff * propnew;
+            double coeff = -coefficients[i]/(beta_energy - parent_energy - omega);
+            coefficients[i] = coeff * propnew;
 
-            double coeffplus = integrator->GetInnerProduct(*beta, Y_a);
-            coeffplus = -coeffplus/(beta->Energy() - parent_energy + omega);
-            (*alphaplus) += (*beta) * coeffplus * propnew;
+            double coeffplus = -coefficients_plus[i]/(beta_energy - parent_energy + omega);
+            coefficients_plus[i] = coeffplus * propnew;
 
             // Get new deltaEnergy
             if(kappa != parent->Kappa())
             {
-                new_DE += propnew * beta->Energy() * coeff * coeff;
+                new_DE += propnew * beta_energy * coeff * coeff;
             }
         }
+        else
+        {   coefficients[i] = 0.;
+            coefficients_plus[i] = 0.;
+        }
     }
 
+    AddBasisExpansion(kappa, coefficients, *alpha);
+    AddBasisExpansion(kappa, coefficients_plus, *alphaplus);
+
     alpha->SetDeltaEnergy(new_DE);
     delta_DE = new_DE - start_DE;
 
     return delta_DE;
 }
+
+void RPASolver::MakeBasisProjection(int kappa)
+{
+    const OrbitalMap& spline_basis = *basis.at(kappa);
+
+    BasisProjection& projection = basis_projection[kappa];
+    projection.info.clear();
+    projection.orbitals.clear();
+    projection.functions.clear();
+    projection.size = 0;
+
+    for(const auto& pair: spline_basis)
+    {   projection.info.push_back(pair.first);
+        projection.orbitals.push_back(pair.second);
+        projection.functions.push_back(pair.second.get());
+        projection.size = mmax(projection.size, pair.second->size());
+    }
+
+    unsigned int size = projection.size;
+    projection.basis_functions.setZero(projection.orbitals.size(), 4 * size);
+
+    for(unsigned int row = 0; row < projection.orbitals.size(); row++)
+    {
+        const Orbital& beta = *projection.orbitals[row];
+        for(unsigned int i = 0; i < beta.size(); i++)
+        {   projection.basis_functions(row, i) = beta.f[i];
+            projection.basis_functions(row, size + i) = beta.g[i];
+            projection.basis_functions(row, 2 * size + i) = beta.dfdr[i];
+            projection.basis_functions(row, 3 * size + i) = beta.dgdr[i];
+        }
+    }
+}
+
+Eigen::VectorXd RPASolver::GetBasisOverlaps(int kappa, const SpinorFunction& a, const Integrator& integrator) const
+{
+    const BasisProjection& projection = basis_projection.at(kappa);
+    std::vector<double> overlaps = integrator.GetInnerProducts(projection.functions, a);
+
+    return Eigen::Map<Eigen::VectorXd>(overlaps.data(), overlaps.size());
+}
+
+void RPASolver::AddBasisExpansion(int kappa, const Eigen::VectorXd& coefficients, SpinorFunction& orbital) const
+{
+    const BasisProjection& projection = basis_projection.at(kappa);
+    unsigned int size = projection.size;
+
+    Eigen::RowVectorXd expansion = coefficients.transpose() * projection.basis_functions;
+
+    if(orbital.size() < size)
+        orbital.resize(size);
+
+    for(unsigned int i = 0; i < size; i++)
+    {   orbital.f[i] += expansion[i];
+        orbital.g[i] += expansion[size + i];
+        orbital.dfdr[i] += expansion[2 * size + i];
+        orbital.dgdr[i] += expansion[3 * size + i];
+    }
+}
 }
@@ -3,8 +3,10 @@
 
 #include "HartreeFock/Core.h"
 #include "HartreeFock/HFOperator.h"
+#include "HartreeFock/HartreeY.h"
 #include "Basis/BSplineBasis.h"
 #include "RPAOrbital.h"
+#include <Eigen/Dense>
 
 namespace Ambit
 {
@@ -46,24 +48,52 @@ public:
 
     /** Iterate a single deltaOrbital.
         Return change in its deltaEnergy.
+        If hartreeY is supplied it is used in place of rpa->GetHartreeY() (e.g. a clone for this thread).
      */
-    double IterateDeltaOrbital(pDeltaOrbital orbital, std::shared_ptr<const RPAOperator> rpa, double propnew) const;
+    double IterateDeltaOrbital(pDeltaOrbital orbital, std::shared_ptr<const RPAOperator> rpa, double propnew, pHartreeY hartreeY = nullptr) const;
 
     /** Iterate a pair of deltaOrbitals (for frequency-dependent RPA).
         Return change in deltaEnergy of first orbital.
+        If hartreeY is supplied it is used in place of rpa->GetHartreeY() (e.g. a clone for this thread).
      */
-    double IterateDeltaOrbital(std::pair<pDeltaOrbital, pDeltaOrbital>& orbitals, std::shared_ptr<const RPAOperator> rpa, double propnew) const;
+    double IterateDeltaOrbital(std::pair<pDeltaOrbital, pDeltaOrbital>& orbitals, std::shared_ptr<const RPAOperator> rpa, double propnew, pHartreeY hartreeY = nullptr) const;
 
     /** Set the weighting of successive TDHF loops.
         PRE: 0 < propnew <= 1
      */
     void SetTDHFWeighting(double propnew) { TDHF_propnew = propnew; }
 
+protected:
+    /** Basis for one kappa, with upper and lower components and derivatives of each basis orbital
+        stored in a row of basis_functions, so that deltaOrbitals can be updated in coefficient form
+        and expanded on the lattice with a single product.
+        Overlaps < beta | a > go through Integrator::GetInnerProducts(), which for SimpsonsIntegrator
+        folds the integration weights into a once and takes a dot product with each beta.
+     */
+    struct BasisProjection
+    {
+        std::vector<OrbitalInfo> info;
+        std::vector<pOrbitalConst> orbitals;
+        std::vector<const SpinorFunction*> functions;   //!< Same as orbitals, for Integrator::GetInnerProducts()
+        unsigned int size;          //!< Size of largest basis orbital
+        Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> basis_functions; //!< [ f | g | dfdr | dgdr ]
+    };
+
+    /** Make basis_projection[kappa] from basis[kappa]. */
+    void MakeBasisProjection(int kappa);
+
+    /** Return < beta | a > for all beta in basis_projection[kappa]. */
+    Eigen::VectorXd GetBasisOverlaps(int kappa, const SpinorFunction& a, const Integrator& integrator) const;
+
+    /** orbital += Sum_i coefficients[i] * basis_projection[kappa].orbitals[i] */
+    void AddBasisExpansion(int kappa, const Eigen::VectorXd& coefficients, SpinorFunction& orbital) const;
+
 protected:
     pBSplineBasis basis_maker;
     pHFOperatorConst hf0;               //!< Keep HF operator for making additional basis orbitals
     bool include_dirac_sea;
     std::map<int, pOrbitalMap> basis;   //!< DeltaOrbital basis for each kappa
+    std::map<int, BasisProjection> basis_projection;
 
     double TDHF_propnew = 0.5;          //!< Weighting to apply to each iteration
     double EnergyTolerance = 1.e-14;
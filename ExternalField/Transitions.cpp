@@ -5,6 +5,11 @@
 #include "TimeDependentSpinorOperator.h"
 #include "ExternalField/RPAOperator.h"
 #include "ExternalField/RPASolver.h"
+#include <algorithm>
+
+#ifdef AMBIT_USE_OPENMP
+#include <omp.h>
+#endif
 
 namespace Ambit
 {
@@ -20,6 +25,23 @@ void TransitionCalculator::CalculateAndPrint()
     bool all_below = user_input.VariableExists("AllBelow");
     bool print_integrals = user_input.search("--print-integrals");
 
+    use_frequency_grid = user_input.search("--frequency-grid");
+    if(use_frequency_grid)
+    {   frequency_grid_step = user_input("FrequencyGrid/Step", 0.02);
+        frequency_grid_tolerance = user_input("FrequencyGrid/Tolerance", 1.e-5);
+        frequency_grid_max_refinements = user_input("FrequencyGrid/MaxRefinements", 6);
+        frequency_grid_max_solves = user_input("FrequencyGrid/MaxSolves", 4);
+
+        if(frequency_grid_step <= 0.)
+        {   *errstream << "FrequencyGrid/Step must be positive (using 0.02)." << std::endl;
+            frequency_grid_step = 0.02;
+        }
+        if(frequency_grid_max_refinements > 20)
+        {   *errstream << "FrequencyGrid/MaxRefinements is too large (using 20)." << std::endl;
+            frequency_grid_max_refinements = 20;
+        }
+    }
+
     *outstream << "\n";
     PrintHeader();
 
@@ -32,52 +54,113 @@ void TransitionCalculator::CalculateAndPrint()
     for(int i = 0; i < num_transitions; i++)
         CalculateTransition(user_input("MatrixElements", "", i));
 
-    if(!all_below)
-    {
-        if(!num_transitions)
-            *outstream << "  No transitions requested." << std::endl;
-
-        return;
-    }
-
     // Calculate all transitions of a certain type below a given energy
-    double max_energy = user_input("AllBelow", 0.0);
-    bool found_one = false;
+    if(all_below)
+        CalculateAllBelow(user_input("AllBelow", 0.0));
+    else if(!num_transitions)
+        *outstream << "  No transitions requested." << std::endl;
 
-    auto left_it = levels->begin();
-    while(left_it != levels->end())
+    // Densities are not needed by this calculator again
+    density_library->Release(op);
+}
+
+void TransitionCalculator::CalculateAllBelow(double max_energy)
+{
+    // Collect all pairs of symmetries with levels below max_energy
+    std::vector<TransitionJob> jobs;
+    for(auto left_it = levels->begin(); left_it != levels->end(); left_it++)
     {
-        auto right_it = left_it;
-        while(right_it != levels->end())
+        LevelVector left_vec = levels->GetLevels(*left_it);
+        unsigned int num_left = 0;
+        while(num_left < left_vec.levels.size() && left_vec.levels[num_left]->GetEnergy() <= max_energy)
+            num_left++;
+
+        if(num_left == 0)
+            continue;
+
+        for(auto right_it = left_it; right_it != levels->end(); right_it++)
         {
             if(TransitionExists((*left_it)->GetSymmetry(), (*right_it)->GetSymmetry()))
             {
-                LevelVector left_vec = levels->GetLevels(*left_it);
-                for(int i = 0; i < left_vec.levels.size(); i++)
-                {
-                    if(left_vec.levels[i]->GetEnergy() > max_energy)
-                        break;
-
-                    LevelVector right_vec = levels->GetLevels(*right_it);
-                    for(int j = 0; j < right_vec.levels.size(); j++)
-                    {
-                        if(right_vec.levels[j]->GetEnergy() > max_energy)
-                            break;
+                LevelVector right_vec = levels->GetLevels(*right_it);
+                unsigned int num_right = 0;
+                while(num_right < right_vec.levels.size() && right_vec.levels[num_right]->GetEnergy() <= max_energy)
+                    num_right++;
 
-                        found_one = true;
-                        CalculateTransition(std::make_pair(*left_it, i), std::make_pair(*right_it, j));
-                    }
-                }
+                if(num_right)
+                    jobs.push_back({*left_it, *right_it, left_vec, right_vec, num_left, num_right});
             }
-            right_it++;
         }
-        left_it++;
     }
 
-    if(!found_one)
+    if(jobs.empty())
     {   *outstream << "  No transitions below E = " << max_energy << std::endl;
         return;
     }
+
+    CalculateTransitions(jobs);
+
+    // Print in order
+    for(const auto& job: jobs)
+        for(unsigned int i = 0; i < job.num_left; i++)
+            for(unsigned int j = 0; j < job.num_right; j++)
+                CalculateTransition(std::make_pair(job.left, i), std::make_pair(job.right, j));
+}
+
+void TransitionCalculator::CalculateTransitions(const std::vector<TransitionJob>& jobs)
+{
+    int num_jobs = jobs.size();
+    std::vector<pTransitionDensityConst> job_densities(num_jobs);
+
+    // Find densities that are already stored
+    std::vector<int> new_jobs;
+    for(int k = 0; k < num_jobs; k++)
+    {
+        job_densities[k] = density_library->Find(jobs[k].left, jobs[k].right, op);
+        if(!job_densities[k])
+            new_jobs.push_back(k);
+    }
+
+    // Symmetry pairs are independent, so share them between threads if there are enough of them.
+    // Otherwise (or with more than one processor) each density is shared between all processors
+    // and threads, so they are done one at a time.
+    int num_new_jobs = new_jobs.size();
+    std::vector<std::vector<pTransitionDensity>> new_densities(num_new_jobs);
+    int kk;
+#ifdef AMBIT_USE_OPENMP
+    #pragma omp parallel for private(kk) schedule(dynamic) if(NumProcessors == 1 && num_new_jobs >= omp_get_max_threads())
+#endif
+    for(kk = 0; kk < num_new_jobs; kk++)
+    {
+        const TransitionJob& job = jobs[new_jobs[kk]];
+        new_densities[kk] = density_library->Calculate(job.left, job.left_levels, job.right, job.right_levels, op);
+    }
+
+    for(kk = 0; kk < num_new_jobs; kk++)
+    {
+        const TransitionJob& job = jobs[new_jobs[kk]];
+        density_library->Store(job.left, job.right, new_densities[kk]);
+        job_densities[new_jobs[kk]] = new_densities[kk].front();
+    }
+
+    // Integrals of frequency-independent operators are calculated once and shared by all jobs.
+    // Otherwise each transition needs integrals at its own frequency (in CalculateTransition).
+    pTimeDependentSpinorOperator tdop = std::dynamic_pointer_cast<TimeDependentSpinorOperator>(op);
+    if(variable_frequency_op && tdop)
+        return;
+
+    CalculateStaticIntegrals();
+
+    std::vector<std::vector<double>> values(num_jobs);
+    int k;
+#ifdef AMBIT_USE_OPENMP
+    #pragma omp parallel for private(k) schedule(dynamic)
+#endif
+    for(k = 0; k < num_jobs; k++)
+        values[k] = job_densities[k]->GetMatrixElements(integrals);
+
+    for(k = 0; k < num_jobs; k++)
+        StoreMatrixElements(jobs[k].left, jobs[k].right, values[k], jobs[k].right_levels.levels.size());
 }
 
 void TransitionCalculator::PrintAll() const
@@ -201,7 +284,22 @@ double TransitionCalculator::CalculateTransition(const LevelID& left, const Leve
             }
 
             pTimeDependentSpinorOperator tdop = std::dynamic_pointer_cast<TimeDependentSpinorOperator>(op);
-            if(variable_frequency_op && tdop)
+            if(variable_frequency_op && tdop && use_frequency_grid)
+            {
+                const Level& left_level = *(left_levels.levels[left.second]);
+                const Level& right_level = *(right_levels.levels[right.second]);
+                double freq = left_level.GetEnergy() - right_level.GetEnergy();
+
+                pTransitionDensityConst density = GetTransitionDensity(left, left_levels, right, right_levels);
+                if(!InterpolateMatrixElement(*density, freq, left.second, right.second, return_value))
+                {
+                    // Grid isn't fine enough here: calculate at exact frequency
+                    return_value = density->GetMatrixElement(CalculateIntegrals(freq), left.second, right.second);
+                }
+
+                matrix_elements.insert(std::make_pair(id, return_value));
+            }
+            else if(variable_frequency_op && tdop)
             {
                 // Clear integrals if frequency has changed
                 const Level& left_level = *(left_levels.levels[left.second]);
@@ -225,51 +323,21 @@ double TransitionCalculator::CalculateTransition(const LevelID& left, const Leve
                     integrals->CalculateOneElectronIntegrals(orbitals->valence, orbitals->valence);
                 }
 
-                ManyBodyOperator<pTransitionIntegrals> many_body_operator(integrals);
-
-                // Get matrix elements for all transitions with same HamiltonianIDs
-                std::vector<double> values = many_body_operator.GetMatrixElement(left_levels, right_levels);
+                // Densities are reused for every frequency, so only the contraction is repeated
+                pTransitionDensityConst density = GetTransitionDensity(left, left_levels, right, right_levels);
 
                 // Add to matrix_elements map
-                return_value = values[left.second * left_levels.levels.size() + right.second];
+                return_value = density->GetMatrixElement(integrals, left.second, right.second);
                 matrix_elements.insert(std::make_pair(id, return_value));
             }
             else
             {   // Get transition integrals
-                if(integrals == nullptr)
-                {
-                    if(tdop)
-                    {
-                        double omega = user_input("Frequency", std::numeric_limits<double>::quiet_NaN());
-                        if(!std::isnan(omega))
-                            tdop->SetFrequency(omega);
+                CalculateStaticIntegrals();
 
-                        auto rpa = std::dynamic_pointer_cast<RPAOperator>(tdop);
-                        if(rpa)
-                            rpa->SolveRPA();
-                    }
-
-                    // Create new TransitionIntegrals object and calculate integrals
-                    integrals = std::make_shared<TransitionIntegrals>(orbitals, op);
-                    integrals->CalculateOneElectronIntegrals(orbitals->valence, orbitals->valence);
-                }
-
-                ManyBodyOperator<pTransitionIntegrals> many_body_operator(integrals);
+                pTransitionDensityConst density = GetTransitionDensity(left, left_levels, right, right_levels);
 
                 // Get matrix elements for all transitions with same HamiltonianIDs
-                std::vector<double> values = many_body_operator.GetMatrixElement(left_levels, right_levels);
-
-                // Add to matrix_elements map
-                auto value_iterator = values.begin();
-                for(int i = 0; i < left_levels.levels.size(); i++)
-                {
-                    for(int j = 0; j < right_levels.levels.size(); j++)
-                    {
-                        TransitionID current_id = make_transitionID(std::make_pair(left.first, i), std::make_pair(right.first, j));
-                        matrix_elements.insert(std::make_pair(current_id, *value_iterator));
-                        value_iterator++;
-                    }
-                }
+                StoreMatrixElements(left.first, right.first, density->GetMatrixElements(integrals), right_levels.levels.size());
 
                 return_value = matrix_elements[id];
             }
@@ -281,6 +349,111 @@ double TransitionCalculator::CalculateTransition(const LevelID& left, const Leve
     return return_value;
 }
 
+void TransitionCalculator::CalculateStaticIntegrals()
+{
+    if(integrals != nullptr)
+        return;
+
+    pTimeDependentSpinorOperator tdop = std::dynamic_pointer_cast<TimeDependentSpinorOperator>(op);
+    if(tdop)
+    {
+        double omega = user_input("Frequency", std::numeric_limits<double>::quiet_NaN());
+        if(!std::isnan(omega))
+            tdop->SetFrequency(omega);
+
+        auto rpa = std::dynamic_pointer_cast<RPAOperator>(tdop);
+        if(rpa)
+            rpa->SolveRPA();
+    }
+
+    // Create new TransitionIntegrals object and calculate integrals
+    integrals = std::make_shared<TransitionIntegrals>(orbitals, op);
+    integrals->CalculateOneElectronIntegrals(orbitals->valence, orbitals->valence);
+}
+
+void TransitionCalculator::StoreMatrixElements(pHamiltonianID left, pHamiltonianID right, const std::vector<double>& values, unsigned int num_right)
+{
+    for(unsigned int index = 0; index < values.size(); index++)
+    {
+        TransitionID current_id = make_transitionID(std::make_pair(left, index/num_right), std::make_pair(right, index%num_right));
+        matrix_elements.insert(std::make_pair(current_id, values[index]));
+    }
+}
+
+pTransitionIntegrals TransitionCalculator::CalculateIntegrals(double frequency)
+{
+    pTimeDependentSpinorOperator tdop = std::static_pointer_cast<TimeDependentSpinorOperator>(op);
+    tdop->SetFrequency(frequency);
+    auto rpa = std::dynamic_pointer_cast<RPAOperator>(tdop);
+    if(rpa)
+        rpa->SolveRPA();
+
+    pTransitionIntegrals frequency_integrals = std::make_shared<TransitionIntegrals>(orbitals, op);
+    frequency_integrals->CalculateOneElectronIntegrals(orbitals->valence, orbitals->valence);
+    return frequency_integrals;
+}
+
+pTransitionIntegralsConst TransitionCalculator::GetFrequencyGridIntegrals(long long node)
+{
+    auto found_it = frequency_grid_integrals.find(node);
+    if(found_it != frequency_grid_integrals.end())
+        return found_it->second;
+
+    double frequency = double(node) * frequency_grid_step/double(1LL << frequency_grid_max_refinements);
+    pTransitionIntegralsConst node_integrals = CalculateIntegrals(frequency);
+    frequency_grid_integrals[node] = node_integrals;
+    return node_integrals;
+}
+
+bool TransitionCalculator::InterpolateMatrixElement(const TransitionDensity& density, double frequency, unsigned int left_index, unsigned int right_index, double& value)
+{
+    long long finest = 1LL << frequency_grid_max_refinements;
+    double f[4];
+    unsigned int num_solves = 0;
+
+    for(unsigned int refinement = 0; refinement <= frequency_grid_max_refinements; refinement++)
+    {
+        // Grid spacing in units of the finest grid
+        long long stride = finest >> refinement;
+        double h = frequency_grid_step/double(1LL << refinement);
+        long long n = (long long)floor(frequency/h);
+        double t = frequency/h - double(n);
+
+        // Nodes n-1, n, n+1, n+2 surround the frequency.
+        // Give up before the new nodes cost more than solving at the exact frequency.
+        unsigned int new_nodes = 0;
+        for(int k = 0; k < 4; k++)
+            if(frequency_grid_integrals.find((n - 1 + k) * stride) == frequency_grid_integrals.end())
+                new_nodes++;
+
+        if(num_solves + new_nodes > frequency_grid_max_solves)
+            return false;
+        num_solves += new_nodes;
+
+        double max_value = 0.;
+        for(int k = 0; k < 4; k++)
+        {   f[k] = density.GetMatrixElement(GetFrequencyGridIntegrals((n - 1 + k) * stride), left_index, right_index);
+            max_value = mmax(max_value, fabs(f[k]));
+        }
+
+        double linear = (1. - t) * f[1] + t * f[2];
+        value = - t * (t - 1.) * (t - 2.)/6. * f[0]
+                + (t + 1.) * (t - 1.) * (t - 2.)/2. * f[1]
+                - (t + 1.) * t * (t - 2.)/2. * f[2]
+                + (t + 1.) * t * (t - 1.)/6. * f[3];
+
+        if(fabs(value - linear) <= frequency_grid_tolerance * max_value)
+            return true;
+    }
+
+    return false;
+}
+
+pTransitionDensityConst TransitionCalculator::GetTransitionDensity(const LevelID& left, const LevelVector& left_levels, const LevelID& right, const LevelVector& right_levels)
+{
+    return density_library->GetTransitionDensity(left.first, left_levels, right.first, right_levels, op);
+}
+
 double TransitionCalculator::CalculateTransition(const std::string& transition)
 {
     int pos = transition.find("->");
@@ -388,4 +561,107 @@ LevelID TransitionCalculator::make_LevelID(const std::string& name)
 
     return ret;
 }
+void TransitionDensityLibrary::Register(int K, Parity P)
+{
+    for(unsigned int i = 0; i < operators.size(); i++)
+    {
+        if(operators[i]->GetK() == K && operators[i]->GetParity() == P)
+        {   num_users[i]++;
+            return;
+        }
+    }
+
+    // Densities only need the symmetry of the operator
+    operators.push_back(std::make_shared<SpinorMatrixElement>(K, P));
+    num_users.push_back(1);
+}
+
+void TransitionDensityLibrary::Release(int K, Parity P)
+{
+    unsigned int i = 0;
+    while(i < operators.size() && (operators[i]->GetK() != K || operators[i]->GetParity() != P))
+        i++;
+
+    if(i == operators.size() || --num_users[i])
+        return;
+
+    operators.erase(operators.begin() + i);
+    num_users.erase(num_users.begin() + i);
+
+    // Discard stored densities, and pairs of symmetries that have none left
+    auto pair_it = densities.begin();
+    while(pair_it != densities.end())
+    {
+        auto& stored = pair_it->second;
+        stored.erase(std::remove_if(stored.begin(), stored.end(), [K, P](const pTransitionDensityConst& density)
+            {   return (density->GetK() == K && density->GetParity() == P);
+            }), stored.end());
+
+        if(stored.empty())
+            pair_it = densities.erase(pair_it);
+        else
+            pair_it++;
+    }
+}
+
+pTransitionDensityConst TransitionDensityLibrary::Find(pHamiltonianID left, pHamiltonianID right, pSpinorMatrixElementConst op) const
+{
+    auto found_it = densities.find(std::make_pair(left, right));
+    if(found_it != densities.end())
+    {
+        for(const auto& density: found_it->second)
+            if(density->IsCompatible(op))
+                return density;
+    }
+
+    return nullptr;
+}
+
+std::vector<pTransitionDensity> TransitionDensityLibrary::Calculate(pHamiltonianID left, const LevelVector& left_levels, pHamiltonianID right, const LevelVector& right_levels, pSpinorMatrixElementConst op) const
+{
+    const Symmetry& left_sym = left->GetSymmetry();
+    const Symmetry& right_sym = right->GetSymmetry();
+
+    std::vector<pSpinorMatrixElementConst> ops(1, op);
+    for(const auto& other: operators)
+    {
+        int K = other->GetK();
+        if((K != op->GetK() || other->GetParity() != op->GetParity()) &&
+           (abs(left_sym.GetTwoJ() - right_sym.GetTwoJ()) <= 2 * K) &&
+           (left_sym.GetTwoJ() + right_sym.GetTwoJ() >= 2 * K) &&
+           (left_sym.GetParity() * right_sym.GetParity() == other->GetParity()) &&
+           !Find(left, right, other))
+            ops.push_back(other);
+    }
+
+    return TransitionDensity::Calculate(ops, left_levels, right_levels);
+}
+
+void TransitionDensityLibrary::Store(pHamiltonianID left, pHamiltonianID right, const std::vector<pTransitionDensity>& new_densities)
+{
+    auto& stored = densities[std::make_pair(left, right)];
+    for(const auto& density: new_densities)
+    {
+        auto found_it = std::find_if(stored.begin(), stored.end(), [&density](const pTransitionDensityConst& existing)
+            {   return (existing->GetK() == density->GetK() && existing->GetParity() == density->GetParity());
+            });
+
+        if(found_it == stored.end())
+            stored.push_back(density);
+        else
+            *found_it = density;
+    }
+}
+
+pTransitionDensityConst TransitionDensityLibrary::GetTransitionDensity(pHamiltonianID left, const LevelVector& left_levels, pHamiltonianID right, const LevelVector& right_levels, pSpinorMatrixElementConst op)
+{
+    pTransitionDensityConst density = Find(left, right, op);
+    if(density)
+        return density;
+
+    std::vector<pTransitionDensity> new_densities = Calculate(left, left_levels, right, right_levels, op);
+    Store(left, right, new_densities);
+    return new_densities.front();
+}
+
 }
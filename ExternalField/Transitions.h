@@ -3,6 +3,7 @@
 
 #include "Atom/Atom.h"
 #include "Configuration/Level.h"
+#include "Configuration/TransitionDensity.h"
 #include "Universal/Enums.h"
 #include "RPAOperator.h"
 #include <map>
@@ -18,6 +19,63 @@ std::string Name(const LevelID& levelid);
 
 typedef std::pair<LevelID, LevelID> TransitionID;
 
+/** Order pairs of HamiltonianIDs by dereferencing. */
+struct HamiltonianIDPairComparator
+{
+    bool operator()(const std::pair<pHamiltonianID, pHamiltonianID>& first, const std::pair<pHamiltonianID, pHamiltonianID>& second) const
+    {
+        if(*first.first < *second.first)
+            return true;
+        else if(*second.first < *first.first)
+            return false;
+        else
+            return (*first.second < *second.second);
+    }
+};
+
+/** Store of transition densities that may be shared between several TransitionCalculators.
+    Densities depend only on the rank and parity of an operator, so whenever densities are needed between a
+    pair of symmetries, those of all registered operators allowed between them are found in the same pass.
+    Densities of each rank and parity are kept until every user registered for them has called Release().
+ */
+class TransitionDensityLibrary
+{
+public:
+    /** Add a user of densities with rank K and parity P: these are calculated along with those of any operator. */
+    void Register(int K, Parity P);
+    void Register(pSpinorMatrixElementConst op) { Register(op->GetK(), op->GetParity()); }
+
+    /** A user of densities with rank K and parity P has finished. Once no users remain, these densities
+        are discarded and are no longer calculated along with others.
+     */
+    void Release(int K, Parity P);
+    void Release(pSpinorMatrixElementConst op) { Release(op->GetK(), op->GetParity()); }
+
+    /** Return stored density between left and right with same rank and parity as op, or nullptr. */
+    pTransitionDensityConst Find(pHamiltonianID left, pHamiltonianID right, pSpinorMatrixElementConst op) const;
+
+    /** Calculate (without storing) densities for op and for all registered operators that are allowed
+        between left and right, but are not stored. The density for op is first.
+        This is const so that different pairs of symmetries can be calculated in parallel.
+     */
+    std::vector<pTransitionDensity> Calculate(pHamiltonianID left, const LevelVector& left_levels, pHamiltonianID right, const LevelVector& right_levels, pSpinorMatrixElementConst op) const;
+
+    /** Store densities between left and right. */
+    void Store(pHamiltonianID left, pHamiltonianID right, const std::vector<pTransitionDensity>& new_densities);
+
+    /** Get density between left and right compatible with op, calculating and storing it if required. */
+    pTransitionDensityConst GetTransitionDensity(pHamiltonianID left, const LevelVector& left_levels, pHamiltonianID right, const LevelVector& right_levels, pSpinorMatrixElementConst op);
+
+protected:
+    std::vector<pSpinorMatrixElementConst> operators;   //!< One (empty) operator of each registered rank and parity
+    std::vector<unsigned int> num_users;                //!< Number of users of each of operators
+
+    /** Transition densities, independent of frequency, stored for each pair of HamiltonianIDs. */
+    std::map<std::pair<pHamiltonianID, pHamiltonianID>, std::vector<pTransitionDensityConst>, HamiltonianIDPairComparator> densities;
+};
+
+typedef std::shared_ptr<TransitionDensityLibrary> pTransitionDensityLibrary;
+
 /** Abstract class for generating an operator from user_input, calculating strengths, and printing.
     Calculates matrix_elements for the operator and stores them in a mapping between TransitionID and Strength (S).
     Derived classes should implement
@@ -52,6 +110,14 @@ public:
     /** Print one-electron transition integrals. */
     virtual void PrintIntegrals();
 
+    pSpinorMatrixElementConst GetOperator() const { return op; }
+
+    /** Share transition densities with other calculators, so that densities for all of their operators
+        are calculated together. Operators should be registered with the library before calculating;
+        CalculateAndPrint() releases the densities of this calculator's operator when it is done.
+     */
+    void SetTransitionDensityLibrary(pTransitionDensityLibrary library) { density_library = library; }
+
 protected:
     /** Print the header line to outstream, explaining transition type, units, etc. */
     virtual void PrintHeader() const = 0;
@@ -104,6 +170,54 @@ protected:
             return std::make_pair(left, right);
     }
 
+    /** All transitions between levels of a pair of symmetries, for which the first
+        num_left and num_right levels are requested.
+     */
+    struct TransitionJob
+    {
+        pHamiltonianID left;
+        pHamiltonianID right;
+        LevelVector left_levels;
+        LevelVector right_levels;
+        unsigned int num_left;
+        unsigned int num_right;
+    };
+
+    /** Calculate transition densities for all jobs in parallel. For frequency-independent operators
+        also calculate and store all matrix elements, otherwise they are left for CalculateTransition().
+     */
+    void CalculateTransitions(const std::vector<TransitionJob>& jobs);
+
+    /** Calculate and print all transitions between levels with energy below max_energy. */
+    void CalculateAllBelow(double max_energy);
+
+    /** Create integrals for a frequency-independent operator (or at fixed Frequency) if they don't exist. */
+    void CalculateStaticIntegrals();
+
+    /** Add matrix elements between all levels of left and right, indexed by left_index * num_right + right_index. */
+    void StoreMatrixElements(pHamiltonianID left, pHamiltonianID right, const std::vector<double>& values, unsigned int num_right);
+
+    /** Set frequency of op (solving RPA if required) and return new integrals at that frequency. */
+    pTransitionIntegrals CalculateIntegrals(double frequency);
+
+    /** Get integrals at node of the frequency grid, node * frequency_grid_step/2^(frequency_grid_max_refinements),
+        calculating them only if they have not been stored.
+     */
+    pTransitionIntegralsConst GetFrequencyGridIntegrals(long long node);
+
+    /** Interpolate < left_levels[left_index] | O | right_levels[right_index] > at frequency using cubic
+        interpolation on the frequency grid. The grid is refined until the cubic and linear interpolations
+        agree to within frequency_grid_tolerance (relative to the largest value at the nodes).
+        Return false if the finest grid is not accurate enough, or if refining would calculate integrals
+        at more than frequency_grid_max_solves new nodes for this transition.
+     */
+    bool InterpolateMatrixElement(const TransitionDensity& density, double frequency, unsigned int left_index, unsigned int right_index, double& value);
+
+    /** Get transition densities between all levels of left_levels and right_levels,
+        calculating them only if they have not been stored in density_library.
+     */
+    pTransitionDensityConst GetTransitionDensity(const LevelID& left, const LevelVector& left_levels, const LevelID& right, const LevelVector& right_levels);
+
 protected:
     MultirunOptions& user_input;
     pOrbitalManagerConst orbitals;
@@ -113,6 +227,16 @@ protected:
 
     pTransitionIntegrals integrals;     // One-electron integrals
     std::map<TransitionID, double> matrix_elements;
+
+    // Frequency grid for variable frequency operators
+    bool use_frequency_grid = false;
+    double frequency_grid_step = 0.02;
+    double frequency_grid_tolerance = 1.e-5;
+    unsigned int frequency_grid_max_refinements = 6;
+    unsigned int frequency_grid_max_solves = 4;     // New grid nodes (RPA solves) allowed per transition
+    std::map<long long, pTransitionIntegralsConst> frequency_grid_integrals;
+
+    pTransitionDensityLibrary density_library {std::make_shared<TransitionDensityLibrary>()};
 };
 
 }
@@ -0,0 +1,154 @@
+#include "gtest/gtest.h"
+#include "Include.h"
+#include "Transitions.h"
+#include "EJOperator.h"
+#include "HartreeFock/Core.h"
+#include "Basis/BasisGenerator.h"
+#include "Atom/MultirunOptions.h"
+#include "MBPT/OneElectronIntegrals.h"
+#include "MBPT/SlaterIntegrals.h"
+#include "Configuration/HamiltonianMatrix.h"
+#include "Configuration/ConfigGenerator.h"
+#include "Configuration/LevelMap.h"
+
+using namespace Ambit;
+
+namespace
+{
+/** TransitionCalculator for a given operator, with or without the frequency grid. */
+class GridTransitionCalculator : public TransitionCalculator
+{
+public:
+    GridTransitionCalculator(MultirunOptions& user_input, pOrbitalManagerConst orbitals, pLevelStore levels, pSpinorMatrixElement E1, bool grid):
+        TransitionCalculator(user_input, orbitals, levels)
+    {   op = E1;
+        variable_frequency_op = true;
+        use_frequency_grid = grid;
+        frequency_grid_tolerance = 1.e-6;
+    }
+
+    using TransitionCalculator::CalculateTransition;
+
+    unsigned int NumGridNodes() const { return frequency_grid_integrals.size(); }
+    unsigned int MaxSolves() const { return frequency_grid_max_solves; }
+
+protected:
+    virtual void PrintHeader() const override {}
+    virtual void PrintTransition(const LevelID& left, const LevelID& right, double matrix_element) const override {}
+};
+}
+
+TEST(TransitionCalculatorTester, FrequencyGrid)
+{
+    pLattice lattice(new Lattice(1000, 1.e-6, 50.));
+
+    // He
+    std::string user_input_string = std::string() +
+        "NuclearRadius = 1.5\n" +
+        "NuclearThickness = 2.3\n" +
+        "Z = 2\n" +
+        "[HF]\n" +
+        "N = 0\n" +
+        "[Basis]\n" +
+        "--bspline-basis\n" +
+        "ValenceBasis = 6spd\n" +
+        "BSpline/Rmax = 50.0\n" +
+        "[CI]\n" +
+        "LeadingConfigurations = '1s2'\n" +
+        "ElectronExcitations = 2\n";
+
+    std::stringstream user_input_stream(user_input_string);
+    MultirunOptions userInput(user_input_stream, "//", "\n", ",");
+
+    // Get core and excited basis
+    BasisGenerator basis_generator(lattice, userInput);
+    pCore core = basis_generator.GenerateHFCore();
+    pOrbitalManagerConst orbitals = basis_generator.GenerateBasis();
+
+    // Generate integrals
+    pHFOperator hf = basis_generator.GetClosedHFOperator();
+    pHFIntegrals hf_electron(new HFIntegrals(orbitals, hf));
+    hf_electron->CalculateOneElectronIntegrals(orbitals->valence, orbitals->valence);
+
+    pCoulombOperator coulomb(new CoulombOperator(lattice));
+    pHartreeY hartreeY(new HartreeY(hf->GetIntegrator(), coulomb));
+    pSlaterIntegrals integrals(new SlaterIntegralsMap(orbitals, hartreeY));
+    integrals->CalculateTwoElectronIntegrals(orbitals->valence, orbitals->valence, orbitals->valence, orbitals->valence);
+    pTwoElectronCoulombOperator twobody_electron = std::make_shared<TwoElectronCoulombOperator>(integrals);
+
+    // Levels of J = 0 (even) and J = 1 (odd)
+    pAngularDataLibrary angular_library = std::make_shared<AngularDataLibrary>();
+    pLevelStore levels = std::make_shared<LevelMap>(angular_library);
+    ConfigGenerator config_generator(orbitals, userInput);
+    auto allconfigs = config_generator.GenerateConfigurations();
+
+    std::vector<pHamiltonianID> keys;
+    for(const Symmetry& sym: {Symmetry(0, Parity::even), Symmetry(2, Parity::odd)})
+    {
+        pRelativisticConfigList relconfigs = config_generator.GenerateRelativisticConfigurations(allconfigs, sym, angular_library);
+        HamiltonianMatrix H(hf_electron, twobody_electron, relconfigs);
+        H.GenerateMatrix();
+
+        pHamiltonianID key = std::make_shared<HamiltonianID>(sym);
+        levels->Store(key, H.SolveMatrix(key, 3));
+        keys.push_back(key);
+    }
+
+    pIntegrator integrator(new SimpsonsIntegrator(lattice));
+    GridTransitionCalculator exact(userInput, orbitals, levels, std::make_shared<EJOperator>(1, integrator), false);
+    GridTransitionCalculator interpolated(userInput, orbitals, levels, std::make_shared<EJOperator>(1, integrator), true);
+
+    // Interpolated matrix elements should agree with those calculated at the exact frequency
+    std::vector<double> expected;
+    double largest = 0.;
+    unsigned int num_transitions = 0;
+    for(int i = 0; i < 3; i++)
+        for(int j = 0; j < 3; j++)
+        {   expected.push_back(exact.CalculateTransition(std::make_pair(keys[0], i), std::make_pair(keys[1], j)));
+            largest = mmax(largest, fabs(expected.back()));
+            num_transitions++;
+        }
+    ASSERT_GT(largest, 0.);
+
+    unsigned int index = 0;
+    for(int i = 0; i < 3; i++)
+        for(int j = 0; j < 3; j++)
+            EXPECT_NEAR(expected[index++], interpolated.CalculateTransition(std::make_pair(keys[0], i), std::make_pair(keys[1], j)), 1.e-4 * largest);
+
+    // No more solves on the grid than allowed for each transition
+    EXPECT_LT(0, interpolated.NumGridNodes());
+    EXPECT_LE(interpolated.NumGridNodes(), interpolated.MaxSolves() * num_transitions);
+}
+
+TEST(TransitionDensityLibraryTester, Release)
+{
+    // Closed 4d3/2 shell: J = 0
+    pAngularDataLibrary angular_library = std::make_shared<AngularDataLibrary>();
+    pHamiltonianID key = std::make_shared<HamiltonianID>(0, Parity::even);
+    pRelativisticConfigList configs = std::make_shared<RelativisticConfigList>();
+    RelativisticConfiguration rconfig;
+    rconfig.insert(std::make_pair(OrbitalInfo(4, 2), 4));
+    configs->push_back(rconfig);
+
+    for(auto& config: *configs)
+        config.GetProjections(angular_library, key->GetSymmetry(), key->GetTwoJ());
+    angular_library->GenerateCSFs();
+    ASSERT_EQ(1, configs->NumCSFs());
+
+    LevelVector levelvec(key, configs, std::make_shared<Level>(-1., std::vector<double>(1, 1.), key, 0.));
+    pSpinorMatrixElementConst op = std::make_shared<SpinorMatrixElement>(0, Parity::even);
+
+    // Densities are kept until both users have released them
+    TransitionDensityLibrary library;
+    library.Register(op);
+    library.Register(op);
+
+    pTransitionDensityConst density = library.GetTransitionDensity(key, levelvec, key, levelvec, op);
+    EXPECT_EQ(density, library.Find(key, key, op));
+
+    library.Release(op);
+    EXPECT_EQ(density, library.Find(key, key, op));
+
+    library.Release(op);
+    EXPECT_EQ(nullptr, library.Find(key, key, op));
+}
@@ -2,6 +2,10 @@
 #include "Include.h"
 #include "Universal/MathConstant.h"
 
+#ifdef AMBIT_USE_OPENMP
+#include <omp.h>
+#endif
+
 namespace Ambit
 {
 HFOperator::HFOperator(double Z, pCoreConst hf_core, pPhysicalConstant physical_constant, pIntegrator integration_strategy, pCoulombOperator coulomb) :
@@ -326,15 +330,16 @@ SpinorFunction HFOperator::CalculateExchange(const SpinorFunction& s) const
     if(current_in_core && core->GetState(OrbitalInfo(current_in_core)) == nullptr)
         current_in_core = nullptr;
 
-    // Sum over all core states
+    // Collect all core states and multipolarities with their angular coefficients
+    std::vector<pOrbitalConst> term_orbitals;
+    std::vector<unsigned int> term_k;
+    std::vector<double> term_coefficients;
+
     for(auto cs = core->begin(); cs != core->end(); cs++)
     {
         pOrbitalConst core_orbital = cs->second;
         double other_occupancy = core->GetOccupancy(OrbitalInfo(core_orbital));
 
-        // Get overlap of wavefunctions
-        RadialFunction density = s.GetDensity(*core_orbital);
-
         // Sum over all k
         for(unsigned int k = abs((int)core_orbital->L() - (int)s.L()); k <= (core_orbital->L() + s.L()); k+=2)
         {
@@ -377,14 +382,54 @@ SpinorFunction HFOperator::CalculateExchange(const SpinorFunction& s) const
                 coefficient = coefficient * ex;
             }
 
-            // Integrate density to get (1/r)Y(ab,r)
-            RadialFunction potential(mmax(density.size(), core_orbital->size()));
-            coulombSolver->GetPotential(k, density, potential);
-
-            exchange += (*core_orbital) * potential * coefficient;
+            term_orbitals.push_back(core_orbital);
+            term_k.push_back(k);
+            term_coefficients.push_back(coefficient);
         }
     }
 
+    // The Coulomb potential of each term is the expensive part. Calculate the terms in parallel
+    // and sum them in order, so that the exchange is the same for any number of threads.
+    int num_terms = term_orbitals.size();
+    std::vector<SpinorFunction> terms(num_terms, SpinorFunction(s.Kappa()));
+
+    // The Coulomb solver stores the density, so each thread uses its own copy, made only once.
+    // Give each thread at least two terms: for fewer the team costs more than it saves.
+    int num_threads = 1;
+#ifdef AMBIT_USE_OPENMP
+    if(!omp_in_parallel())
+        num_threads = mmax(1, mmin(omp_get_max_threads(), num_terms/2));
+
+    while(int(exchangeCoulombSolvers.size()) + 1 < num_threads)
+        exchangeCoulombSolvers.push_back(std::make_shared<CoulombOperator>(*coulombSolver));
+#endif
+
+    int i;
+#ifdef AMBIT_USE_OPENMP
+    #pragma omp parallel for private(i) schedule(dynamic) num_threads(num_threads) if(num_threads > 1)
+#endif
+    for(i = 0; i < num_terms; i++)
+    {
+        pCoulombOperator coulomb = coulombSolver;
+#ifdef AMBIT_USE_OPENMP
+        if(num_threads > 1 && omp_get_thread_num() > 0)
+            coulomb = exchangeCoulombSolvers[omp_get_thread_num() - 1];
+#endif
+        pOrbitalConst core_orbital = term_orbitals[i];
+
+        // Get overlap of wavefunctions
+        RadialFunction density = s.GetDensity(*core_orbital);
+
+        // Integrate density to get (1/r)Y(ab,r)
+        RadialFunction potential(mmax(density.size(), core_orbital->size()));
+        coulomb->GetPotential(term_k[i], density, potential);
+
+        terms[i] = (*core_orbital) * potential * term_coefficients[i];
+    }
+
+    for(const SpinorFunction& term: terms)
+        exchange += term;
+
     return exchange;
 }
 }
@@ -28,7 +28,11 @@ public:
     virtual RadialFunction GetDirectPotential() const override; //!< Get the direct potential.
 
     /** Deep copy of the HFOperator object, particularly including wrapped objects (but not the core or physical constants). */
-    virtual pHFOperator Clone() const override { return std::make_shared<HFOperator>(*this); }
+    virtual pHFOperator Clone() const override
+    {   std::shared_ptr<HFOperator> copy = std::make_shared<HFOperator>(*this);
+        copy->exchangeCoulombSolvers.clear();
+        return copy;
+    }
 
 public:
     /** Extend/reduce direct potential to match lattice size. */
@@ -112,6 +116,7 @@ protected:
 
 protected:
     pCoulombOperator coulombSolver;
+    mutable std::vector<pCoulombOperator> exchangeCoulombSolvers;  //!< Copies of coulombSolver for extra threads in CalculateExchange()
     RadialFunction directPotential;
     SpinorFunction currentExchangePotential;
 };
@@ -7,6 +7,10 @@
 #include "HartreeFocker.h"
 #include "ConfigurationParser.h"
 
+#ifdef AMBIT_USE_OPENMP
+#include <omp.h>
+#endif
+
 using namespace Ambit;
 
 TEST(HFOperatorTester, ODESolver)
@@ -52,3 +56,70 @@ TEST(HFOperatorTester, ODESolver)
 
     EXPECT_NEAR(new_2p->Energy(), -14.282789, 1.e-6 * 14.282789);
 }
+
+TEST(HFOperatorTester, ThreadedExchange)
+{
+    pLattice lattice(new Lattice(1000, 1.e-6, 50.));
+
+    // Ca
+    unsigned int Z = 20;
+    OccupationMap filling = ConfigurationParser::ParseFractionalConfiguration("1s2 2s2 2p6 3s2 3p6");
+
+    DebugOptions.LogFirstBuild(false);
+    DebugOptions.LogHFIterations(false);
+
+    pIntegrator integrator(new SimpsonsIntegrator(lattice));
+    pODESolver ode_solver(new AdamsSolver(integrator));
+    pPhysicalConstant physical_constant(new PhysicalConstant());
+
+    // Solve core and 4s, 3d with the given number of threads
+    auto solve = [&](int num_threads)
+    {
+    #ifdef AMBIT_USE_OPENMP
+        omp_set_num_threads(num_threads);
+    #endif
+        pCore core(new Core(lattice));
+        core->SetOccupancies(filling);
+
+        pCoulombOperator coulomb(new CoulombOperator(lattice, ode_solver));
+        pHFOperator t(new HFOperator(Z, core, physical_constant, integrator, coulomb));
+
+        HartreeFocker HF_Solver(ode_solver);
+        HF_Solver.StartCore(core, t);
+        HF_Solver.SolveCore(core, t);
+
+        std::vector<pOrbital> orbitals;
+        for(const auto& pair: *core)
+            orbitals.push_back(std::make_shared<Orbital>(*pair.second));
+
+        for(const OrbitalInfo& info: {OrbitalInfo(4, -1), OrbitalInfo(3, 2)})
+        {   pOrbital excited(new Orbital(info.Kappa(), info.PQN(), -0.4));
+            HF_Solver.CalculateExcitedState(excited, t);
+            orbitals.push_back(excited);
+        }
+        return orbitals;
+    };
+
+    int max_threads = 1;
+#ifdef AMBIT_USE_OPENMP
+    max_threads = omp_get_max_threads();
+#endif
+    std::vector<pOrbital> serial = solve(1);
+    std::vector<pOrbital> threaded = solve(mmax(4, max_threads));
+#ifdef AMBIT_USE_OPENMP
+    omp_set_num_threads(max_threads);
+#endif
+
+    // Exchange terms are summed in the same order, so results are identical
+    ASSERT_EQ(serial.size(), threaded.size());
+    for(unsigned int i = 0; i < serial.size(); i++)
+    {
+        EXPECT_EQ(serial[i]->Energy(), threaded[i]->Energy());
+        ASSERT_EQ(serial[i]->size(), threaded[i]->size());
+        unsigned int num_different = 0;
+        for(unsigned int r = 0; r < serial[i]->size(); r++)
+            if(serial[i]->f[r] != threaded[i]->f[r] || serial[i]->g[r] != threaded[i]->g[r])
+                num_different++;
+        EXPECT_EQ(0, num_different);
+    }
+}
@@ -1,7 +1,18 @@
 #include "HartreeY.h"
+#include "OrbitalBank.h"
 
 namespace Ambit
 {
+std::vector<double> HartreeYBase::GetMatrixElements(const OrbitalBank& bank, const std::vector<unsigned int>& b_indices, const Orbital& a, bool reverse) const
+{
+    std::vector<double> ret;
+    ret.reserve(b_indices.size());
+    for(unsigned int b: b_indices)
+        ret.push_back(GetMatrixElement(*bank.GetOrbital(b), a, reverse));
+
+    return ret;
+}
+
 HartreeY::HartreeY(pIntegrator integration_strategy, pCoulombOperator coulomb):
     HartreeYBase(integration_strategy), LatticeObserver(integration_strategy->GetLattice()), coulomb(coulomb)
 {
@@ -123,6 +134,38 @@ double HartreeY::GetMatrixElement(const Orbital& b, const Orbital& a, bool rever
         return 0.;
 }
 
+std::vector<double> HartreeY::GetMatrixElements(const OrbitalBank& bank, const std::vector<unsigned int>& b_indices, const Orbital& a, bool reverse) const
+{
+    std::vector<double> ret(b_indices.size(), 0.);
+    if(isZero() || lightweight_mode)
+        return ret;
+
+    // Integrate only the orbitals allowed by angular momentum and parity
+    std::vector<unsigned int> allowed_indices;
+    std::vector<unsigned int> positions;
+    allowed_indices.reserve(b_indices.size());
+    positions.reserve(b_indices.size());
+
+    for(unsigned int n = 0; n < b_indices.size(); n++)
+    {
+        unsigned int b = b_indices[n];
+        if(((K + a.L() + bank.L(b))%2 == 0) &&
+           (abs(a.TwoJ() - bank.TwoJ(b)) <= 2 * K) &&
+           (2 * K <= a.TwoJ() + bank.TwoJ(b)))
+        {   allowed_indices.push_back(b);
+            positions.push_back(n);
+        }
+    }
+
+    if(allowed_indices.size())
+    {   std::vector<double> radial = integrator->GetPotentialMatrixElements(bank, allowed_indices, a, potential);
+        for(unsigned int n = 0; n < positions.size(); n++)
+            ret[positions[n]] = radial[n];
+    }
+
+    return ret;
+}
+
 SpinorFunction HartreeY::ApplyTo(const SpinorFunction& a, int kappa_b, bool reverse) const
 {
     SpinorFunction ret(kappa_b);
@@ -6,6 +6,8 @@
 
 namespace Ambit
 {
+class OrbitalBank;
+
 /** HartreeY is a radial one-body operator defined by
     \f[
         Y^k_{cd}(r) = \int \frac{r_<^k}{r_>^{k+1}} \psi_c^\dag (r') \psi_d (r') dr'
@@ -121,6 +123,11 @@ public:
             return 0.0;
     }
 
+    /** < b_i | t | a > for each orbital b_i = bank.GetOrbital(i) with i in b_indices.
+        The default calls GetMatrixElement() for each orbital.
+     */
+    virtual std::vector<double> GetMatrixElements(const OrbitalBank& bank, const std::vector<unsigned int>& b_indices, const Orbital& a, bool reverse = false) const;
+
     /** Potential = t | a > for an operator t such that the resulting Potential has the same angular symmetry as a.
         i.e. t | a > has kappa == kappa_a.
      */
@@ -216,6 +223,9 @@ public:
     /** < b | t | a > for an operator t. */
     virtual double GetMatrixElement(const Orbital& b, const Orbital& a, bool reverse) const override;
 
+    /** < b_i | t | a > for each orbital b_i in the bank, integrated in a single batch. */
+    virtual std::vector<double> GetMatrixElements(const OrbitalBank& bank, const std::vector<unsigned int>& b_indices, const Orbital& a, bool reverse = false) const override;
+
     /** Potential = t | a > for an operator t such that the resulting Potential.Kappa() == kappa_b.
         i.e. t | a > has kappa == kappa_b.
      */
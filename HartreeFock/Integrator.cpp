@@ -1,4 +1,5 @@
 #include "Integrator.h"
+#include "OrbitalBank.h"
 #include "Include.h"
 
 namespace Ambit
@@ -35,29 +36,63 @@ double Integrator::GetPotentialMatrixElement(const SpinorFunction& a, const Radi
     return Integrate(integrand);
 }
 
+std::vector<double> Integrator::GetInnerProducts(const std::vector<const SpinorFunction*>& b_list, const SpinorFunction& a) const
+{
+    std::vector<double> ret;
+    ret.reserve(b_list.size());
+    for(const SpinorFunction* b: b_list)
+        ret.push_back(GetInnerProduct(*b, a));
+
+    return ret;
+}
+
+std::vector<double> Integrator::GetPotentialMatrixElements(const std::vector<const SpinorFunction*>& b_list, const SpinorFunction& a, const RadialFunction& V) const
+{
+    std::vector<double> ret;
+    ret.reserve(b_list.size());
+    for(const SpinorFunction* b: b_list)
+        ret.push_back(GetPotentialMatrixElement(*b, a, V));
+
+    return ret;
+}
+
+std::vector<double> Integrator::GetPotentialMatrixElements(const OrbitalBank& bank, const std::vector<unsigned int>& b_indices, const SpinorFunction& a, const RadialFunction& V) const
+{
+    std::vector<double> ret;
+    ret.reserve(b_indices.size());
+    for(unsigned int b: b_indices)
+        ret.push_back(GetPotentialMatrixElement(*bank.GetOrbital(b), a, V));
+
+    return ret;
+}
+
 double SimpsonsIntegrator::Integrate(const RadialFunction& integrand) const
 {
-    return Integrate(integrand.size(), [&](int i){ return (integrand.f[i]); });
+    const double* f = integrand.f.data();
+    return Integrate(integrand.size(), [f](int i){ return f[i]; });
 }
 
 /** < a | b > = Integral (f_a * f_b + g_a * g_b) dr */
 double SimpsonsIntegrator::GetInnerProduct(const SpinorFunction& a, const SpinorFunction& b) const
 {
     int size = mmin(a.size(), b.size());
-    return Integrate(size, [&](int i){ return (a.f[i] * b.f[i] + a.g[i] * b.g[i]); });
+    const double *af = a.f.data(), *ag = a.g.data(), *bf = b.f.data(), *bg = b.g.data();
+    return Integrate(size, [=](int i){ return (af[i] * bf[i] + ag[i] * bg[i]); });
 }
 
 /** < a | b > = Integral (f_a * f_b) dr */
 double SimpsonsIntegrator::GetInnerProduct(const RadialFunction& a, const RadialFunction& b) const
 {
     int size = mmin(a.size(), b.size());
-    return Integrate(size, [&](int i){ return (a.f[i] * b.f[i]); });
+    const double *af = a.f.data(), *bf = b.f.data();
+    return Integrate(size, [=](int i){ return (af[i] * bf[i]); });
 }
 
 /** < a | a > */
 double SimpsonsIntegrator::GetNorm(const SpinorFunction& a) const
 {
-    return Integrate(a.size(), [&](int i){ return (a.f[i] * a.f[i] + a.g[i] * a.g[i]); });
+    const double *af = a.f.data(), *ag = a.g.data();
+    return Integrate(a.size(), [=](int i){ return (af[i] * af[i] + ag[i] * ag[i]); });
 }
 
 /** < a | V | b > = Integral (f_a * f_b + g_a * g_b) * V(r) dr */
@@ -65,13 +100,71 @@ double SimpsonsIntegrator::GetPotentialMatrixElement(const SpinorFunction& a, co
 {
     int size = mmin(a.size(), b.size());
     size = mmin(size, V.size());
-    return Integrate(size, [&](int i){ return (a.f[i] * b.f[i] + a.g[i] * b.g[i]) * V.f[i]; });
+    const double *af = a.f.data(), *ag = a.g.data(), *bf = b.f.data(), *bg = b.g.data(), *Vf = V.f.data();
+    return Integrate(size, [=](int i){ return (af[i] * bf[i] + ag[i] * bg[i]) * Vf[i]; });
 }
 
 /** < a | V | a > */
 double SimpsonsIntegrator::GetPotentialMatrixElement(const SpinorFunction& a, const RadialFunction& V) const
 {
     int size = mmin(a.size(), V.size());
-    return Integrate(size, [&](int i){ return (a.f[i] * a.f[i] + a.g[i] * a.g[i]) * V.f[i]; });
+    const double *af = a.f.data(), *ag = a.g.data(), *Vf = V.f.data();
+    return Integrate(size, [=](int i){ return (af[i] * af[i] + ag[i] * ag[i]) * Vf[i]; });
+}
+
+/** < b_i | a > for each b_i in b_list */
+std::vector<double> SimpsonsIntegrator::GetInnerProducts(const std::vector<const SpinorFunction*>& b_list, const SpinorFunction& a) const
+{
+    int size = a.size();
+    const double* weights = lattice->SimpsonWeights();
+
+    std::vector<double> weighted_f(size), weighted_g(size);
+    for(int i = 0; i < size; i++)
+    {   weighted_f[i] = a.f[i] * weights[i];
+        weighted_g[i] = a.g[i] * weights[i];
+    }
+
+    return WeightedOverlaps(b_list, size, weighted_f.data(), weighted_g.data(),
+                            [&](const double* bf, const double* bg, int i){ return (bf[i] * a.f[i] + bg[i] * a.g[i]); });
+}
+
+/** < b_i | V | a > for each b_i in b_list */
+std::vector<double> SimpsonsIntegrator::GetPotentialMatrixElements(const std::vector<const SpinorFunction*>& b_list, const SpinorFunction& a, const RadialFunction& V) const
+{
+    int size = mmin(a.size(), V.size());
+    const double* weights = lattice->SimpsonWeights();
+
+    std::vector<double> weighted_f(size), weighted_g(size);
+    for(int i = 0; i < size; i++)
+    {   double weighted_V = V.f[i] * weights[i];
+        weighted_f[i] = a.f[i] * weighted_V;
+        weighted_g[i] = a.g[i] * weighted_V;
+    }
+
+    return WeightedOverlaps(b_list, size, weighted_f.data(), weighted_g.data(),
+                            [&](const double* bf, const double* bg, int i){ return (bf[i] * a.f[i] + bg[i] * a.g[i]) * V.f[i]; });
+}
+
+/** < b_i | V | a > for each orbital b_i in bank */
+std::vector<double> SimpsonsIntegrator::GetPotentialMatrixElements(const OrbitalBank& bank, const std::vector<unsigned int>& b_indices, const SpinorFunction& a, const RadialFunction& V) const
+{
+    int size = mmin(a.size(), V.size());
+    const double* weights = lattice->SimpsonWeights();
+
+    std::vector<double> weighted_f(size), weighted_g(size);
+    for(int i = 0; i < size; i++)
+    {   double weighted_V = V.f[i] * weights[i];
+        weighted_f[i] = a.f[i] * weighted_V;
+        weighted_g[i] = a.g[i] * weighted_V;
+    }
+
+    return WeightedOverlaps(b_indices.size(),
+                            [&](unsigned int n, const double*& bf, const double*& bg, int& b_size)
+                            {   bf = bank.f(b_indices[n]);
+                                bg = bank.g(b_indices[n]);
+                                b_size = bank.Size(b_indices[n]);
+                            },
+                            size, weighted_f.data(), weighted_g.data(),
+                            [&](const double* bf, const double* bg, int i){ return (bf[i] * a.f[i] + bg[i] * a.g[i]) * V.f[i]; });
 }
 }
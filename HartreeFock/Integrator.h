@@ -4,9 +4,13 @@
 #include "Universal/Lattice.h"
 #include "Universal/SpinorFunction.h"
 #include <memory>
+#include <vector>
+#include <algorithm>
 
 namespace Ambit
 {
+class OrbitalBank;
+
 /** Integrator provides an interface for integrating radial functions and spinor functions.
     A default implementation for spinor integration routines is provided, that defers the
     actual integration to the abstract function Integrate().
@@ -33,6 +37,15 @@ public:
     /** < a | V | a > */
     virtual double GetPotentialMatrixElement(const SpinorFunction& a, const RadialFunction& V) const;
 
+    /** < b_i | a > for each b_i in b_list. */
+    virtual std::vector<double> GetInnerProducts(const std::vector<const SpinorFunction*>& b_list, const SpinorFunction& a) const;
+
+    /** < b_i | V | a > for each b_i in b_list. */
+    virtual std::vector<double> GetPotentialMatrixElements(const std::vector<const SpinorFunction*>& b_list, const SpinorFunction& a, const RadialFunction& V) const;
+
+    /** < b_i | V | a > for each orbital b_i = bank.GetOrbital(i) with i in b_indices. */
+    virtual std::vector<double> GetPotentialMatrixElements(const OrbitalBank& bank, const std::vector<unsigned int>& b_indices, const SpinorFunction& a, const RadialFunction& V) const;
+
     pLattice GetLattice() { return lattice; }
 
 protected:
@@ -64,31 +77,111 @@ public:
     /** < a | V | a > */
     virtual double GetPotentialMatrixElement(const SpinorFunction& a, const RadialFunction& V) const override;
 
+    /** < b_i | a > for each b_i in b_list.
+        The Simpson weights are folded into a once, so that each integral is a single dot product.
+     */
+    virtual std::vector<double> GetInnerProducts(const std::vector<const SpinorFunction*>& b_list, const SpinorFunction& a) const override;
+
+    /** < b_i | V | a > for each b_i in b_list.
+        The Simpson weights and V are folded into a once, so that each integral is a single dot product.
+     */
+    virtual std::vector<double> GetPotentialMatrixElements(const std::vector<const SpinorFunction*>& b_list, const SpinorFunction& a, const RadialFunction& V) const override;
+
+    /** < b_i | V | a > for each orbital b_i = bank.GetOrbital(i) with i in b_indices.
+        As above, but reading b_i directly from the contiguous rows of the bank.
+     */
+    virtual std::vector<double> GetPotentialMatrixElements(const OrbitalBank& bank, const std::vector<unsigned int>& b_indices, const SpinorFunction& a, const RadialFunction& V) const override;
+
 protected:
+    /** Sum of term(i) for i < size, using four independent partial sums so that the compiler
+        can pack the additions into SIMD registers.
+        term(i) should be a simple expression of raw arrays (not std::vector) so that it is inlined.
+     */
+    template<typename LambdaTerm>
+    static double Sum(int size, LambdaTerm&& term)
+    {
+        double total0 = 0., total1 = 0., total2 = 0., total3 = 0.;
+
+        int i = 0;
+        for(; i + 3 < size; i += 4)
+        {   total0 += term(i);
+            total1 += term(i+1);
+            total2 += term(i+2);
+            total3 += term(i+3);
+        }
+        for(; i < size; i++)
+            total0 += term(i);
+
+        return (total0 + total1) + (total2 + total3);
+    }
+
+    /** Simpson's rule using the weights stored by the lattice. Odd-sized integrals use the weights
+        directly, even-sized integrals add the last point with weight dR.
+     */
     template<typename LambdaIntegrand>
     double Integrate(int size, LambdaIntegrand&& integrand) const
     {
-        double total = 0.;
         const double* dR = lattice->dR();
+        if(size <= 5)
+            return Sum(size, [&](int i){ return integrand(i) * dR[i]; });
 
-        int i = 0;
-        if(size > 5)
+        const double* weights = lattice->SimpsonWeights();
+        int simpson_size = (size%2? size: size-1);
+        double total = Sum(simpson_size, [&](int i){ return integrand(i) * weights[i]; });
+
+        if(simpson_size < size)
+            total += integrand(size-1) * dR[size-1];
+
+        return total;
+    }
+
+    /** Integrals of (b.f * weighted_f + b.g * weighted_g) for each of count functions b, where the weighted functions
+        have size points and already include the Simpson weights. get_row(n, bf, bg, b_size) sets the arrays and size
+        of the nth function b. integrand(bf, bg, i) is the unweighted integrand, used for the last point of
+        even-sized integrals and for short integrals.
+     */
+    template<typename LambdaRow, typename LambdaIntegrand>
+    std::vector<double> WeightedOverlaps(unsigned int count, LambdaRow&& get_row, int size, const double* weighted_f, const double* weighted_g, LambdaIntegrand&& integrand) const
+    {
+        std::vector<double> ret(count, 0.);
+        const double* dR = lattice->dR();
+
+        for(unsigned int n = 0; n < count; n++)
         {
-            for(i = 1; i < size-1; i+=2)
-            {
-                total += 4. * integrand(i) * dR[i]
-                        + 2. * integrand(i+1) * dR[i+1];
+            const double *bf, *bg;
+            int b_size;
+            get_row(n, bf, bg, b_size);
+            b_size = std::min(size, b_size);
+
+            if(b_size <= 5)
+            {   ret[n] = Integrate(b_size, [&](int i){ return integrand(bf, bg, i); });
+                continue;
             }
-            total = total/3.;
-            total += integrand(0) * dR[0];
-        }
 
-        while(i < size)
-        {   total += integrand(i) * dR[i];
-            i++;
+            int simpson_size = (b_size%2? b_size: b_size-1);
+
+            double total = Sum(simpson_size, [=](int i){ return bf[i] * weighted_f[i] + bg[i] * weighted_g[i]; });
+
+            if(simpson_size < b_size)
+                total += integrand(bf, bg, b_size-1) * dR[b_size-1];
+
+            ret[n] = total;
         }
-        
-        return total;
+
+        return ret;
+    }
+
+    /** WeightedOverlaps() over a list of spinor functions. */
+    template<typename LambdaIntegrand>
+    std::vector<double> WeightedOverlaps(const std::vector<const SpinorFunction*>& b_list, int size, const double* weighted_f, const double* weighted_g, LambdaIntegrand&& integrand) const
+    {
+        return WeightedOverlaps(b_list.size(),
+                                [&](unsigned int n, const double*& bf, const double*& bg, int& b_size)
+                                {   bf = b_list[n]->f.data();
+                                    bg = b_list[n]->g.data();
+                                    b_size = b_list[n]->size();
+                                },
+                                size, weighted_f, weighted_g, integrand);
     }
 };
 
@@ -0,0 +1,69 @@
+#include "OrbitalBank.h"
+#include "Include.h"
+
+namespace Ambit
+{
+OrbitalBank::OrbitalBank(const OrbitalMap& orbitals)
+{
+    std::map<OrbitalInfo, unsigned int> index;
+    for(const auto& pair: orbitals)
+        index.insert(std::make_pair(pair.first, index.size()));
+
+    Pack(orbitals, index);
+}
+
+OrbitalBank::OrbitalBank(const OrbitalMap& orbitals, const std::map<OrbitalInfo, unsigned int>& index)
+{
+    Pack(orbitals, index);
+}
+
+void OrbitalBank::Pack(const OrbitalMap& orbitals, const std::map<OrbitalInfo, unsigned int>& index)
+{
+    unsigned int num_orbitals = 0;
+    for(const auto& pair: index)
+        num_orbitals = mmax(num_orbitals, pair.second + 1);
+
+    // Pad rows to a multiple of four points so that each row starts on an aligned boundary
+    padded_size = orbitals.LargestOrbitalSize();
+    padded_size = ((padded_size + 3)/4) * 4;
+
+    f_data = RowMatrix::Zero(num_orbitals, padded_size);
+    g_data = RowMatrix::Zero(num_orbitals, padded_size);
+    dfdr_data = RowMatrix::Zero(num_orbitals, padded_size);
+    dgdr_data = RowMatrix::Zero(num_orbitals, padded_size);
+
+    sizes.assign(num_orbitals, 0);
+    kappas.assign(num_orbitals, 0);
+    pqns.assign(num_orbitals, 0);
+    energies.assign(num_orbitals, 0.);
+    orbital_list.assign(num_orbitals, nullptr);
+
+    for(const auto& pair: orbitals)
+    {
+        unsigned int i = index.at(pair.first);
+        const Orbital& orbital = *pair.second;
+
+        sizes[i] = orbital.size();
+        kappas[i] = orbital.Kappa();
+        pqns[i] = orbital.PQN();
+        energies[i] = orbital.Energy();
+        orbital_list[i] = pair.second;
+        orbital_index[pair.first] = i;
+
+        std::copy(orbital.f.begin(), orbital.f.end(), f_data.row(i).data());
+        std::copy(orbital.g.begin(), orbital.g.end(), g_data.row(i).data());
+        std::copy(orbital.dfdr.begin(), orbital.dfdr.end(), dfdr_data.row(i).data());
+        std::copy(orbital.dgdr.begin(), orbital.dgdr.end(), dgdr_data.row(i).data());
+    }
+}
+
+int OrbitalBank::GetIndex(const OrbitalInfo& info) const
+{
+    auto it = orbital_index.find(info);
+    if(it == orbital_index.end())
+        return -1;
+    else
+        return it->second;
+}
+
+}
@@ -0,0 +1,77 @@
+#ifndef ORBITAL_BANK_H
+#define ORBITAL_BANK_H
+
+#include "OrbitalMap.h"
+#include <Eigen/Dense>
+#include <vector>
+
+namespace Ambit
+{
+/** OrbitalBank is an immutable, contiguous copy of a set of orbitals for use in hot loops.
+    Each orbital is a row of the arrays f, g, dfdr and dgdr, padded with zeros to a common
+    length that is a multiple of four points, and is referred to by an integer index.
+    Kappa, pqn, energy and the true size of each orbital are stored in parallel arrays.
+    The original orbitals are kept, so the bank can also be used as a view of the OrbitalMap.
+ */
+class OrbitalBank
+{
+public:
+    /** Pack all orbitals of the map, indexed in map order. */
+    OrbitalBank(const OrbitalMap& orbitals);
+
+    /** Pack all orbitals of the map using the given index, e.g. OrbitalManager::state_index,
+        so that bank indices match integral keys.
+        Rows are allocated up to the largest value in index, so for a small subset of a large index
+        pack the map in its own order instead and translate rows to the index.
+        PRE: index contains all orbitals of the map, with values less than index.size().
+     */
+    OrbitalBank(const OrbitalMap& orbitals, const std::map<OrbitalInfo, unsigned int>& index);
+
+    /** Number of orbitals (rows). */
+    unsigned int size() const { return orbital_list.size(); }
+
+    /** Length of each row, at least as large as the largest orbital. */
+    unsigned int PaddedSize() const { return padded_size; }
+
+    /** Number of lattice points in orbital i (excluding padding). */
+    unsigned int Size(unsigned int i) const { return sizes[i]; }
+    int Kappa(unsigned int i) const { return kappas[i]; }
+    int PQN(unsigned int i) const { return pqns[i]; }
+    double Energy(unsigned int i) const { return energies[i]; }
+
+    int L(unsigned int i) const { return (kappas[i] > 0)? kappas[i]: -kappas[i]-1; }
+    int TwoJ(unsigned int i) const { return 2*abs(kappas[i]) - 1; }
+
+    const double* f(unsigned int i) const { return f_data.row(i).data(); }
+    const double* g(unsigned int i) const { return g_data.row(i).data(); }
+    const double* dfdr(unsigned int i) const { return dfdr_data.row(i).data(); }
+    const double* dgdr(unsigned int i) const { return dgdr_data.row(i).data(); }
+
+    /** Original orbital stored in row i (null if the index has no orbital). */
+    pOrbitalConst GetOrbital(unsigned int i) const { return orbital_list[i]; }
+
+    /** Index of orbital with given info, or -1 if it is not in the bank. */
+    int GetIndex(const OrbitalInfo& info) const;
+
+protected:
+    void Pack(const OrbitalMap& orbitals, const std::map<OrbitalInfo, unsigned int>& index);
+
+protected:
+    typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMatrix;
+
+    unsigned int padded_size;
+    RowMatrix f_data, g_data, dfdr_data, dgdr_data;
+
+    std::vector<unsigned int> sizes;
+    std::vector<int> kappas;
+    std::vector<int> pqns;
+    std::vector<double> energies;
+    std::vector<pOrbitalConst> orbital_list;
+    std::map<OrbitalInfo, unsigned int> orbital_index;
+};
+
+typedef std::shared_ptr<OrbitalBank> pOrbitalBank;
+typedef std::shared_ptr<const OrbitalBank> pOrbitalBankConst;
+
+}
+#endif
@@ -0,0 +1,88 @@
+#include "OrbitalBank.h"
+#include "gtest/gtest.h"
+#include "Core.h"
+#include "Include.h"
+#include "HFOperator.h"
+#include "HartreeFocker.h"
+#include "HartreeY.h"
+
+using namespace Ambit;
+
+TEST(OrbitalBankTester, BatchedHartreeY)
+{
+    pLattice lattice(new Lattice(1000, 1.e-6, 50.));
+
+    // Na+ core
+    unsigned int Z = 11;
+    pCore core(new Core(lattice, "1s2 2s2 2p6"));
+
+    pIntegrator integrator(new SimpsonsIntegrator(lattice));
+    pODESolver ode_solver(new AdamsSolver(integrator));
+    pCoulombOperator coulomb(new CoulombOperator(lattice, ode_solver));
+    pPhysicalConstant physical_constant(new PhysicalConstant());
+    pHFOperator t(new HFOperator(Z, core, physical_constant, integrator, coulomb));
+    HartreeFocker HF_Solver(ode_solver);
+
+    HF_Solver.StartCore(core, t);
+    HF_Solver.SolveCore(core, t);
+
+    // Pack in reverse map order to check that the index is respected
+    std::map<OrbitalInfo, unsigned int> index;
+    unsigned int reverse_index = core->size();
+    for(const auto& pair: *core)
+        index[pair.first] = --reverse_index;
+
+    OrbitalBank bank(*core, index);
+    ASSERT_EQ(core->size(), bank.size());
+    EXPECT_EQ(0, bank.PaddedSize()%4);
+    EXPECT_GE(bank.PaddedSize(), core->LargestOrbitalSize());
+
+    std::vector<unsigned int> all_indices;
+    for(const auto& pair: *core)
+    {
+        unsigned int i = index[pair.first];
+        const Orbital& orbital = *pair.second;
+        all_indices.push_back(i);
+
+        EXPECT_EQ(i, bank.GetIndex(pair.first));
+        EXPECT_EQ(pair.second, bank.GetOrbital(i));
+        EXPECT_EQ(orbital.Kappa(), bank.Kappa(i));
+        EXPECT_EQ(orbital.PQN(), bank.PQN(i));
+        EXPECT_EQ(orbital.L(), bank.L(i));
+        EXPECT_EQ(orbital.TwoJ(), bank.TwoJ(i));
+        EXPECT_EQ(orbital.Energy(), bank.Energy(i));
+        ASSERT_EQ(orbital.size(), bank.Size(i));
+
+        for(unsigned int r = 0; r < orbital.size(); r++)
+        {   EXPECT_EQ(orbital.f[r], bank.f(i)[r]);
+            EXPECT_EQ(orbital.dgdr[r], bank.dgdr(i)[r]);
+        }
+        for(unsigned int r = orbital.size(); r < bank.PaddedSize(); r++)
+            EXPECT_EQ(0., bank.g(i)[r]);
+    }
+    EXPECT_EQ(-1, bank.GetIndex(OrbitalInfo(3, -1)));
+
+    // Batched < b | Y^k_{cd} | a > should match the single integrals
+    pHartreeY hartreeY(new HartreeY(integrator, coulomb));
+    for(const auto& c: *core)
+        for(const auto& d: *core)
+        {
+            int k = hartreeY->SetOrbitals(c.second, d.second);
+            while(k != -1)
+            {
+                for(const auto& a: *core)
+                {
+                    std::vector<double> batch = hartreeY->GetMatrixElements(bank, all_indices, *a.second);
+                    ASSERT_EQ(all_indices.size(), batch.size());
+
+                    unsigned int n = 0;
+                    for(const auto& b: *core)
+                    {   double single = hartreeY->GetMatrixElement(*b.second, *a.second);
+                        EXPECT_NEAR(single, batch[n], 1.e-12 * mmax(1., fabs(single)));
+                        n++;
+                    }
+                }
+                k = hartreeY->NextK();
+            }
+        }
+}
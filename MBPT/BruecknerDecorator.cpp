@@ -53,6 +53,15 @@ double BruecknerDecorator::GetSigmaScaling(int kappa) const
     return scaling;
 }
 
+void BruecknerDecorator::CompressSigmas(double tolerance)
+{
+    for(auto& pair: sigmas)
+    {
+        pair.second->Compress(tolerance);
+        *logstream << "Sigma for kappa = " << pair.first << " compressed to rank " << pair.second->GetRank() << std::endl;
+    }
+}
+
 /** Attempt to read sigma with given kappa, filename is "identifier.[kappa].sigma". */
 void BruecknerDecorator::Read(const std::string& identifier, int kappa)
 {
@@ -46,6 +46,9 @@ public:
     /** Get the scaling parameter for given kappa. */
     double GetSigmaScaling(int kappa) const;
 
+    /** Replace all sigma matrices by low-rank approximations (see SigmaPotential::Compress()). */
+    void CompressSigmas(double tolerance);
+
     /** Attempt to read sigma with given kappa, filename is "identifier.[kappa].sigma". */
     void Read(const std::string& identifier, int kappa);
 
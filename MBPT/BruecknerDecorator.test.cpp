@@ -77,6 +77,13 @@ TEST(BruecknerDecoratorTester, MgIISlow)
 
     EXPECT_NEAR(direct_summation - hf_energy, brueckner_matrix_element - hf_energy, 0.01 * fabs(direct_summation - hf_energy));
 
+    // Low-rank sigma should not change the matrix element
+    brueckner->CompressSigmas(1.e-8);
+    double compressed_matrix_element = brueckner->GetMatrixElement(*brueckner_target, *brueckner_target);
+    *logstream << "Compressed: " << compressed_matrix_element * MathConstant::Instance()->HartreeEnergyInInvCm() << std::endl;
+
+    EXPECT_NEAR(brueckner_matrix_element - hf_energy, compressed_matrix_element - hf_energy, 1.e-5 * fabs(brueckner_matrix_element - hf_energy));
+
     // Iterate: usually around 10% difference
     pIntegrator integrator(new SimpsonsIntegrator(lattice));
     pODESolver ode_solver(new AdamsSolver(integrator));
@@ -1,5 +1,8 @@
 #include "BruecknerSigmaCalculator.h"
 #include "Include.h"
+#ifdef AMBIT_USE_OPENMP
+#include <omp.h>
+#endif
 #ifdef AMBIT_USE_MPI
 #include <mpi.h>
 #endif
@@ -20,6 +23,53 @@ void BruecknerSigmaCalculator::GetSecondOrderSigma(int kappa, SigmaPotential& si
     CalculateCorrelation4(kappa, sigma);
 }
 
+auto BruecknerSigmaCalculator::GetCoreExcitedPairs() const -> std::vector<OrbitalPair>
+{
+    std::vector<OrbitalPair> pairs;
+    int count = 0;
+
+    for(auto it_n = core->begin(); it_n != core->end(); it_n++)
+    {
+        for(auto it_alpha = excited->begin(); it_alpha != excited->end(); it_alpha++)
+        {
+        #ifdef AMBIT_USE_MPI
+            if(count%NumProcessors == ProcessorRank)
+        #endif
+                pairs.push_back(std::make_pair(it_n, it_alpha));
+            count++;
+        }
+    }
+
+    return pairs;
+}
+
+void BruecknerSigmaCalculator::AddThreadSigmas(std::vector<SigmaPotential>& thread_sigmas, SigmaPotential& sigma) const
+{
+    // Sum over threads in a fixed order so that the result does not depend on scheduling
+    SigmaPotential& new_sigma = thread_sigmas[0];
+    for(unsigned int i = 1; i < thread_sigmas.size(); i++)
+        new_sigma += thread_sigmas[i];
+
+#ifdef AMBIT_USE_MPI
+    SigmaMatrix reduced = SigmaMatrix::Zero(sigma.matrix_size, sigma.matrix_size);
+    MPI_Allreduce(new_sigma.ff.data(), reduced.data(), sigma.matrix_size * sigma.matrix_size, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    sigma.ff += reduced;
+
+    if(sigma.use_fg)
+    {   MPI_Allreduce(new_sigma.fg.data(), reduced.data(), sigma.matrix_size * sigma.matrix_size, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+        sigma.fg += reduced;
+        MPI_Allreduce(new_sigma.gf.data(), reduced.data(), sigma.matrix_size * sigma.matrix_size, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+        sigma.gf += reduced;
+    }
+    if(sigma.use_gg)
+    {   MPI_Allreduce(new_sigma.gg.data(), reduced.data(), sigma.matrix_size * sigma.matrix_size, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+        sigma.gg += reduced;
+    }
+#else
+    sigma += new_sigma;
+#endif
+}
+
 void BruecknerSigmaCalculator::CalculateCorrelation1and3(int kappa, SigmaPotential& sigma)
 {
     const bool debug = DebugOptions.LogMBPT();
@@ -29,150 +79,137 @@ void BruecknerSigmaCalculator::CalculateCorrelation1and3(int kappa, SigmaPotenti
 
     if(debug)
         *outstream << "Cor 1+3:  ";
-    double spacing = 1./double(core->size() * excited->size());
+
+    const std::vector<OrbitalPair> pairs = GetCoreExcitedPairs();
+    const int num_pairs = pairs.size();
+    double spacing = 1./double(num_pairs);
     double count = 0.;
 
     const double ValenceEnergy = ValenceEnergies.find(kappa)->second;
-    MathConstant* constants = MathConstant::Instance()->Instance();
     unsigned int sigma_size = sigma.size();
 
-    int k1;
-
-#ifdef AMBIT_USE_MPI
-    SigmaPotential new_sigma(sigma);
-    new_sigma.clear();
-    int proc = 0;  // Processor index
+    // Each thread accumulates into its own sigma using its own HartreeY operator.
+    // These are created outside the parallel region since they must subscribe to the lattice.
+#ifdef AMBIT_USE_OPENMP
+    int num_threads = omp_get_max_threads();
+#else
+    int num_threads = 1;
 #endif
+    std::vector<SigmaPotential> thread_sigmas(num_threads, sigma);
+    std::vector<pHartreeY> thread_hartreeY(num_threads);
+    for(int i = 0; i < num_threads; i++)
+    {   thread_sigmas[i].clear();
+        thread_hartreeY[i] = hartreeY->Clone();
+    }
 
-    // Firstly, get the loop 24
-    auto it_n = core->begin();
-    while(it_n != core->end())
+    int pp;
+#ifdef AMBIT_USE_OPENMP
+    #pragma omp parallel for private(pp) schedule(dynamic)
+#endif
+    for(pp = 0; pp < num_pairs; pp++)
     {
+    #ifdef AMBIT_USE_OPENMP
+        int thread = omp_get_thread_num();
+    #else
+        int thread = 0;
+    #endif
+        MathConstant* constants = MathConstant::Instance();
+        pHartreeY hartreeY_n_alpha = thread_hartreeY[thread];
+
+        auto it_n = pairs[pp].first;
+        auto it_alpha = pairs[pp].second;
         const Orbital& sn = *it_n->second;
+        const Orbital& salpha = *(it_alpha->second);
 
-        auto it_alpha = excited->begin();
-        while(it_alpha != excited->end())
+        if(debug)
         {
-            const Orbital& salpha = *(it_alpha->second);
-
-            if(debug)
+        #ifdef AMBIT_USE_OPENMP
+            #pragma omp critical(BRUECKNER_PROGRESS)
+        #endif
             {   count += spacing;
                 if(count >= 0.02)
                 {   *logstream << ".";
                     count -= 0.02;
                 }
             }
+        }
 
-            k1 = hartreeY->SetOrbitals(it_n->second, it_alpha->second);
+        // All terms for this (n, alpha) are of the form Y * Y^T, added to sigma as a single matrix product
+        std::vector<SpinorFunction> Y;
+        std::vector<double> coefficients;
 
-            while(k1 != -1)
-            {
-                #ifdef AMBIT_USE_MPI
-                if(proc == ProcessorRank)
-                {
-                #endif
+        int k1 = hartreeY_n_alpha->SetOrbitals(it_n->second, it_alpha->second);
 
-                double C_nalpha = constants->Electron3j(sn.TwoJ(), salpha.TwoJ(), k1);
+        while(k1 != -1)
+        {
+            double C_nalpha = constants->Electron3j(sn.TwoJ(), salpha.TwoJ(), k1);
 
-                if(C_nalpha)
+            if(C_nalpha)
+            {
+                C_nalpha = C_nalpha * C_nalpha * it_n->first.MaxNumElectrons() * it_alpha->first.MaxNumElectrons()
+                                            / (2. * k1 + 1.);
+
+                // Correlation 1 has excited state beta
+                auto it_beta = excited->begin();
+                while(it_beta != excited->end())
                 {
-                    C_nalpha = C_nalpha * C_nalpha * it_n->first.MaxNumElectrons() * it_alpha->first.MaxNumElectrons()
-                                                / (2. * k1 + 1.);
+                    const Orbital& sbeta = *(it_beta->second);
+
+                    double coeff;
+                    if(InQSpace(OrbitalInfo(sn), OrbitalInfo(salpha), OrbitalInfo(sbeta)) && ParityCheck(external_L, sbeta.L(), k1))
+                        coeff = constants->Electron3j(external_twoJ, sbeta.TwoJ(), k1);
+                    else
+                        coeff = 0.;
 
-                    // Correlation 1 has excited state beta
-                    auto it_beta = excited->begin();
-                    while(it_beta != excited->end())
+                    if(coeff)
                     {
-                        const Orbital& sbeta = *(it_beta->second);
+                        coeff = coeff * coeff * C_nalpha * it_beta->first.MaxNumElectrons();
+                        coeff = coeff/(ValenceEnergy + sn.Energy() - sbeta.Energy() - salpha.Energy() + delta);
+
+                        // R1 = R_k1 (a n, beta alpha)
+                        // R2 = R_k1 (b n, beta alpha)
+                        Y.push_back(hartreeY_n_alpha->ApplyTo(sbeta, kappa));
+                        Y.back().resize(sigma_size);
+                        coefficients.push_back(coeff);
+                    }
 
-                        double coeff;
-                        if(InQSpace(OrbitalInfo(sn), OrbitalInfo(salpha), OrbitalInfo(sbeta)) && ParityCheck(external_L, sbeta.L(), k1))
-                            coeff = constants->Electron3j(external_twoJ, sbeta.TwoJ(), k1);
-                        else
-                            coeff = 0.;
+                    it_beta++;
+                }
 
-                        if(coeff)
-                        {
-                            coeff = coeff * coeff * C_nalpha * it_beta->first.MaxNumElectrons();
-                            coeff = coeff/(ValenceEnergy + sn.Energy() - sbeta.Energy() - salpha.Energy() + delta);
-
-                            // R1 = R_k1 (a n, beta alpha)
-                            // R2 = R_k1 (b n, beta alpha)
-                            SpinorFunction Ybeta = hartreeY->ApplyTo(sbeta, kappa);
-                            Ybeta.resize(sigma_size);
-
-                            #ifdef AMBIT_USE_MPI
-                            new_sigma.AddToSigma(Ybeta, Ybeta, coeff);
-                            #else
-                            sigma.AddToSigma(Ybeta, Ybeta, coeff);
-                            #endif
-                        }
+                // Correlation 3 has core state m
+                auto it_m = core->begin();
+                while(it_m != core->end())
+                {
+                    const Orbital& sm = *(it_m->second);
 
-                        it_beta++;
-                    }
+                    double coeff;
+                    if(InQSpace(OrbitalInfo(sn), OrbitalInfo(salpha), OrbitalInfo(sm)) && ParityCheck(external_L, sm.L(), k1))
+                        coeff =  constants->Electron3j(external_twoJ, sm.TwoJ(), k1);
+                    else
+                        coeff = 0.;
 
-                    // Correlation 3 has core state m
-                    auto it_m = core->begin();
-                    while(it_m != core->end())
+                    if(coeff)
                     {
-                        const Orbital& sm = *(it_m->second);
-
-                        double coeff;
-                        if(InQSpace(OrbitalInfo(sn), OrbitalInfo(salpha), OrbitalInfo(sm)) && ParityCheck(external_L, sm.L(), k1))
-                            coeff =  constants->Electron3j(external_twoJ, sm.TwoJ(), k1);
-                        else
-                            coeff = 0.;
-
-                        if(coeff)
-                        {
-                            coeff = coeff * coeff * C_nalpha * it_m->first.MaxNumElectrons();
-                            coeff = coeff/(ValenceEnergy + salpha.Energy() - sn.Energy() - sm.Energy() - delta);
-
-                            // R1 = R_k1 (a alpha, m n)
-                            // R2 = R_k1 (b alpha, m n)
-                            SpinorFunction Ym = hartreeY->ApplyTo(sm, kappa, true);
-                            Ym.resize(sigma_size);
-
-                            #ifdef AMBIT_USE_MPI
-                            new_sigma.AddToSigma(Ym, Ym, coeff);
-                            #else
-                            sigma.AddToSigma(Ym, Ym, coeff);
-                            #endif
-                        }
-                        it_m++;
+                        coeff = coeff * coeff * C_nalpha * it_m->first.MaxNumElectrons();
+                        coeff = coeff/(ValenceEnergy + salpha.Energy() - sn.Energy() - sm.Energy() - delta);
+
+                        // R1 = R_k1 (a alpha, m n)
+                        // R2 = R_k1 (b alpha, m n)
+                        Y.push_back(hartreeY_n_alpha->ApplyTo(sm, kappa, true));
+                        Y.back().resize(sigma_size);
+                        coefficients.push_back(coeff);
                     }
-                } // C_nalpha
-
-                #ifdef AMBIT_USE_MPI
+                    it_m++;
                 }
+            } // C_nalpha
 
-                if(++proc == NumProcessors)
-                    proc = 0;
-                #endif
-
-                k1 = hartreeY->NextK();
-            }
-            it_alpha++;
+            k1 = hartreeY_n_alpha->NextK();
         }
-        it_n++;
-    }
 
-#ifdef AMBIT_USE_MPI
-    SigmaMatrix reduced = SigmaMatrix::Zero(sigma.matrix_size, sigma.matrix_size);
-    MPI_Allreduce(new_sigma.ff.data(), reduced.data(), sigma.matrix_size * sigma.matrix_size, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-    sigma.ff += reduced;
-
-    if(sigma.use_fg)
-    {   MPI_Allreduce(new_sigma.fg.data(), reduced.data(), sigma.matrix_size * sigma.matrix_size, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-        sigma.fg += reduced;
-        MPI_Allreduce(new_sigma.gf.data(), reduced.data(), sigma.matrix_size * sigma.matrix_size, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-        sigma.gf += reduced;
+        thread_sigmas[thread].AddToSigma(Y, Y, coefficients);
     }
-    if(sigma.use_gg)
-    {   MPI_Allreduce(new_sigma.gg.data(), reduced.data(), sigma.matrix_size * sigma.matrix_size, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-        sigma.gg += reduced;
-    }
-#endif
+
+    AddThreadSigmas(thread_sigmas, sigma);
 }
 
 void BruecknerSigmaCalculator::CalculateCorrelation2(int kappa, SigmaPotential& sigma)
@@ -185,142 +222,144 @@ void BruecknerSigmaCalculator::CalculateCorrelation2(int kappa, SigmaPotential&
 
     if(debug)
         *outstream << "Cor 2:    ";
-    double spacing = 1./double(core->size() * excited->size());
+
+    const std::vector<OrbitalPair> pairs = GetCoreExcitedPairs();
+    const int num_pairs = pairs.size();
+    double spacing = 1./double(num_pairs);
     double count = 0.;
 
     const double ValenceEnergy = ValenceEnergies.find(kappa)->second;
-    MathConstant* constants = MathConstant::Instance();
     unsigned int sigma_size = sigma.size();
 
-    int k1, k2;
-
-    pHartreeY hartreeY1(hartreeY->Clone());
-    pHartreeY hartreeY2(hartreeY->Clone());
-
-#ifdef AMBIT_USE_MPI
-    SigmaPotential new_sigma(sigma);
-    new_sigma.clear();
-    int proc = 0;  // Processor index
+#ifdef AMBIT_USE_OPENMP
+    int num_threads = omp_get_max_threads();
+#else
+    int num_threads = 1;
 #endif
+    std::vector<SigmaPotential> thread_sigmas(num_threads, sigma);
+    std::vector<pHartreeY> thread_hartreeY1(num_threads);
+    std::vector<pHartreeY> thread_hartreeY2(num_threads);
+    for(int i = 0; i < num_threads; i++)
+    {   thread_sigmas[i].clear();
+        thread_hartreeY1[i] = hartreeY->Clone();
+        thread_hartreeY2[i] = hartreeY->Clone();
+    }
 
-    auto it_n = core->begin();
-    while(it_n != core->end())
+    int pp;
+#ifdef AMBIT_USE_OPENMP
+    #pragma omp parallel for private(pp) schedule(dynamic)
+#endif
+    for(pp = 0; pp < num_pairs; pp++)
     {
+    #ifdef AMBIT_USE_OPENMP
+        int thread = omp_get_thread_num();
+    #else
+        int thread = 0;
+    #endif
+        MathConstant* constants = MathConstant::Instance();
+        pHartreeY hartreeY1 = thread_hartreeY1[thread];
+        pHartreeY hartreeY2 = thread_hartreeY2[thread];
+
+        auto it_n = pairs[pp].first;
+        auto it_alpha = pairs[pp].second;
         const Orbital& sn = *(it_n->second);
+        const Orbital& salpha = *(it_alpha->second);
 
-        auto it_alpha = excited->begin();
-        while(it_alpha != excited->end())
+        if(debug)
         {
-            const Orbital& salpha = *(it_alpha->second);
-
-            if(debug)
+        #ifdef AMBIT_USE_OPENMP
+            #pragma omp critical(BRUECKNER_PROGRESS)
+        #endif
             {   count += spacing;
                 if(count >= 0.02)
                 {   *logstream << ".";
                     count -= 0.02;
                 }
             }
+        }
 
-            k1 = hartreeY1->SetOrbitals(it_n->second, it_alpha->second);
+        // Terms Y1 * Y2^T for this (n, alpha), added to sigma as a single matrix product
+        std::vector<SpinorFunction> Y1s, Y2s;
+        std::vector<double> coefficients;
 
-            while(k1 != -1)
-            {
-                #ifdef AMBIT_USE_MPI
-                if(proc == ProcessorRank)
-                {
-                #endif
+        int k1 = hartreeY1->SetOrbitals(it_n->second, it_alpha->second);
 
-                double C_nalpha = constants->Electron3j(sn.TwoJ(), salpha.TwoJ(), k1);
+        while(k1 != -1)
+        {
+            double C_nalpha = constants->Electron3j(sn.TwoJ(), salpha.TwoJ(), k1);
+
+            if(C_nalpha && !hartreeY1->isZero())
+            {
+                C_nalpha = C_nalpha * it_n->first.MaxNumElectrons() * it_alpha->first.MaxNumElectrons();
 
-                if(C_nalpha && !hartreeY1->isZero())
+                auto it_beta = excited->begin();
+                while(it_beta != excited->end())
                 {
-                    C_nalpha = C_nalpha * it_n->first.MaxNumElectrons() * it_alpha->first.MaxNumElectrons();
+                    const Orbital& sbeta = *(it_beta->second);
 
-                    auto it_beta = excited->begin();
-                    while(it_beta != excited->end())
-                    {
-                        const Orbital& sbeta = *(it_beta->second);
+                    double C_abeta;
+                    if(InQSpace(OrbitalInfo(sn), OrbitalInfo(salpha), OrbitalInfo(sbeta)) && ParityCheck(external_L, sbeta.L(), k1))
+                        C_abeta = constants->Electron3j(external_twoJ, sbeta.TwoJ(), k1);
+                    else
+                        C_abeta = 0.;
 
-                        double C_abeta;
-                        if(InQSpace(OrbitalInfo(sn), OrbitalInfo(salpha), OrbitalInfo(sbeta)) && ParityCheck(external_L, sbeta.L(), k1))
-                            C_abeta = constants->Electron3j(external_twoJ, sbeta.TwoJ(), k1);
-                        else
-                            C_abeta = 0.;
+                    if(C_abeta && (external_L + salpha.L() + sn.L() + sbeta.L())%2 == 0)
+                    {
+                        C_abeta = C_abeta * it_beta->first.MaxNumElectrons();
+                        C_abeta = C_abeta/(ValenceEnergy + sn.Energy() - sbeta.Energy() - salpha.Energy() + delta);
 
-                        if(C_abeta && (external_L + salpha.L() + sn.L() + sbeta.L())%2 == 0)
-                        {
-                            C_abeta = C_abeta * it_beta->first.MaxNumElectrons();
-                            C_abeta = C_abeta/(ValenceEnergy + sn.Energy() - sbeta.Energy() - salpha.Energy() + delta);
+                        // R1 = R_k1 (a n, beta alpha)
+                        SpinorFunction Y1 = hartreeY1->ApplyTo(sbeta, kappa);
+                        Y1.resize(sigma_size);
 
-                            // R1 = R_k1 (a n, beta alpha)
-                            SpinorFunction Y1 = hartreeY1->ApplyTo(sbeta, kappa);
-                            Y1.resize(sigma_size);
+                        // Sum over k2 first: Y1 * (Sum_k2 coeff * Y2)^T
+                        SpinorFunction Y2_sum(kappa, sigma_size);
+                        bool Y2_found = false;
 
-                            k2 = hartreeY2->SetOrbitals(it_n->second, it_beta->second);
+                        int k2 = hartreeY2->SetOrbitals(it_n->second, it_beta->second);
 
-                            while(k2 != -1)
-                            {
-                                double coeff
-                                = C_abeta * C_nalpha * constants->Electron3j(external_twoJ, salpha.TwoJ(), k2)
-                                    * constants->Electron3j(sbeta.TwoJ(), sn.TwoJ(), k2)
-                                    * constants->Wigner6j(external_J, sbeta.J(), k1, sn.J(), salpha.J(), k2);
-                                    // Note: The 6j symbol is given incorrectly in Berengut et al. PRA 73, 012504 (2006)
-
-                                if(coeff)
-                                {   // Sign
-                                    if((k1 + k2)%2)
-                                        coeff = -coeff;
-
-                                    // R2 = R_k2 (beta alpha, n b) = R_k2 (b n, alpha beta)
-                                    SpinorFunction Y2 = hartreeY2->ApplyTo(salpha, kappa);
-                                    if(Y2.size())
-                                    {
-                                        Y2.resize(sigma_size);
-
-                                        #ifdef AMBIT_USE_MPI
-                                        new_sigma.AddToSigma(Y1, Y2, coeff);
-                                        #else
-                                        sigma.AddToSigma(Y1, Y2, coeff);
-                                        #endif
-                                    }
+                        while(k2 != -1)
+                        {
+                            double coeff
+                            = C_abeta * C_nalpha * constants->Electron3j(external_twoJ, salpha.TwoJ(), k2)
+                                * constants->Electron3j(sbeta.TwoJ(), sn.TwoJ(), k2)
+                                * constants->Wigner6j(external_J, sbeta.J(), k1, sn.J(), salpha.J(), k2);
+                                // Note: The 6j symbol is given incorrectly in Berengut et al. PRA 73, 012504 (2006)
+
+                            if(coeff)
+                            {   // Sign
+                                if((k1 + k2)%2)
+                                    coeff = -coeff;
+
+                                // R2 = R_k2 (beta alpha, n b) = R_k2 (b n, alpha beta)
+                                SpinorFunction Y2 = hartreeY2->ApplyTo(salpha, kappa);
+                                if(Y2.size())
+                                {
+                                    Y2.resize(sigma_size);
+                                    Y2_sum += Y2 * coeff;
+                                    Y2_found = true;
                                 }
-                                k2 = hartreeY2->NextK();
                             }
+                            k2 = hartreeY2->NextK();
                         }
-                        it_beta++;
-                    }
-                } // C_nalpha
 
-                #ifdef AMBIT_USE_MPI
+                        if(Y2_found)
+                        {   Y1s.push_back(std::move(Y1));
+                            Y2s.push_back(std::move(Y2_sum));
+                            coefficients.push_back(1.);
+                        }
+                    }
+                    it_beta++;
                 }
+            } // C_nalpha
 
-                if(++proc == NumProcessors)
-                    proc = 0;
-                #endif
-
-                k1 = hartreeY1->NextK();
-            }
-            it_alpha++;
+            k1 = hartreeY1->NextK();
         }
-        it_n++;
-    }
-
-#ifdef AMBIT_USE_MPI
-    SigmaMatrix reduced = SigmaMatrix::Zero(sigma.matrix_size, sigma.matrix_size);
-    MPI_Allreduce(new_sigma.ff.data(), reduced.data(), sigma.matrix_size * sigma.matrix_size, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-    sigma.ff += reduced;
 
-    if(sigma.use_fg)
-    {   MPI_Allreduce(new_sigma.fg.data(), reduced.data(), sigma.matrix_size * sigma.matrix_size, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-        sigma.fg += reduced;
-        MPI_Allreduce(new_sigma.gf.data(), reduced.data(), sigma.matrix_size * sigma.matrix_size, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-        sigma.gf += reduced;
+        thread_sigmas[thread].AddToSigma(Y1s, Y2s, coefficients);
     }
-    if(sigma.use_gg)
-    {   MPI_Allreduce(new_sigma.gg.data(), reduced.data(), sigma.matrix_size * sigma.matrix_size, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-        sigma.gg += reduced;
-    }
-#endif
+
+    AddThreadSigmas(thread_sigmas, sigma);
 }
 
 void BruecknerSigmaCalculator::CalculateCorrelation4(int kappa, SigmaPotential& sigma)
@@ -333,144 +372,146 @@ void BruecknerSigmaCalculator::CalculateCorrelation4(int kappa, SigmaPotential&
 
     if(debug)
         *outstream << "Cor 4:    ";
-    double spacing = 1./double(core->size() * excited->size());
+
+    const std::vector<OrbitalPair> pairs = GetCoreExcitedPairs();
+    const int num_pairs = pairs.size();
+    double spacing = 1./double(num_pairs);
     double count = 0.;
 
     const double ValenceEnergy = ValenceEnergies.find(kappa)->second;
-    MathConstant* constants = MathConstant::Instance();
     unsigned int sigma_size = sigma.size();
 
-    int k1, k2;
-
-    pHartreeY hartreeY1(hartreeY->Clone());
-    pHartreeY hartreeY2(hartreeY->Clone());
-
-#ifdef AMBIT_USE_MPI
-    SigmaPotential new_sigma(sigma);
-    new_sigma.clear();
-    int proc = 0;  // Processor index
+#ifdef AMBIT_USE_OPENMP
+    int num_threads = omp_get_max_threads();
+#else
+    int num_threads = 1;
 #endif
+    std::vector<SigmaPotential> thread_sigmas(num_threads, sigma);
+    std::vector<pHartreeY> thread_hartreeY1(num_threads);
+    std::vector<pHartreeY> thread_hartreeY2(num_threads);
+    for(int i = 0; i < num_threads; i++)
+    {   thread_sigmas[i].clear();
+        thread_hartreeY1[i] = hartreeY->Clone();
+        thread_hartreeY2[i] = hartreeY->Clone();
+    }
 
-    auto it_n = core->begin();
-    while(it_n != core->end())
+    int pp;
+#ifdef AMBIT_USE_OPENMP
+    #pragma omp parallel for private(pp) schedule(dynamic)
+#endif
+    for(pp = 0; pp < num_pairs; pp++)
     {
+    #ifdef AMBIT_USE_OPENMP
+        int thread = omp_get_thread_num();
+    #else
+        int thread = 0;
+    #endif
+        MathConstant* constants = MathConstant::Instance();
+        pHartreeY hartreeY1 = thread_hartreeY1[thread];
+        pHartreeY hartreeY2 = thread_hartreeY2[thread];
+
+        auto it_n = pairs[pp].first;
+        auto it_alpha = pairs[pp].second;
         const OrbitalInfo& info_n = it_n->first;
         const Orbital& sn = *(it_n->second);
+        const OrbitalInfo& info_alpha = it_alpha->first;
+        const Orbital& salpha = *(it_alpha->second);
 
-        auto it_alpha = excited->begin();
-        while(it_alpha != excited->end())
+        if(debug)
         {
-            const OrbitalInfo& info_alpha = it_alpha->first;
-            const Orbital& salpha = *(it_alpha->second);
-
-            if(debug)
+        #ifdef AMBIT_USE_OPENMP
+            #pragma omp critical(BRUECKNER_PROGRESS)
+        #endif
             {   count += spacing;
                 if(count >= 0.02)
                 {   *logstream << ".";
                     count -= 0.02;
                 }
             }
+        }
 
-            k1 = hartreeY1->SetOrbitals(it_alpha->second, it_n->second);
+        // Terms Y1 * Y2^T for this (n, alpha), added to sigma as a single matrix product
+        std::vector<SpinorFunction> Y1s, Y2s;
+        std::vector<double> coefficients;
 
-            while(k1 != -1)
-            {
-                #ifdef AMBIT_USE_MPI
-                if(proc == ProcessorRank)
-                {
-                #endif
+        int k1 = hartreeY1->SetOrbitals(it_alpha->second, it_n->second);
 
-                double C_nalpha = constants->Electron3j(sn.TwoJ(), salpha.TwoJ(), k1);
+        while(k1 != -1)
+        {
+            double C_nalpha = constants->Electron3j(sn.TwoJ(), salpha.TwoJ(), k1);
+
+            if(C_nalpha && !hartreeY1->isZero())
+            {
+                C_nalpha = C_nalpha * info_n.MaxNumElectrons() * info_alpha.MaxNumElectrons();
 
-                if(C_nalpha && !hartreeY1->isZero())
+                auto it_m = core->begin();
+                while(it_m != core->end())
                 {
-                    C_nalpha = C_nalpha * info_n.MaxNumElectrons() * info_alpha.MaxNumElectrons();
+                    const OrbitalInfo& info_m = it_m->first;
+                    const Orbital& sm = *(it_m->second);
 
-                    auto it_m = core->begin();
-                    while(it_m != core->end())
+                    double C_am;
+                    if(InQSpace(OrbitalInfo(sn), OrbitalInfo(salpha), OrbitalInfo(sm)) && ParityCheck(external_L, sm.L(), k1))
+                        C_am = constants->Electron3j(external_twoJ, sm.TwoJ(), k1);
+                    else
+                        C_am = 0.;
+
+                    if(C_am && (external_L + sn.L() + sm.L() + salpha.L())%2 == 0)
                     {
-                        const OrbitalInfo& info_m = it_m->first;
-                        const Orbital& sm = *(it_m->second);
+                        C_am = C_am * info_m.MaxNumElectrons();
+                        C_am = C_am/(ValenceEnergy + salpha.Energy() - sn.Energy() - sm.Energy() - delta);
 
-                        double C_am;
-                        if(InQSpace(OrbitalInfo(sn), OrbitalInfo(salpha), OrbitalInfo(sm)) && ParityCheck(external_L, sm.L(), k1))
-                            C_am = constants->Electron3j(external_twoJ, sm.TwoJ(), k1);
-                        else
-                            C_am = 0.;
+                        // R1 = R_k1 (a alpha, m n)
+                        SpinorFunction Y1 = hartreeY1->ApplyTo(sm, kappa);
+                        Y1.resize(sigma_size);
 
-                        if(C_am && (external_L + sn.L() + sm.L() + salpha.L())%2 == 0)
-                        {
-                            C_am = C_am * info_m.MaxNumElectrons();
-                            C_am = C_am/(ValenceEnergy + salpha.Energy() - sn.Energy() - sm.Energy() - delta);
+                        // Sum over k2 first: Y1 * (Sum_k2 coeff * Y2)^T
+                        SpinorFunction Y2_sum(kappa, sigma_size);
+                        bool Y2_found = false;
 
-                            // R1 = R_k1 (a alpha, m n)
-                            SpinorFunction Y1 = hartreeY1->ApplyTo(sm, kappa);
-                            Y1.resize(sigma_size);
+                        int k2 = hartreeY2->SetOrbitals(it_alpha->second, it_m->second);
 
-                            k2 = hartreeY2->SetOrbitals(it_alpha->second, it_m->second);
+                        while(k2 != -1)
+                        {
+                            double coeff
+                            = C_am * C_nalpha * constants->Electron3j(external_twoJ, sn.TwoJ(), k2)
+                                * constants->Electron3j(sm.TwoJ(), salpha.TwoJ(), k2)
+                                * constants->Wigner6j(external_J, sm.J(), k1, salpha.J(), sn.J(), k2);
 
-                            while(k2 != -1)
+                            if(coeff)
                             {
-                                double coeff
-                                = C_am * C_nalpha * constants->Electron3j(external_twoJ, sn.TwoJ(), k2)
-                                    * constants->Electron3j(sm.TwoJ(), salpha.TwoJ(), k2)
-                                    * constants->Wigner6j(external_J, sm.J(), k1, salpha.J(), sn.J(), k2);
+                                // Sign
+                                if((k1 + k2)%2)
+                                    coeff = -coeff;
 
-                                if(coeff)
+                                // R2 = R_k2 (m n, alpha b) = R_k2 (b alpha, n m)
+                                SpinorFunction Y2 = hartreeY2->ApplyTo(sn, kappa);
+                                if(Y2.size())
                                 {
-                                    // Sign
-                                    if((k1 + k2)%2)
-                                        coeff = -coeff;
-
-                                    // R2 = R_k2 (m n, alpha b) = R_k2 (b alpha, n m)
-                                    SpinorFunction Y2 = hartreeY2->ApplyTo(sn, kappa);
-                                    if(Y2.size())
-                                    {
-                                        Y2.resize(sigma_size);
-
-                                        #ifdef AMBIT_USE_MPI
-                                        new_sigma.AddToSigma(Y1, Y2, coeff);
-                                        #else
-                                        sigma.AddToSigma(Y1, Y2, coeff);
-                                        #endif
-                                    }
+                                    Y2.resize(sigma_size);
+                                    Y2_sum += Y2 * coeff;
+                                    Y2_found = true;
                                 }
-                                k2 = hartreeY2->NextK();
                             }
+                            k2 = hartreeY2->NextK();
                         }
-                        it_m++;
-                    }
-                } // C_nalpha
 
-                #ifdef AMBIT_USE_MPI
+                        if(Y2_found)
+                        {   Y1s.push_back(std::move(Y1));
+                            Y2s.push_back(std::move(Y2_sum));
+                            coefficients.push_back(1.);
+                        }
+                    }
+                    it_m++;
                 }
+            } // C_nalpha
 
-                if(++proc == NumProcessors)
-                    proc = 0;
-                #endif
-
-                k1 = hartreeY1->NextK();
-            }
-            it_alpha++;
+            k1 = hartreeY1->NextK();
         }
-        it_n++;
-    }
-
-#ifdef AMBIT_USE_MPI
-    SigmaMatrix reduced = SigmaMatrix::Zero(sigma.matrix_size, sigma.matrix_size);
-    MPI_Allreduce(new_sigma.ff.data(), reduced.data(), sigma.matrix_size * sigma.matrix_size, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-    sigma.ff += reduced;
 
-    if(sigma.use_fg)
-    {   MPI_Allreduce(new_sigma.fg.data(), reduced.data(), sigma.matrix_size * sigma.matrix_size, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-        sigma.fg += reduced;
-        MPI_Allreduce(new_sigma.gf.data(), reduced.data(), sigma.matrix_size * sigma.matrix_size, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-        sigma.gf += reduced;
+        thread_sigmas[thread].AddToSigma(Y1s, Y2s, coefficients);
     }
-    if(sigma.use_gg)
-    {   MPI_Allreduce(new_sigma.gg.data(), reduced.data(), sigma.matrix_size * sigma.matrix_size, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
-        sigma.gg += reduced;
-    }
-#endif
+
+    AddThreadSigmas(thread_sigmas, sigma);
 }
 }
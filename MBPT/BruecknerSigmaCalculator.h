@@ -33,6 +33,15 @@ protected:
     void CalculateCorrelation2(int kappa, SigmaPotential& sigma);
     void CalculateCorrelation4(int kappa, SigmaPotential& sigma);
 
+    /** Pair of iterators to core orbital n and excited orbital alpha. */
+    typedef std::pair<OrbitalMap::const_iterator, OrbitalMap::const_iterator> OrbitalPair;
+
+    /** All (n, alpha) pairs that are the outer loop of the diagrams. With MPI only those assigned to this processor. */
+    std::vector<OrbitalPair> GetCoreExcitedPairs() const;
+
+    /** Sum sigmas calculated by each thread (and each processor with MPI), and add to sigma. */
+    void AddThreadSigmas(std::vector<SigmaPotential>& thread_sigmas, SigmaPotential& sigma) const;
+
     /** Parity check returns true if (a.L() + b.L() + k)%2 == 0 or include_off_parity. */
     using MBPTCalculator::ParityCheck;
     inline bool ParityCheck(const int& La, const int& Lb, const int& k) const;
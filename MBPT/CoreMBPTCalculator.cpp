@@ -10,7 +10,9 @@ namespace Ambit
 {
 CoreMBPTCalculator::CoreMBPTCalculator(pOrbitalManagerConst orbitals, pHFIntegrals one_body, pSlaterIntegrals two_body, const std::string& fermi_orbitals):
     MBPTCalculator(orbitals, fermi_orbitals, two_body->OffParityExists()), one_body(one_body), two_body(two_body), core(orbitals->core), excited(orbitals->excited)
-{}
+{
+    SetUpDiagramTables();
+}
 
 CoreMBPTCalculator::~CoreMBPTCalculator()
 {
@@ -39,6 +41,7 @@ unsigned int CoreMBPTCalculator::GetStorageSize()
 void CoreMBPTCalculator::UpdateIntegrals()
 {
     SetValenceEnergies();
+    SetUpDiagramTables();
 
     one_body->CalculateOneElectronIntegrals(excited, core);
     one_body->CalculateOneElectronIntegrals(valence, core);
@@ -552,6 +555,98 @@ double CoreMBPTCalculator::CalculateSubtraction3(const OrbitalInfo& sa, const Or
     return energy;
 }
 
+void CoreMBPTCalculator::SetUpDiagramTables()
+{
+    core_states.clear();
+    core_states.reserve(core->size());
+    for(const auto& pair: *core)
+        core_states.emplace_back(pair.first, pair.second->Energy(), valence->count(pair.first));
+
+    excited_states.clear();
+    excited_states.reserve(excited->size());
+    for(const auto& pair: *excited)
+        excited_states.emplace_back(pair.first, pair.second->Energy(), valence->count(pair.first));
+
+    // Angular tables cover every orbital in the basis; k <= (j1 + j2) <= max_two_j
+    max_two_j = 1;
+    for(const auto& pair: *orbitals->all)
+        max_two_j = mmax(max_two_j, pair.first.TwoJ());
+
+    num_j = JIndex(max_two_j) + 1;
+    num_k = max_two_j + 1;
+
+    MathConstant* constants = MathConstant::Instance();
+    electron3j_table.assign(num_j * num_j * num_k, 0.);
+
+    for(int two_j1 = 1; two_j1 <= max_two_j; two_j1 += 2)
+        for(int two_j2 = 1; two_j2 <= max_two_j; two_j2 += 2)
+            for(int k = abs(two_j1 - two_j2)/2; k <= (two_j1 + two_j2)/2; k++)
+                electron3j_table[(JIndex(two_j1) * num_j + JIndex(two_j2)) * num_k + k] = constants->Electron3j(two_j1, two_j2, k);
+}
+
+std::vector<double> CoreMBPTCalculator::TabulateWigner6jJJ(int two_j1, int two_j2, unsigned int k) const
+{
+    MathConstant* constants = MathConstant::Instance();
+    std::vector<double> table(num_j * num_j * num_k, 0.);
+
+    for(int two_j3 = 1; two_j3 <= max_two_j; two_j3 += 2)
+    {
+        for(int two_j4 = 1; two_j4 <= max_two_j; two_j4 += 2)
+        {
+            if(!constants->triangular_condition(two_j3, two_j4, 2 * k))
+                continue;
+
+            int k1 = mmax(abs(two_j1 - two_j4), abs(two_j3 - two_j2))/2;
+            int k1max = mmin(mmin(two_j1 + two_j4, two_j3 + two_j2)/2, num_k - 1);
+
+            for(; k1 <= k1max; k1++)
+                table[(JIndex(two_j3) * num_j + JIndex(two_j4)) * num_k + k1]
+                    = constants->Wigner6j(0.5 * two_j1, 0.5 * two_j2, double(k), 0.5 * two_j3, 0.5 * two_j4, double(k1));
+        }
+    }
+
+    return table;
+}
+
+std::vector<double> CoreMBPTCalculator::TabulateWigner6jKK(int two_j1, int two_j2, unsigned int k) const
+{
+    MathConstant* constants = MathConstant::Instance();
+    std::vector<double> table(num_k * num_k * num_j, 0.);
+
+    for(int two_j3 = 1; two_j3 <= max_two_j; two_j3 += 2)
+    {
+        int k1max = mmin((two_j2 + two_j3)/2, num_k - 1);
+        int k2max = mmin((two_j1 + two_j3)/2, num_k - 1);
+
+        for(int k1 = abs(two_j2 - two_j3)/2; k1 <= k1max; k1++)
+        {
+            for(int k2 = abs(two_j1 - two_j3)/2; k2 <= k2max; k2++)
+            {
+                if(constants->triangular_condition(k1, k2, k))
+                    table[(k1 * num_k + k2) * num_j + JIndex(two_j3)]
+                        = constants->Wigner6j(0.5 * two_j1, 0.5 * two_j2, double(k), double(k1), double(k2), 0.5 * two_j3);
+            }
+        }
+    }
+
+    return table;
+}
+
+void CoreMBPTCalculator::GatherK2(unsigned int k2min, unsigned int k2max, int two_j1, int two_j2, int two_j3, int two_j4, K2Block& block) const
+{
+    if(block.coeff.size() <= k2max)
+    {   block.coeff.resize(k2max + 1);
+        block.R.resize(k2max + 1);
+        block.found.resize(k2max + 1);
+    }
+
+    for(unsigned int k2 = k2min; k2 <= k2max; k2 += kstep)
+    {
+        block.coeff[k2] = Electron3j(two_j1, two_j2, k2) * Electron3j(two_j3, two_j4, k2);
+        block.found[k2] = false;
+    }
+}
+
 double CoreMBPTCalculator::CalculateTwoElectron1(unsigned int k, const OrbitalInfo& sa, const OrbitalInfo& sb, const OrbitalInfo& sc, const OrbitalInfo& sd) const
 {
     const bool debug = DebugOptions.LogMBPT();
@@ -560,36 +655,31 @@ double CoreMBPTCalculator::CalculateTwoElectron1(unsigned int k, const OrbitalIn
         *logstream << "TwoE 1:   ";
 
     double energy = 0.;
+    const int num_core = core_states.size();
     int nn;
 #ifdef AMBIT_USE_OPENMP
     #pragma omp parallel for private(nn) reduction(+:energy)
 #endif
-    /* Note: this needs to be a for loop since OpenMP doesn't gracefully handle reductions over loops
-    with non-random-access iterators */
-    for(nn = 0; nn < core->size(); ++nn)
+    for(nn = 0; nn < num_core; ++nn)
     {
-        auto it_n = core->begin();
-        std::advance(it_n, nn);
-        const OrbitalInfo& sn = it_n->first;
-        const double En = it_n->second->Energy();
+        const DiagramState& n = core_states[nn];
+        const OrbitalInfo& sn = n.info;
 
-        auto it_alpha = excited->begin();
-        while(it_alpha != excited->end())
+        for(const DiagramState& alpha: excited_states)
         {
-            const OrbitalInfo& salpha = it_alpha->first;
-            const double Ealpha = it_alpha->second->Energy();
+            const OrbitalInfo& salpha = alpha.info;
 
             double coeff;
-            if(InQSpace(sn, salpha) && ParityCheck(sn, salpha, k, sa, sc))
-                coeff = MathConstant::Instance()->Electron3j(sn.TwoJ(), salpha.TwoJ(), k);
+            if((!n.in_valence || !alpha.in_valence) && ParityCheck(sn, salpha, k, sa, sc))
+                coeff = Electron3j(n.two_j, alpha.two_j, k);
             else
                 coeff = 0.;
 
             if(coeff)
             {
-                coeff = coeff * coeff * sn.MaxNumElectrons() * salpha.MaxNumElectrons()
+                coeff = coeff * coeff * n.max_electrons * alpha.max_electrons
                                         / (2. * k + 1.);
-                double energy_denominator = (En - Ealpha + delta);
+                double energy_denominator = (n.energy - alpha.energy + delta);
 
                 // There are two diagrams:
                 //  1. R_k(a n, c alpha) * R_k(alpha b, n d)
@@ -602,7 +692,6 @@ double CoreMBPTCalculator::CalculateTwoElectron1(unsigned int k, const OrbitalIn
                 energy += TermRatio(R1 * coeff, energy_denominator, sn, salpha);
                 energy += TermRatio(R2 * coeff, energy_denominator, sn, salpha);
             }
-            it_alpha++;
         }
     }
 
@@ -619,49 +708,55 @@ double CoreMBPTCalculator::CalculateTwoElectron2(unsigned int k, const OrbitalIn
         *logstream << "TwoE 2/3: ";
 
     double energy = 0.;
-    const double coeff_ac = MathConstant::Instance()->Electron3j(sa.TwoJ(), sc.TwoJ(), k);
-    const double coeff_bd = MathConstant::Instance()->Electron3j(sb.TwoJ(), sd.TwoJ(), k);
+    const double coeff_ac = Electron3j(sa.TwoJ(), sc.TwoJ(), k);
+    const double coeff_bd = Electron3j(sb.TwoJ(), sd.TwoJ(), k);
     if(!coeff_ac || !coeff_bd)
         return energy;
 
+    // { a c k  } and { b d k  } indexed by (alpha, n, k1)
+    // { alpha n k1 }   { alpha n k1 }
+    const std::vector<double> sixj_ac = TabulateWigner6jJJ(sa.TwoJ(), sc.TwoJ(), k);
+    const std::vector<double> sixj_bd = TabulateWigner6jJJ(sb.TwoJ(), sd.TwoJ(), k);
+
     unsigned int k1, k1max;
 
+    const int num_core = core_states.size();
     int nn;
 #ifdef AMBIT_USE_OPENMP
     #pragma omp parallel for private(nn, k1, k1max) reduction(+:energy)
 #endif
-    /* Note: this needs to be a for loop since OpenMP doesn't gracefully handle reductions over loops 
-    with non-random-access iterators */
-    for(nn = 0; nn < core->size(); ++nn)
+    for(nn = 0; nn < num_core; ++nn)
     {
-        auto it_n = core->begin();
-        std::advance(it_n, nn);
-        const OrbitalInfo& sn = it_n->first;
-        const double En = it_n->second->Energy();
+        const DiagramState& n = core_states[nn];
+        const OrbitalInfo& sn = n.info;
 
-        auto it_alpha = excited->begin();
-        while(it_alpha != excited->end())
+        for(const DiagramState& alpha: excited_states)
         {
-            const OrbitalInfo& salpha = it_alpha->first;
-            const double Ealpha = it_alpha->second->Energy();
+            const OrbitalInfo& salpha = alpha.info;
 
             double C_nalpha = 0.;
-            if(InQSpace(sn, salpha) && ParityCheck(sn, salpha, k, sb, sd))
-                C_nalpha = MathConstant::Instance()->Electron3j(sn.TwoJ(), salpha.TwoJ(), k);
+            if((!n.in_valence || !alpha.in_valence) && ParityCheck(sn, salpha, k, sb, sd))
+                C_nalpha = Electron3j(n.two_j, alpha.two_j, k);
 
             if(C_nalpha)
             {
-                C_nalpha = C_nalpha * sn.MaxNumElectrons() * salpha.MaxNumElectrons();
-                double energy_denominator = En - Ealpha + delta;
+                C_nalpha = C_nalpha * n.max_electrons * alpha.max_electrons;
+                double energy_denominator = n.energy - alpha.energy + delta;
+                const int sixj_offset = (JIndex(alpha.two_j) * num_j + JIndex(n.two_j)) * num_k;
+
+                // R_k (n b, alpha d) and R_k (a n, c alpha) do not depend on k1:
+                // look each up at most once per (n, alpha).
+                double R_nbad = 0., R_anca = 0.;
+                bool have_nbad = false, have_anca = false;
 
                 k1 = kmin(sa, sn, salpha, sc);
                 k1max = kmax(sa, sn, salpha, sc);
 
                 while(k1 <= k1max)
                 {
-                    double coeff = MathConstant::Instance()->Electron3j(sa.TwoJ(), sn.TwoJ(), k1) *
-                                   MathConstant::Instance()->Electron3j(salpha.TwoJ(), sc.TwoJ(), k1) *
-                                   MathConstant::Instance()->Wigner6j(sa.J(), sc.J(), double(k), salpha.J(), sn.J(), double(k1)) *
+                    double coeff = Electron3j(sa.TwoJ(), n.two_j, k1) *
+                                   Electron3j(alpha.two_j, sc.TwoJ(), k1) *
+                                   sixj_ac[sixj_offset + k1] *
                                    C_nalpha / coeff_ac;
                     if((k1 + k)%2)
                         coeff = -coeff;
@@ -672,7 +767,11 @@ double CoreMBPTCalculator::CalculateTwoElectron2(unsigned int k, const OrbitalIn
                         double R1 = two_body->GetTwoElectronIntegral(k1, sa, salpha, sn, sc);
 
                         // R2 = R_k (n b, alpha d)
-                        double R2 = two_body->GetTwoElectronIntegral(k, sn, sb, salpha, sd);
+                        if(!have_nbad)
+                        {   R_nbad = two_body->GetTwoElectronIntegral(k, sn, sb, salpha, sd);
+                            have_nbad = true;
+                        }
+                        double R2 = R_nbad;
 
                         energy += TermRatio(R1 * R2 * coeff, energy_denominator, sn, salpha);
                     }
@@ -685,9 +784,9 @@ double CoreMBPTCalculator::CalculateTwoElectron2(unsigned int k, const OrbitalIn
 
                 while(k1 <= k1max)
                 {
-                    double coeff = MathConstant::Instance()->Electron3j(sb.TwoJ(), sn.TwoJ(), k1) *
-                                   MathConstant::Instance()->Electron3j(salpha.TwoJ(), sd.TwoJ(), k1) *
-                                   MathConstant::Instance()->Wigner6j(sb.J(), sd.J(), double(k), salpha.J(), sn.J(), double(k1)) *
+                    double coeff = Electron3j(sb.TwoJ(), n.two_j, k1) *
+                                   Electron3j(alpha.two_j, sd.TwoJ(), k1) *
+                                   sixj_bd[sixj_offset + k1] *
                                    C_nalpha / coeff_bd;
                     if((k1 + k)%2)
                         coeff = -coeff;
@@ -698,14 +797,17 @@ double CoreMBPTCalculator::CalculateTwoElectron2(unsigned int k, const OrbitalIn
                         double R1 = two_body->GetTwoElectronIntegral(k1, sb, salpha, sn, sd);
 
                         // R2 = R_k (a n, c alpha)
-                        double R2 = two_body->GetTwoElectronIntegral(k, sa, sn, sc, salpha);
+                        if(!have_anca)
+                        {   R_anca = two_body->GetTwoElectronIntegral(k, sa, sn, sc, salpha);
+                            have_anca = true;
+                        }
+                        double R2 = R_anca;
 
                         energy += TermRatio(R1 * R2 * coeff, energy_denominator, sn, salpha);
                     }
                     k1 += kstep;
                 }
             }
-            it_alpha++;
         }
     }
 
@@ -727,89 +829,93 @@ double CoreMBPTCalculator::CalculateTwoElectron4(unsigned int k, const OrbitalIn
         *logstream << "TwoE 4/5: ";
 
     double energy = 0.;
-    const double coeff_ac = MathConstant::Instance()->Electron3j(sa.TwoJ(), sc.TwoJ(), k);
-    const double coeff_bd = MathConstant::Instance()->Electron3j(sb.TwoJ(), sd.TwoJ(), k);
+    const double coeff_ac = Electron3j(sa.TwoJ(), sc.TwoJ(), k);
+    const double coeff_bd = Electron3j(sb.TwoJ(), sd.TwoJ(), k);
     if(!coeff_ac || !coeff_bd)
         return energy;
 
+    // { c a k } and { b d k     } indexed by (k1, k2, n) and (k1, k2, alpha) respectively
+    // { k1 k2 n }   { k1 k2 alpha }
+    const std::vector<double> sixj_ca = TabulateWigner6jKK(sc.TwoJ(), sa.TwoJ(), k);
+    const std::vector<double> sixj_bd = TabulateWigner6jKK(sb.TwoJ(), sd.TwoJ(), k);
+
     unsigned int k1, k1max;
     unsigned int k2, k2max;
 
+    const int num_core = core_states.size();
     int nn;
 #ifdef AMBIT_USE_OPENMP
     #pragma omp parallel for private(nn, k1, k1max, k2, k2max) reduction(+:energy)
 #endif
-    /* Note: this needs to be a for loop since OpenMP doesn't gracefully handle reductions over loops 
-    with non-random-access iterators */
-    for(nn = 0; nn < core->size(); ++nn)
+    for(nn = 0; nn < num_core; ++nn)
     {
-        auto it_n = core->begin();
-        std::advance(it_n, nn);
-
-        const OrbitalInfo& sn = it_n->first;
-        const double En = it_n->second->Energy();
+        const DiagramState& n = core_states[nn];
+        const OrbitalInfo& sn = n.info;
+        K2Block block;
 
-        auto it_alpha = excited->begin();
-        while(it_alpha != excited->end())
+        for(const DiagramState& alpha: excited_states)
         {
-            const OrbitalInfo& salpha = it_alpha->first;
-            const double Ealpha = it_alpha->second->Energy();
+            const OrbitalInfo& salpha = alpha.info;
 
             double C_nalpha = 0.;
-            if(InQSpace(sn, salpha) &&
-               ((sa.L() + sn.L() + salpha.L() + sd.L())%2 == 0) &&
-               ((sn.L() + sc.L() + sb.L() + salpha.L())%2 == 0))
-                C_nalpha = double(sn.MaxNumElectrons()) * double(salpha.MaxNumElectrons()) * (2. * double(k) + 1.);
+            if((!n.in_valence || !alpha.in_valence) &&
+               ((sa.L() + n.l + alpha.l + sd.L())%2 == 0) &&
+               ((n.l + sc.L() + sb.L() + alpha.l)%2 == 0))
+                C_nalpha = n.max_electrons * alpha.max_electrons * (2. * double(k) + 1.);
 
             if(C_nalpha)
             {
                 C_nalpha = C_nalpha/(coeff_ac*coeff_bd);
-                double energy_denominator = En - Ealpha + delta;
+                double energy_denominator = n.energy - alpha.energy + delta;
 
-                unsigned int phase = (unsigned int)(sa.TwoJ() + sb.TwoJ() + sc.TwoJ() + sd.TwoJ() + sn.TwoJ() + salpha.TwoJ())/2;
+                unsigned int phase = (unsigned int)(sa.TwoJ() + sb.TwoJ() + sc.TwoJ() + sd.TwoJ() + n.two_j + alpha.two_j)/2;
                 if(phase%2)
                     C_nalpha = -C_nalpha;
 
+                // Angular factors and integrals R_k2 (n b, c alpha) are independent of k1:
+                // gather them once per (n, alpha) and contract against each k1 below.
+                unsigned int k2min = kmin(sn, sc, sb, salpha);
+                k2max = kmax(sn, sc, sb, salpha);
+                GatherK2(k2min, k2max, n.two_j, sc.TwoJ(), sb.TwoJ(), alpha.two_j, block);
+
                 k1 = kmin(sa, sn, salpha, sd);
                 k1max = kmax(sa, sn, salpha, sd);
 
                 while(k1 <= k1max)
                 {
-                    double coeff_ad = MathConstant::Instance()->Electron3j(sa.TwoJ(), sn.TwoJ(), k1) *
-                                      MathConstant::Instance()->Electron3j(salpha.TwoJ(), sd.TwoJ(), k1);
+                    double coeff_ad = Electron3j(sa.TwoJ(), n.two_j, k1) *
+                                      Electron3j(alpha.two_j, sd.TwoJ(), k1);
 
                     if(coeff_ad)
                     {
                         // R1 = R_k1 (a alpha, n d)
                         double R1 = two_body->GetTwoElectronIntegral(k1, sa, salpha, sn, sd);
 
-                        k2 = kmin(sn, sc, sb, salpha);
-                        k2max = kmax(sn, sc, sb, salpha);
-
-                        while(k2 <= k2max)
+                        for(k2 = k2min; k2 <= k2max; k2 += kstep)
                         {
-                            double coeff = MathConstant::Instance()->Electron3j(sn.TwoJ(), sc.TwoJ(), k2) *
-                                           MathConstant::Instance()->Electron3j(sb.TwoJ(), salpha.TwoJ(), k2);
+                            double coeff = block.coeff[k2];
                             if(coeff)
-                                coeff = coeff * MathConstant::Instance()->Wigner6j(sc.J(), sa.J(), k, k1, k2, sn.J())
-                                              * MathConstant::Instance()->Wigner6j(sb.J(), sd.J(), k, k1, k2, salpha.J());
+                                coeff = coeff * sixj_ca[(k1 * num_k + k2) * num_j + JIndex(n.two_j)]
+                                              * sixj_bd[(k1 * num_k + k2) * num_j + JIndex(alpha.two_j)];
 
                             if(coeff)
                             {
                                 coeff = coeff * coeff_ad * C_nalpha;
 
                                 // R2 = R_k2 (2b, c4)
-                                double R2 = two_body->GetTwoElectronIntegral(k2, sn, sb, sc, salpha);
+                                if(!block.found[k2])
+                                {   block.R[k2] = two_body->GetTwoElectronIntegral(k2, sn, sb, sc, salpha);
+                                    block.found[k2] = true;
+                                }
+                                double R2 = block.R[k2];
 
                                 energy += TermRatio(R1 * R2 * coeff, energy_denominator, sn, salpha);
                             }
-                            k2 += kstep;
                         }
                     }
                     k1 += kstep;
                 }
             }
-            it_alpha++;
         }
     }
 
@@ -831,73 +937,76 @@ double CoreMBPTCalculator::CalculateTwoElectron6(unsigned int k, const OrbitalIn
         *logstream << "TwoE 6:   ";
 
     double energy = 0.;
-    const double coeff_ac = MathConstant::Instance()->Electron3j(sa.TwoJ(), sc.TwoJ(), k);
-    const double coeff_bd = MathConstant::Instance()->Electron3j(sb.TwoJ(), sd.TwoJ(), k);
+    const double coeff_ac = Electron3j(sa.TwoJ(), sc.TwoJ(), k);
+    const double coeff_bd = Electron3j(sb.TwoJ(), sd.TwoJ(), k);
     if(!coeff_ac || !coeff_bd)
         return energy;
 
     const double ValenceEnergy = ValenceEnergies.find(sa.Kappa())->second + ValenceEnergies.find(sb.Kappa())->second;
 
+    // { c a k } and { d b k } indexed by (k1, k2, m) and (k1, k2, n) respectively
+    // { k1 k2 m }   { k1 k2 n }
+    const std::vector<double> sixj_ca = TabulateWigner6jKK(sc.TwoJ(), sa.TwoJ(), k);
+    const std::vector<double> sixj_db = TabulateWigner6jKK(sd.TwoJ(), sb.TwoJ(), k);
+
     unsigned int k1, k1max;
     unsigned int k2, k2max;
 
+    const int num_core = core_states.size();
     int mm;
 #ifdef AMBIT_USE_OPENMP
     #pragma omp parallel for private(mm, k1, k1max, k2, k2max) reduction(+:energy)
 #endif
-    /* Note: this needs to be a for loop since OpenMP doesn't gracefully handle reductions over loops 
-    with non-random-access iterators */
-    for(mm = 0; mm < core->size(); ++mm)
+    for(mm = 0; mm < num_core; ++mm)
     {
-        auto it_m = core->begin();
-        std::advance(it_m, mm);
-        const OrbitalInfo& sm = it_m->first;
-        const double Em = it_m->second->Energy();
+        const DiagramState& m = core_states[mm];
+        const OrbitalInfo& sm = m.info;
+        K2Block block;
 
-        auto it_n = core->begin();
-        while(it_n != core->end())
+        for(const DiagramState& n: core_states)
         {
-            const OrbitalInfo& sn = it_n->first;
-            const double En = it_n->second->Energy();
+            const OrbitalInfo& sn = n.info;
 
             double coeff_mn = 0.;
-            if(InQSpace(sn, sm) &&
-               ((sa.L() + sm.L() + sb.L() + sn.L())%2 == 0) &&
-               ((sm.L() + sc.L() + sd.L() + sn.L())%2 == 0))
-                coeff_mn = double(sm.MaxNumElectrons()) * double(sn.MaxNumElectrons()) * (2. * double(k) + 1.);
+            if((!n.in_valence || !m.in_valence) &&
+               ((sa.L() + m.l + sb.L() + n.l)%2 == 0) &&
+               ((m.l + sc.L() + sd.L() + n.l)%2 == 0))
+                coeff_mn = m.max_electrons * n.max_electrons * (2. * double(k) + 1.);
 
             if(coeff_mn)
             {
                 coeff_mn = coeff_mn/(coeff_ac*coeff_bd);
-                double energy_denominator = Em + En - ValenceEnergy + delta;
+                double energy_denominator = m.energy + n.energy - ValenceEnergy + delta;
 
-                unsigned int phase = (unsigned int)(sa.TwoJ() + sb.TwoJ() + sc.TwoJ() + sd.TwoJ() + sm.TwoJ() + sn.TwoJ())/2;
+                unsigned int phase = (unsigned int)(sa.TwoJ() + sb.TwoJ() + sc.TwoJ() + sd.TwoJ() + m.two_j + n.two_j)/2;
                 if((phase + k + 1)%2)
                     coeff_mn = -coeff_mn;
 
+                // Angular factors and integrals R_k2 (mn, cd) are independent of k1:
+                // gather them once per (m, n) and contract against each k1 below.
+                unsigned int k2min = kmin(sm, sc, sn, sd);
+                k2max = kmax(sm, sc, sn, sd);
+                GatherK2(k2min, k2max, m.two_j, sc.TwoJ(), n.two_j, sd.TwoJ(), block);
+
                 k1 = kmin(sa, sm, sb, sn);
                 k1max = kmax(sa, sm, sb, sn);
 
                 while(k1 <= k1max)
                 {
-                    double coeff_ab = MathConstant::Instance()->Electron3j(sa.TwoJ(), sm.TwoJ(), k1) *
-                                      MathConstant::Instance()->Electron3j(sb.TwoJ(), sn.TwoJ(), k1);
+                    double coeff_ab = Electron3j(sa.TwoJ(), m.two_j, k1) *
+                                      Electron3j(sb.TwoJ(), n.two_j, k1);
 
                     if(coeff_ab)
                     {
                         // R1 = R_k1 (ab, mn)
                         double R1 = two_body->GetTwoElectronIntegral(k1, sa, sb, sm, sn);
 
-                        k2 = kmin(sm, sc, sn, sd);
-                        k2max = kmax(sm, sc, sn, sd);
-
-                        while(k2 <= k2max)
+                        for(k2 = k2min; k2 <= k2max; k2 += kstep)
                         {
-                            double coeff = MathConstant::Instance()->Electron3j(sm.TwoJ(), sc.TwoJ(), k2) *
-                                           MathConstant::Instance()->Electron3j(sn.TwoJ(), sd.TwoJ(), k2);
+                            double coeff = block.coeff[k2];
                             if(coeff)
-                                coeff = coeff * MathConstant::Instance()->Wigner6j(sc.J(), sa.J(), k, k1, k2, sm.J())
-                                              * MathConstant::Instance()->Wigner6j(sd.J(), sb.J(), k, k1, k2, sn.J());
+                                coeff = coeff * sixj_ca[(k1 * num_k + k2) * num_j + JIndex(m.two_j)]
+                                              * sixj_db[(k1 * num_k + k2) * num_j + JIndex(n.two_j)];
 
                             if(coeff)
                             {
@@ -906,17 +1015,19 @@ double CoreMBPTCalculator::CalculateTwoElectron6(unsigned int k, const OrbitalIn
                                     coeff = -coeff;
 
                                 // R2 = R_k2 (mn, cd)
-                                double R2 = two_body->GetTwoElectronIntegral(k2, sm, sn, sc, sd);
+                                if(!block.found[k2])
+                                {   block.R[k2] = two_body->GetTwoElectronIntegral(k2, sm, sn, sc, sd);
+                                    block.found[k2] = true;
+                                }
+                                double R2 = block.R[k2];
 
                                 energy += TermRatio(R1 * R2 * coeff, energy_denominator, sm, sn, sa, sb);
                             }
-                            k2 += kstep;
                         }
                     }
                     k1 += kstep;
                 }
             }
-            it_n++;
         }
     }
 
@@ -940,20 +1051,18 @@ double CoreMBPTCalculator::CalculateTwoElectronSub(unsigned int k, const Orbital
     const double Ed = ValenceEnergies.find(sd.Kappa())->second;
 
     // Hole line is attached to sa or sc
+    const int num_core = core_states.size();
     int nn;
 #ifdef AMBIT_USE_OPENMP
     #pragma omp parallel for private(nn) reduction(+:energy)
 #endif
-    /* Note: this needs to be a for loop since OpenMP doesn't gracefully handle reductions over loops 
-    with non-random-access iterators */
-    for(nn = 0; nn < core->size(); ++nn)
+    for(nn = 0; nn < num_core; ++nn)
     {
-        auto it_n = core->begin();
-        std::advance(it_n, nn);
-        const OrbitalInfo& sn = it_n->first;
-        if(InQSpace(sn))
+        const DiagramState& n = core_states[nn];
+        const OrbitalInfo& sn = n.info;
+        if(!n.in_valence)
         {
-            const double En = it_n->second->Energy();
+            const double En = n.energy;
 
             if(sn.Kappa() == sa.Kappa())
             {
@@ -4,6 +4,8 @@
 #include "MBPTCalculator.h"
 #include "SlaterIntegrals.h"
 #include "OneElectronIntegrals.h"
+#include "Universal/MathConstant.h"
+#include <vector>
 
 namespace Ambit
 {
@@ -124,14 +126,86 @@ protected:
      */
     double CalculateTwoElectronSub(unsigned int k, const OrbitalInfo& sa, const OrbitalInfo& sb, const OrbitalInfo& sc, const OrbitalInfo& sd) const;
 
+protected:
+    /** Orbital data needed by the two-electron diagram sums, flattened into arrays so that
+        the OpenMP loops can index states directly rather than walking OrbitalMaps.
+     */
+    struct DiagramState
+    {
+        DiagramState(const OrbitalInfo& info, double energy, bool in_valence):
+            info(info), energy(energy), two_j(info.TwoJ()), l(info.L()),
+            max_electrons(info.MaxNumElectrons()), in_valence(in_valence)
+        {}
+
+        OrbitalInfo info;
+        double energy;
+        int two_j;
+        int l;
+        double max_electrons;
+        bool in_valence;        //!< InQSpace(a, b) == !(a.in_valence && b.in_valence)
+    };
+
+    /** Build core_states, excited_states and the Electron3j table from the current orbitals. */
+    void SetUpDiagramTables();
+
+    /** Electron3j(two_j1, two_j2, k) from the precomputed table. */
+    inline double Electron3j(int two_j1, int two_j2, int k) const;
+
+    /** Index of a half-integer j (two_j odd) in the angular tables. */
+    inline int JIndex(int two_j) const { return two_j/2; }
+
+    /** Tabulate { j1 j2 k  } for all j3, j4 in the basis and all k1.
+                  { j3 j4 k1 }
+        Index is (JIndex(two_j3) * num_j + JIndex(two_j4)) * num_k + k1.
+     */
+    std::vector<double> TabulateWigner6jJJ(int two_j1, int two_j2, unsigned int k) const;
+
+    /** Tabulate { j1 j2 k  } for all k1, k2 and all j3 in the basis.
+                  { k1 k2 j3 }
+        Index is (k1 * num_k + k2) * num_j + JIndex(two_j3).
+     */
+    std::vector<double> TabulateWigner6jKK(int two_j1, int two_j2, unsigned int k) const;
+
+    /** Inner (k2) block of a box diagram for fixed internal lines: angular factors and
+        integrals R_k2 indexed by k2. Integrals are looked up lazily, at most once per block,
+        and then contracted against every k1 of the outer loop.
+     */
+    struct K2Block
+    {
+        std::vector<double> coeff;
+        std::vector<double> R;
+        std::vector<bool> found;
+    };
+
+    /** Reset block for k2 in [k2min, k2max] with coeff[k2] = Electron3j(j1, j2, k2) * Electron3j(j3, j4, k2). */
+    void GatherK2(unsigned int k2min, unsigned int k2max, int two_j1, int two_j2, int two_j3, int two_j4, K2Block& block) const;
+
 protected:
     pHFIntegrals one_body;
     pSlaterIntegrals two_body;
 
     pOrbitalMapConst core;
     pOrbitalMapConst excited;
+
+    std::vector<DiagramState> core_states;
+    std::vector<DiagramState> excited_states;
+
+    int max_two_j;              //!< Largest two_j of all orbitals
+    int num_j;                  //!< Number of distinct j in angular tables
+    int num_k;                  //!< Number of distinct k in angular tables
+    std::vector<double> electron3j_table;   //!< Index is (JIndex(two_j1) * num_j + JIndex(two_j2)) * num_k + k
 };
 
+inline double CoreMBPTCalculator::Electron3j(int two_j1, int two_j2, int k) const
+{
+    if(two_j1 > max_two_j || two_j2 > max_two_j)
+        return MathConstant::Instance()->Electron3j(two_j1, two_j2, k);
+    if(k < 0 || k >= num_k)
+        return 0.;
+
+    return electron3j_table[(JIndex(two_j1) * num_j + JIndex(two_j2)) * num_k + k];
+}
+
 typedef std::shared_ptr<CoreMBPTCalculator> pCoreMBPTCalculator;
 
 }
@@ -1,6 +1,11 @@
 #include "Include.h"
 #include <boost/filesystem.hpp>
+#include <algorithm>
 #include <chrono>
+#include <tuple>
+#ifdef AMBIT_USE_OPENMP
+#include <omp.h>
+#endif
 #ifdef AMBIT_USE_MPI
 #include <mpi.h>
 #endif
@@ -19,7 +24,8 @@ template <class MapType>
 CoreValenceIntegrals<MapType>::CoreValenceIntegrals(pOrbitalManagerConst orbitals, pHFIntegrals one_body, pSlaterIntegrals bare_integrals, const std::string& write_file):
     SlaterIntegrals<MapType>(orbitals, false), write_file(write_file), core_PT(nullptr),
     include_core(true), include_core_subtraction(true), include_core_extra_box(true),
-    include_valence(false), include_valence_subtraction(false), include_valence_extra_box(false)
+    include_valence(false), include_valence_subtraction(false), include_valence_extra_box(false),
+    checkpoint_log_started(false)
 {
     core_PT.reset(new CoreMBPTCalculator(this->orbitals, one_body, bare_integrals));
     valence_PT.reset(new ValenceMBPTCalculator(this->orbitals, one_body, bare_integrals));
@@ -30,7 +36,8 @@ CoreValenceIntegrals<MapType>::CoreValenceIntegrals(pOrbitalManagerConst orbital
     SlaterIntegrals<MapType>(orbitals, false), write_file(write_file),
     core_PT(core_mbpt_calculator), valence_PT(valence_mbpt_calculator),
     include_core(false), include_core_subtraction(false), include_core_extra_box(false),
-    include_valence(false), include_valence_subtraction(false), include_valence_extra_box(false)
+    include_valence(false), include_valence_subtraction(false), include_valence_extra_box(false),
+    checkpoint_log_started(false)
 {
     if(core_PT)
     {   include_core = true;
@@ -51,205 +58,406 @@ CoreValenceIntegrals<MapType>::~CoreValenceIntegrals()
 template <class MapType>
 unsigned int CoreValenceIntegrals<MapType>::CalculateTwoElectronIntegrals(pOrbitalMapConst orbital_map_1, pOrbitalMapConst orbital_map_2, pOrbitalMapConst orbital_map_3, pOrbitalMapConst orbital_map_4, bool check_size_only)
 {
-    unsigned int i1, i2, i3, i4;
-    int k, kmax;
+    if(check_size_only)
+    {
+        std::vector<IntegralTask> tasks = EnumerateTwoElectronIntegrals(orbital_map_1, orbital_map_2, orbital_map_3, orbital_map_4);
+
+        // Integrals with usual parity are only stored if some diagrams are included
+        bool usual_parity_stored = include_core || include_core_subtraction || include_valence || include_valence_subtraction;
+        unsigned int count = 0;
+        for(const auto& task: tasks)
+            if(usual_parity_stored || !task.usual_parity)
+                count++;
+
+        return count;
+    }
+
+    // Recover integrals completed by an interrupted run so that they are not recalculated
+    ReadCheckpointLogs();
 
-    std::set<KeyType> found_keys;   // For check_size_only or MPI checking
+    std::vector<IntegralTask> tasks = EnumerateTwoElectronIntegrals(orbital_map_1, orbital_map_2, orbital_map_3, orbital_map_4);
 
+    if(include_core || include_core_subtraction || include_core_extra_box)
+        core_PT->UpdateIntegrals();
+    if(include_valence || include_valence_subtraction || include_valence_extra_box)
+        valence_PT->UpdateIntegrals();
+
+    // Longest tasks first, so that the dynamic schedule finishes evenly
+    for(auto& task: tasks)
+        task.cost = EstimateCost(task);
+    std::stable_sort(tasks.begin(), tasks.end(), [](const IntegralTask& first, const IntegralTask& second) { return first.cost > second.cost; });
+
+    // Assign each task to the least loaded processor. All processors share the same batches so that
+    // the file can be written collectively between them.
+    std::vector<bool> my_task(tasks.size(), true);
 #ifdef AMBIT_USE_MPI
-    int count = 0;  // Processor index
+    std::vector<double> load(NumProcessors, 0.);
+    unsigned int num_my_tasks = 0;
+    for(unsigned int i = 0; i < tasks.size(); i++)
+    {
+        int proc = std::min_element(load.begin(), load.end()) - load.begin();
+        load[proc] += tasks[i].cost;
+        my_task[i] = (proc == ProcessorRank);
+        if(my_task[i])
+            num_my_tasks++;
+    }
+
+    new_keys.clear();
+    new_keys.reserve(num_my_tasks);
+    new_values.clear();
+    new_values.reserve(num_my_tasks);
+
+    my_calculations_done = false;
+    root_complete = false;
+#endif
 
-    if(!check_size_only)
+    // Append new integrals to this processor's checkpoint log every few minutes.
+    // Only integrals calculated since the last checkpoint are written, and no other processes are involved.
+    std::vector<KeyType> unlogged_keys;
+    std::vector<double> unlogged_values;
+    std::chrono::steady_clock::time_point mark_time = std::chrono::steady_clock::now();
+    std::chrono::minutes gap(10);   // 10 minutes
+
+#ifdef AMBIT_USE_OPENMP
+    const int batch_size = 64 * omp_get_max_threads() * NumProcessors;
+#else
+    const int batch_size = 64 * NumProcessors;
+#endif
+
+    const int num_tasks = tasks.size();
+    std::vector<double> values(tasks.size(), 0.);
+    int batch_start = 0;
+
+    while(batch_start < num_tasks)
     {
-        int new_keys_per_processor = CalculateTwoElectronIntegrals(orbital_map_1, orbital_map_2, orbital_map_3, orbital_map_4, true);
-        new_keys_per_processor = (new_keys_per_processor + NumProcessors - 1)/NumProcessors;
+        int batch_end = mmin(batch_start + batch_size, num_tasks);
+
+        int i;
+    #ifdef AMBIT_USE_OPENMP
+        #pragma omp parallel for private(i) schedule(dynamic)
+    #endif
+        for(i = batch_start; i < batch_end; i++)
+        {
+            if(my_task[i])
+                values[i] = CalculateIntegral(tasks[i]);
+        }
 
-        new_keys.clear();
-        new_keys.reserve(new_keys_per_processor);
-        new_values.clear();
-        new_values.reserve(new_keys_per_processor);
+        for(i = batch_start; i < batch_end; i++)
+        {
+            if(my_task[i])
+            {
+            #ifdef AMBIT_USE_MPI
+                new_keys.push_back(tasks[i].key);
+                new_values.push_back(values[i]);
+            #else
+                this->TwoElectronIntegrals.insert(std::pair<KeyType, double>(tasks[i].key, values[i]));
+            #endif
+                unlogged_keys.push_back(tasks[i].key);
+                unlogged_values.push_back(values[i]);
+            }
+        }
 
-        for(const auto& pair: this->TwoElectronIntegrals)
-            found_keys.insert(pair.first);
+        batch_start = batch_end;
 
-        my_calculations_done = false;
-        root_complete = false;
+        // Save state if lots of time has passed
+        if(batch_start < num_tasks && std::chrono::steady_clock::now() - mark_time > gap)
+        {   AppendCheckpointLog(unlogged_keys, unlogged_values);
+            unlogged_keys.clear();
+            unlogged_values.clear();
+            mark_time = std::chrono::steady_clock::now();
+        }
     }
+
+#ifdef AMBIT_USE_MPI
+    // Gather to root node, write to file, and read back in
+    my_calculations_done = true;
+    if(ProcessorRank == 0)
+        root_complete = true;
+
+    // Do loop protects processes that finished before root and therefore
+    // may have to write multiple times.
+    do{
+        this->Write(write_file);
+    } while(!root_complete);
+
+    // All integrals are now in write_file
+    RemoveCheckpointLogs();
+
+    this->clear();
+    new_keys.clear();
+    new_values.clear();
+    this->Read(write_file);
+#else
+    this->Write(write_file);
+    RemoveCheckpointLogs();
 #endif
 
-    if(!check_size_only)
+    return this->TwoElectronIntegrals.size();
+}
+
+template <class MapType>
+auto CoreValenceIntegrals<MapType>::EnumerateTwoElectronIntegrals(pOrbitalMapConst orbital_map_1, pOrbitalMapConst orbital_map_2, pOrbitalMapConst orbital_map_3, pOrbitalMapConst orbital_map_4) const -> std::vector<IntegralTask>
+{
+    // MBPT breaks the reverse symmetry R^k(12,34) = R^k(32,14), so the only symmetries are
+    //     R^k(12,34) = R^k(21,43) = R^k(34,12) = R^k(43,21),
+    // which is the same group that GetKey() reduces by. Each integral is generated once only,
+    // from the smallest (i1, i2, i3, i4) among its images that are requested by the orbital maps.
+    std::vector<pOrbitalMapConst> maps = {orbital_map_1, orbital_map_2, orbital_map_3, orbital_map_4};
+    std::vector<std::vector<std::pair<OrbitalInfo, unsigned int>>> states(4);
+    std::vector<std::vector<bool>> in_map(4, std::vector<bool>(this->NumStates, false));
+
+    for(int m = 0; m < 4; m++)
     {
-        if(include_core || include_core_subtraction || include_core_extra_box)
-            core_PT->UpdateIntegrals();
-        if(include_valence || include_valence_subtraction || include_valence_extra_box)
-            valence_PT->UpdateIntegrals();
+        states[m].reserve(maps[m]->size());
+        for(auto& pair: *maps[m])
+        {   unsigned int index = this->orbitals->state_index.at(pair.first);
+            states[m].push_back(std::make_pair(pair.first, index));
+            in_map[m][index] = true;
+        }
     }
 
-    // Save state every hour or so unless nearly_done is true
-    std::chrono::steady_clock::time_point mark_time = std::chrono::steady_clock::now();
-    std::chrono::minutes gap(47);   // 47 minutes
-    bool nearly_done = false;
-
-    auto it_1 = orbital_map_1->begin();
-    while(it_1 != orbital_map_1->end())
+    // Image (j1, j2, j3, j4) is only a duplicate if it is requested and comes before (i1, i2, i3, i4)
+    auto precedes = [&in_map](unsigned int j1, unsigned int j2, unsigned int j3, unsigned int j4, unsigned int i1, unsigned int i2, unsigned int i3, unsigned int i4)
     {
-        if(std::next(it_1) == orbital_map_1->end())
-            nearly_done = true;
+        return in_map[0][j1] && in_map[1][j2] && in_map[2][j3] && in_map[3][j4]
+               && std::make_tuple(j1, j2, j3, j4) < std::make_tuple(i1, i2, i3, i4);
+    };
 
-        i1 = this->orbitals->state_index.at(it_1->first);
-        const auto& s1 = it_1->first;
+    bool extra_box = include_core_extra_box || include_valence_extra_box;
+    int kstep = (extra_box? 1: 2);
+    bool check_stored = !this->TwoElectronIntegrals.empty();
+
+    std::vector<IntegralTask> tasks;
+    int k, kmax;
 
-        auto it_3 = orbital_map_3->begin();
-        while(it_3 != orbital_map_3->end())
+    for(const auto& state_1: states[0])
+    {
+        const OrbitalInfo& s1 = state_1.first;
+        unsigned int i1 = state_1.second;
+
+        for(const auto& state_3: states[2])
         {
-            i3 = this->orbitals->state_index.at(it_3->first);
-            const auto& s3 = it_3->first;
+            const OrbitalInfo& s3 = state_3.first;
+            unsigned int i3 = state_3.second;
 
-            auto it_2 = orbital_map_2->begin();
-            while(it_2 != orbital_map_2->end())
+            for(const auto& state_2: states[1])
             {
-                i2 = this->orbitals->state_index.at(it_2->first);
-                const auto& s2 = it_2->first;
+                const OrbitalInfo& s2 = state_2.first;
+                unsigned int i2 = state_2.second;
 
-                auto it_4 = orbital_map_4->begin();
-                while(it_4 != orbital_map_4->end())
+                for(const auto& state_4: states[3])
                 {
-                    i4 = this->orbitals->state_index.at(it_4->first);
-                    const auto& s4 = it_4->first;
+                    const OrbitalInfo& s4 = state_4.first;
+                    unsigned int i4 = state_4.second;
 
                     // Check parity conservation
-                    if((s1.L() + s2.L() + s3.L() + s4.L())%2 == 0)
+                    if((s1.L() + s2.L() + s3.L() + s4.L())%2 != 0)
+                        continue;
+
+                    // Only the canonical member of each set of equivalent integrals
+                    if(precedes(i2, i1, i4, i3, i1, i2, i3, i4) || precedes(i3, i4, i1, i2, i1, i2, i3, i4)
+                       || precedes(i4, i3, i2, i1, i1, i2, i3, i4))
+                        continue;
+
+                    // Limits on k
+                    k = mmax(abs(s1.L() - s3.L()), abs(s2.L() - s4.L()));
+                    if((abs(s1.TwoJ() - s3.TwoJ()) > 2 * k) || abs(s2.TwoJ() - s4.TwoJ()) > 2 * k)
+                        k += kstep;
+
+                    kmax = mmin(s1.L() + s3.L(), s2.L() + s4.L());
+                    if((s1.TwoJ() + s3.TwoJ() <  2 * kmax) || (s2.TwoJ() + s4.TwoJ() <  2 * kmax))
+                        kmax -= kstep;
+
+                    while(k <= kmax)
                     {
-                        // Limits on k
-                        k = mmax(abs(s1.L() - s3.L()), abs(s2.L() - s4.L()));
-                        if((abs(s1.TwoJ() - s3.TwoJ()) > 2 * k) || abs(s2.TwoJ() - s4.TwoJ()) > 2 * k)
+                        // Usual multipolarity rules
+                        bool usual_parity = ((s2.L() + s4.L() + k)%2 == 0);
+                        if(usual_parity || extra_box)
                         {
-                            if(include_core_extra_box || include_valence_extra_box)
-                                k++;
-                            else
-                                k+=2;
-                        }
+                            KeyType key = this->GetKey(k, i1, i2, i3, i4);
 
-                        kmax = mmin(s1.L() + s3.L(), s2.L() + s4.L());
-                        if((s1.TwoJ() + s3.TwoJ() <  2 * kmax) || (s2.TwoJ() + s4.TwoJ() <  2 * kmax))
-                        {
-                            if(include_core_extra_box || include_valence_extra_box)
-                                kmax--;
-                            else
-                                kmax-=2;
+                            // Check that this integral doesn't already exist
+                            if(!check_stored || (this->TwoElectronIntegrals.find(key) == this->TwoElectronIntegrals.end()))
+                                tasks.push_back({key, k, s1, s2, s3, s4, usual_parity, 0.});
                         }
 
-                        while(k <= kmax)
-                        {
-                            // Usual multipolarity rules
-                            bool usual_parity = ((s2.L() + s4.L() + k)%2 == 0);
-                            if(usual_parity || include_core_extra_box || include_valence_extra_box)
-                            {
-                                KeyType key = this->GetKey(k, i1, i2, i3, i4);
-
-                                if(check_size_only)
-                                {
-                                    if((this->TwoElectronIntegrals.find(key) == this->TwoElectronIntegrals.end()) &&
-                                       (include_core || include_core_subtraction || include_valence || include_valence_subtraction || !usual_parity))
-                                        found_keys.insert(key);
-                                }
-                                else
-                                {   // Check that this integral doesn't already exist
-                                    #ifdef AMBIT_USE_MPI
-                                    if(!found_keys.count(key))
-                                    {
-                                        // Check if this is our job
-                                        if(count == ProcessorRank)
-                                        {
-                                    #else
-                                    if(this->TwoElectronIntegrals.find(key) == this->TwoElectronIntegrals.end())
-                                    {
-                                    #endif
-
-                                        double radial = 0;
-                                        if(usual_parity)
-                                        {   if(include_core)
-                                                radial += core_PT->GetTwoElectronDiagrams(k, s1, s2, s3, s4);
-                                            if(include_core_subtraction)
-                                                radial += core_PT->GetTwoElectronSubtraction(k, s1, s2, s3, s4);
-                                            if(include_valence)
-                                                radial += valence_PT->GetTwoElectronValence(k, s1, s2, s3, s4);
-                                            if(include_valence_subtraction)
-                                                radial += valence_PT->GetTwoElectronSubtraction(k, s1, s2, s3, s4);
-                                        }
-                                        else
-                                        {   if(include_core_extra_box)
-                                                radial += core_PT->GetTwoElectronBoxDiagrams(k, s1, s2, s3, s4);
-                                            if(include_valence_extra_box)
-                                                radial += valence_PT->GetTwoElectronBoxValence(k, s1, s2, s3, s4);
-                                        }
-
-                                    #ifdef AMBIT_USE_MPI
-                                        new_keys.push_back(key);
-                                        new_values.push_back(radial);
-                                        }
-
-                                        found_keys.insert(key);
-                                        count++;
-                                        if(count == NumProcessors)
-                                            count = 0;
-                                    #else
-                                        this->TwoElectronIntegrals.insert(std::pair<KeyType, double>(key, radial));
-                                    #endif
-                                    }
-                                }
-                            }
-
-                            if(include_core_extra_box || include_valence_extra_box)
-                                k++;
-                            else
-                                k+=2;
-                        }
+                        k += kstep;
                     }
+                }
+            }
+        }
+    }
 
-                    // Save state if lots of time has passed
-                    std::chrono::steady_clock::duration t = std::chrono::steady_clock::now() - mark_time;
-                    if(!nearly_done && t > gap)
-                    {   this->Write(write_file);    // Write has an MPI_Barrier, so all processes are at the same time
-                        mark_time = std::chrono::steady_clock::now();
-                    }
+    return tasks;
+}
 
-                    it_4++;
-                }
-                it_2++;
+template <class MapType>
+double CoreValenceIntegrals<MapType>::EstimateCost(const IntegralTask& task) const
+{
+    // Number of (k1, k2) pairs in the box diagrams grows with the j of each external line
+    double angular = double(task.s1.TwoJ() + 1) * double(task.s2.TwoJ() + 1) * double(task.s3.TwoJ() + 1) * double(task.s4.TwoJ() + 1);
+
+    double num_core = this->orbitals->core->size();
+    double num_excited = this->orbitals->excited->size();
+    double cost = 1.;
+
+    if(task.usual_parity)
+    {   if(include_core)
+            cost += num_core * (num_core + num_excited) * angular;
+        if(include_valence)
+            cost += num_excited * num_excited * angular;
+    }
+    else
+    {   if(include_core_extra_box)
+            cost += num_core * (num_core + num_excited) * angular;
+        if(include_valence_extra_box)
+            cost += num_excited * num_excited * angular;
+    }
+
+    return cost;
+}
+
+template <class MapType>
+double CoreValenceIntegrals<MapType>::CalculateIntegral(const IntegralTask& task) const
+{
+    double radial = 0;
+    if(task.usual_parity)
+    {   if(include_core)
+            radial += core_PT->GetTwoElectronDiagrams(task.k, task.s1, task.s2, task.s3, task.s4);
+        if(include_core_subtraction)
+            radial += core_PT->GetTwoElectronSubtraction(task.k, task.s1, task.s2, task.s3, task.s4);
+        if(include_valence)
+            radial += valence_PT->GetTwoElectronValence(task.k, task.s1, task.s2, task.s3, task.s4);
+        if(include_valence_subtraction)
+            radial += valence_PT->GetTwoElectronSubtraction(task.k, task.s1, task.s2, task.s3, task.s4);
+    }
+    else
+    {   if(include_core_extra_box)
+            radial += core_PT->GetTwoElectronBoxDiagrams(task.k, task.s1, task.s2, task.s3, task.s4);
+        if(include_valence_extra_box)
+            radial += valence_PT->GetTwoElectronBoxValence(task.k, task.s1, task.s2, task.s3, task.s4);
+    }
+
+    return radial;
+}
+
+template <class MapType>
+std::string CoreValenceIntegrals<MapType>::GetCheckpointLogFilename(int rank) const
+{
+    return write_file + "." + itoa(rank) + ".log";
+}
+
+template <class MapType>
+void CoreValenceIntegrals<MapType>::ReadCheckpointLogs()
+{
+    checkpoint_log_started = false;
+
+    // Logs are read from all processors of the previous run, which need not match the current number
+    int rank = 0;
+    std::string filename = GetCheckpointLogFilename(rank);
+    while(boost::filesystem::exists(filename))
+    {
+        FILE* fp = file_err_handler->fopen(filename.c_str(), "rb");
+        if(!fp)
+            break;
+
+        OrbitalIndex old_state_index;
+        ReadOrbitalIndexes(old_state_index, fp);
+
+        unsigned int old_key_size;
+        file_err_handler->fread(&old_key_size, sizeof(unsigned int), 1, fp);
+
+        if(old_state_index == this->orbitals->state_index && old_key_size == sizeof(KeyType))
+        {
+            if(rank == ProcessorRank)
+                checkpoint_log_started = true;
+
+            // Each block starts with its number of integrals; a block that was only partially
+            // written when the run was interrupted is discarded.
+            std::vector<KeyType> keys;
+            std::vector<double> values;
+            // Reaching the end of the file is expected here, so use std::fread rather than
+            // file_err_handler, which would warn about it.
+            unsigned int num_integrals;
+            unsigned int num_read = 0;
+            while(std::fread(&num_integrals, sizeof(unsigned int), 1, fp) == 1)
+            {
+                keys.resize(num_integrals);
+                values.resize(num_integrals);
+                if(std::fread(keys.data(), sizeof(KeyType), num_integrals, fp) != num_integrals ||
+                   std::fread(values.data(), sizeof(double), num_integrals, fp) != num_integrals)
+                    break;
+
+                for(unsigned int i = 0; i < num_integrals; i++)
+                    this->TwoElectronIntegrals.insert(std::pair<KeyType, double>(keys[i], values[i]));
+                num_read += num_integrals;
             }
-            it_3++;
+
+            if(ProcessorRank == 0)
+                *logstream << "Recovered " << num_read << " two-body MBPT integrals from " << filename << std::endl;
         }
-        it_1++;
+        else if(ProcessorRank == 0)
+            *errstream << "CoreValenceIntegrals: orbitals in " << filename << " do not match; ignoring checkpoint log." << std::endl;
+
+        file_err_handler->fclose(fp);
+
+        rank++;
+        filename = GetCheckpointLogFilename(rank);
     }
+}
 
-    if(check_size_only)
-        return found_keys.size();
+template <class MapType>
+void CoreValenceIntegrals<MapType>::AppendCheckpointLog(const std::vector<KeyType>& keys, const std::vector<double>& values)
+{
+    std::string filename = GetCheckpointLogFilename(ProcessorRank);
+    FILE* fp;
+
+    if(checkpoint_log_started)
+        fp = file_err_handler->fopen(filename.c_str(), "ab");
     else
-    #ifdef AMBIT_USE_MPI
-    {   // Gather to root node, write to file, and read back in
-        my_calculations_done = true;
-        if(ProcessorRank == 0)
-            root_complete = true;
-
-        // Do loop protects processes that finished before root and therefore
-        // may have to write multiple times.
-        do{
-            this->Write(write_file);
-        } while(!root_complete);
-
-        this->clear();
-        new_keys.clear();
-        new_values.clear();
-        this->Read(write_file);
-
-        return this->TwoElectronIntegrals.size();
+    {   fp = file_err_handler->fopen(filename.c_str(), "wb");
+        if(!fp)
+            return;
+
+        WriteOrbitalIndexes(this->orbitals->state_index, fp);
+
+        unsigned int KeyType_size = sizeof(KeyType);
+        file_err_handler->fwrite(&KeyType_size, sizeof(unsigned int), 1, fp);
+        checkpoint_log_started = true;
     }
-    #else
-    {   this->Write(write_file);
-        return this->TwoElectronIntegrals.size();
+
+    if(!fp)
+        return;
+
+    unsigned int num_integrals = keys.size();
+    file_err_handler->fwrite(&num_integrals, sizeof(unsigned int), 1, fp);
+    file_err_handler->fwrite(keys.data(), sizeof(KeyType), num_integrals, fp);
+    file_err_handler->fwrite(values.data(), sizeof(double), num_integrals, fp);
+
+    file_err_handler->fclose(fp);
+}
+
+template <class MapType>
+void CoreValenceIntegrals<MapType>::RemoveCheckpointLogs()
+{
+    // Each processor removes its own log, so no other processor can still be appending to it
+    std::string filename = GetCheckpointLogFilename(ProcessorRank);
+    if(boost::filesystem::exists(filename))
+        boost::filesystem::remove(filename);
+    checkpoint_log_started = false;
+
+    // Root also removes logs left by processors of a previous run that are not in this one
+    if(ProcessorRank == 0)
+    {
+        int rank = NumProcessors;
+        filename = GetCheckpointLogFilename(rank);
+        while(boost::filesystem::exists(filename))
+        {
+            boost::filesystem::remove(filename);
+            rank++;
+            filename = GetCheckpointLogFilename(rank);
+        }
     }
-    #endif
 }
 
 #ifdef AMBIT_USE_MPI
@@ -33,6 +33,10 @@ public:
     virtual bool OffParityExists() const override { return include_core_extra_box || include_valence_extra_box; }
 
     /** Calculate two-electron requested MBPT. Write to file.
+        All unique integrals are enumerated first and handed out longest first: over MPI ranks by
+        cost-balanced assignment and over OpenMP threads by dynamic scheduling. The integrals are
+        computed in batches. Between batches each processor appends its new integrals to its own
+        checkpoint log; an interrupted calculation recovers these logs when it is restarted.
         PRE: OrbitalMaps should only include a subset of valence orbitals.
      */
     virtual unsigned int CalculateTwoElectronIntegrals(pOrbitalMapConst orbital_map_1, pOrbitalMapConst orbital_map_2, pOrbitalMapConst orbital_map_3, pOrbitalMapConst orbital_map_4, bool check_size_only = false) override;
@@ -45,6 +49,44 @@ public:
     void IncludeCore(bool include_mbpt, bool include_subtraction, bool include_wrong_parity_box_diagrams);
     void IncludeValence(bool include_mbpt, bool include_subtraction, bool include_wrong_parity_box_diagrams);
 
+protected:
+    /** A single two-body integral R^k(12,34) to be calculated, with an estimate of its relative cost. */
+    struct IntegralTask
+    {
+        KeyType key;
+        int k;
+        OrbitalInfo s1, s2, s3, s4;
+        bool usual_parity;
+        double cost;
+    };
+
+    /** Enumerate all unique integrals that are requested by the orbital maps but not yet stored. */
+    std::vector<IntegralTask> EnumerateTwoElectronIntegrals(pOrbitalMapConst orbital_map_1, pOrbitalMapConst orbital_map_2, pOrbitalMapConst orbital_map_3, pOrbitalMapConst orbital_map_4) const;
+
+    /** Heuristic cost of calculating an integral: the number of internal orbital pairs summed over
+        by the included diagrams times the number of (k1, k2) multipolarities allowed by the external lines.
+     */
+    double EstimateCost(const IntegralTask& task) const;
+
+    /** Sum all included MBPT diagrams for a single integral. */
+    double CalculateIntegral(const IntegralTask& task) const;
+
+    /** Checkpoint log of integrals calculated by processor rank: write_file.<rank>.log */
+    std::string GetCheckpointLogFilename(int rank) const;
+
+    /** Add integrals from all checkpoint logs (from any number of processors) that were written
+        with the same orbitals.
+     */
+    void ReadCheckpointLogs();
+
+    /** Append a block of newly calculated integrals to this processor's checkpoint log. */
+    void AppendCheckpointLog(const std::vector<KeyType>& keys, const std::vector<double>& values);
+
+    /** Remove this processor's checkpoint log once the integrals are safely in write_file.
+        Root also removes logs left by extra processors of a previous run.
+     */
+    void RemoveCheckpointLogs();
+
 protected:
     pCoreMBPTCalculator core_PT;
     pValenceMBPTCalculator valence_PT;
@@ -60,6 +102,7 @@ protected:
     bool include_valence_extra_box;
 
     std::string write_file;
+    bool checkpoint_log_started;
 #ifdef AMBIT_USE_MPI
     bool my_calculations_done;
     mutable bool root_complete;
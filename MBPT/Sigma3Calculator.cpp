@@ -1,12 +1,14 @@
 #include "Sigma3Calculator.h"
 #include "Include.h"
 #include "Universal/PhysicalConstant.h"
+#include <algorithm>
+#include <array>
 
 namespace Ambit
 {
 Sigma3Calculator::Sigma3Calculator(pOrbitalManagerConst orbitals, pSlaterIntegrals two_body, const std::string& fermi_orbitals):
     MBPTCalculator(orbitals, fermi_orbitals, two_body->OffParityExists()), two_body(two_body), include_valence(false),
-    include_core(true), deep(orbitals->deep), high(orbitals->high)
+    include_core(true), deep(orbitals->deep), high(orbitals->high), num_reduced_J(0)
 {}
 
 Sigma3Calculator::~Sigma3Calculator(void)
@@ -37,6 +39,7 @@ unsigned int Sigma3Calculator::GetStorageSize()
 
 void Sigma3Calculator::UpdateIntegrals()
 {
+    ClearReducedTable();
     SetValenceEnergies();
 
     if(include_core)
@@ -70,6 +73,19 @@ double Sigma3Calculator::GetMatrixElement(const ElectronInfo& e1, const Electron
 double Sigma3Calculator::GetSecondOrderSigma3(const ElectronInfo& e1, const ElectronInfo& e2, const ElectronInfo& e3,
            const ElectronInfo& e4, const ElectronInfo& e5, const ElectronInfo& e6) const
 {
+    // Use reduced table if possible
+    long long int reduced_key = GetReducedKey(e1, e2, e3, e4, e5, e6);
+    if(reduced_key >= 0)
+    {
+        long long int mirrored_key = GetMirroredReducedKey(e1, e2, e3, e4, e5, e6);
+        bool mirrored = (mirrored_key >= 0 && mirrored_key < reduced_key);
+
+        auto it = reduced_table.find(mirrored? mirrored_key: reduced_key);
+        if(it == reduced_table.end())
+            return 0.;
+        return GetSecondOrderSigma3(e1, e2, e3, e4, e5, e6, it->second, mirrored);
+    }
+
     // core state limits
     int two_mn = e1.TwoM() + e2.TwoM() - e4.TwoM();
 
@@ -196,4 +212,438 @@ double Sigma3Calculator::GetSecondOrderSigma3(const ElectronInfo& e1, const Elec
 
     return total;
 }
+
+double Sigma3Calculator::GetSecondOrderSigma3(const ElectronInfo& e1, const ElectronInfo& e2, const ElectronInfo& e3,
+           const ElectronInfo& e4, const ElectronInfo& e5, const ElectronInfo& e6, const std::vector<double>& reduced, bool mirrored) const
+{
+    // core state limits
+    int two_mn = e1.TwoM() + e2.TwoM() - e4.TwoM();
+
+    // k1 limits: reduced table starts at kmin(e1, e4)
+    int q1 = (e1.TwoM() - e4.TwoM())/2;
+    int k1_start = kmin(e1, e4);
+    int k1min = k1_start;
+    while(k1min < abs(q1))
+        k1min += kstep;
+    int k1max = kmax(e1, e4);
+
+    // k2 limits
+    int q2 = (e6.TwoM() - e3.TwoM())/2;
+    int k2_start = kmin(e3, e6);
+    int k2min = k2_start;
+    while(k2min < abs(q2))
+        k2min += kstep;
+    int k2max = kmax(e3, e6);
+
+    if((k1min > k1max) || (k2min > k2max))
+        return 0.;
+
+    int nk1 = (k1max - k1_start)/kstep + 1;
+    int nk2 = (k2max - k2_start)/kstep + 1;
+    int max_two_Jn = 2 * num_reduced_J - 1;
+
+    double total = 0.;
+    int k1, k2;
+    MathConstant* constants = MathConstant::Instance();
+
+    for(k1 = k1min; k1 <= k1max; k1 += kstep)
+    {
+        double coeff14 = constants->Electron3j(e1.TwoJ(), e4.TwoJ(), k1, -e1.TwoM(), e4.TwoM());
+        if(!coeff14)
+            continue;
+
+        for(k2 = k2min; k2 <= k2max; k2 += kstep)
+        {
+            double coeff36 = constants->Electron3j(e3.TwoJ(), e6.TwoJ(), k2, -e3.TwoM(), e6.TwoM());
+            if(!coeff36)
+                continue;
+
+            for(int two_Jn = abs(two_mn); two_Jn <= max_two_Jn; two_Jn += 2)
+            {
+                // Mirrored entry was calculated with k1 and k2 exchanged
+                unsigned int index;
+                if(mirrored)
+                    index = GetReducedIndex(k2 - k2_start, k1 - k1_start, nk1, two_Jn);
+                else
+                    index = GetReducedIndex(k1 - k1_start, k2 - k2_start, nk2, two_Jn);
+
+                double value = reduced[index];
+                if(value)
+                {
+                    double coeff = constants->Electron3j(e2.TwoJ(), two_Jn, k1, -e2.TwoM(), two_mn) *
+                                   constants->Electron3j(two_Jn, e5.TwoJ(), k2, -two_mn, e5.TwoM());
+
+                    total += coeff * coeff14 * coeff36 * value;
+                }
+            }
+        }
+    }
+
+    // phase = (-1)^(m2 + m3 + m4 + m5) = (-1)^(m1 - m6)
+    if((abs(e1.TwoM() - e6.TwoM())/2)%2)
+        total = - total;
+
+    return total;
+}
+
+std::vector<double> Sigma3Calculator::CalculateReducedSigma3(const OrbitalInfo& e1, const OrbitalInfo& e2, const OrbitalInfo& e3,
+           const OrbitalInfo& e4, const OrbitalInfo& e5, const OrbitalInfo& e6) const
+{
+    std::vector<double> reduced;
+
+    int k1min = kmin(e1, e4);
+    int k1max = kmax(e1, e4);
+    int k2min = kmin(e3, e6);
+    int k2max = kmax(e3, e6);
+
+    if((k1min > k1max) || (k2min > k2max))
+        return reduced;
+
+    int nk1 = (k1max - k1min)/kstep + 1;
+    int nk2 = (k2max - k2min)/kstep + 1;
+    reduced.resize(nk1 * nk2 * num_reduced_J, 0.);
+
+    const double ValenceEnergy = ValenceEnergies.find(e2.Kappa())->second;
+    const double degeneracy = sqrt(e1.MaxNumElectrons() * e2.MaxNumElectrons() * e3.MaxNumElectrons() *
+                                   e4.MaxNumElectrons() * e5.MaxNumElectrons() * e6.MaxNumElectrons());
+
+    int k1, k2;
+    MathConstant* constants = MathConstant::Instance();
+
+    for(k1 = k1min; k1 <= k1max; k1 += kstep)
+    {
+        double coeff14 = constants->Electron3j(e1.TwoJ(), e4.TwoJ(), k1);
+        if(!coeff14)
+            continue;
+
+        for(k2 = k2min; k2 <= k2max; k2 += kstep)
+        {
+            double coeff36 = constants->Electron3j(e3.TwoJ(), e6.TwoJ(), k2);
+            if(!coeff36)
+                continue;
+
+            if(include_core)
+            {
+                // Summation over core state 'n'
+                for(const auto& pair: *deep)
+                {
+                    const OrbitalInfo& sn = pair.first;
+                    int two_Jn = sn.TwoJ();
+
+                    if(ParityCheck(e2, sn, k1))
+                    {
+                        double coeff = constants->Electron3j(e2.TwoJ(), two_Jn, k1) *
+                                       constants->Electron3j(two_Jn, e5.TwoJ(), k2);
+
+                        if(coeff)
+                        {
+                            coeff *= coeff14 * coeff36 * degeneracy * double(two_Jn + 1);
+                            double energy_denominator = pair.second->Energy() - ValenceEnergy + delta;
+
+                            double R1 = two_body->GetTwoElectronIntegral(k1, sn, e4, e2, e1);
+                            double R2 = two_body->GetTwoElectronIntegral(k2, sn, e3, e5, e6);
+
+                            reduced[GetReducedIndex(k1 - k1min, k2 - k2min, nk2, two_Jn)]
+                                -= TermRatio(coeff * R1 * R2, energy_denominator, sn, e2);
+                        }
+                    }
+                }
+            }
+
+            if(include_valence)
+            {
+                // Summation over excited state 'alpha'
+                for(const auto& pair: *high)
+                {
+                    const OrbitalInfo& salpha = pair.first;
+                    int two_Jalpha = salpha.TwoJ();
+
+                    if(ParityCheck(salpha, e2, k1))
+                    {
+                        double coeff = constants->Electron3j(e2.TwoJ(), two_Jalpha, k1) *
+                                       constants->Electron3j(two_Jalpha, e5.TwoJ(), k2);
+
+                        if(coeff)
+                        {
+                            coeff *= coeff14 * coeff36 * degeneracy * double(two_Jalpha + 1);
+                            double energy_denominator = ValenceEnergy - pair.second->Energy() + delta;
+
+                            double R1 = two_body->GetTwoElectronIntegral(k1, e1, e2, e4, salpha);
+                            double R2 = two_body->GetTwoElectronIntegral(k2, e3, salpha, e6, e5);
+
+                            reduced[GetReducedIndex(k1 - k1min, k2 - k2min, nk2, two_Jalpha)]
+                                += TermRatio(coeff * R1 * R2, energy_denominator, e2, salpha);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return reduced;
+}
+
+long long int Sigma3Calculator::GetReducedKey(const OrbitalInfo& e1, const OrbitalInfo& e2, const OrbitalInfo& e3,
+           const OrbitalInfo& e4, const OrbitalInfo& e5, const OrbitalInfo& e6) const
+{
+    if(reduced_index.empty())
+        return -1;
+
+    long long int num_orbitals = reduced_index.size();
+    long long int key = 0;
+
+    for(const OrbitalInfo* e: {&e1, &e2, &e3, &e4, &e5, &e6})
+    {
+        auto it = reduced_index.find(OrbitalInfo(e->PQN(), e->Kappa()));
+        if(it == reduced_index.end())
+            return -1;
+        key = key * num_orbitals + it->second;
+    }
+
+    return key;
+}
+
+long long int Sigma3Calculator::GetMirroredReducedKey(const OrbitalInfo& e1, const OrbitalInfo& e2, const OrbitalInfo& e3,
+           const OrbitalInfo& e4, const OrbitalInfo& e5, const OrbitalInfo& e6) const
+{
+    // Exchanging (e1, e4) <-> (e3, e6) and e2 <-> e5 swaps the two radial integrals in both the core
+    // and valence diagrams; only the energy denominator changes, through the valence energy of e2.
+    if(e2.Kappa() != e5.Kappa())
+        return -1;
+
+    return GetReducedKey(e3, e5, e1, e6, e2, e4);
+}
+
+unsigned int Sigma3Calculator::CalculateReducedTable(pOrbitalMapConst table_orbitals)
+{
+    ClearReducedTable();
+
+    std::vector<OrbitalInfo> infos;
+    for(const auto& pair: *table_orbitals)
+    {
+        reduced_index[pair.first] = infos.size();
+        infos.push_back(pair.first);
+    }
+
+    // Largest J_n of internal lines
+    int max_two_Jn = 1;
+    if(include_core)
+        for(const auto& pair: *deep)
+            max_two_Jn = mmax(max_two_Jn, pair.first.TwoJ());
+    if(include_valence)
+        for(const auto& pair: *high)
+            max_two_Jn = mmax(max_two_Jn, pair.first.TwoJ());
+    num_reduced_J = (max_two_Jn + 1)/2;
+
+    // Sets of six orbitals are keyed by their indexes in infos (see GetReducedKey())
+    long long int num_orbitals = infos.size();
+    long long int num_keys = num_orbitals * num_orbitals * num_orbitals * num_orbitals * num_orbitals * num_orbitals;
+
+    auto expand_key = [&](long long int key, std::array<const OrbitalInfo*, 6>& e)
+    {
+        for(int i = 5; i >= 0; i--)
+        {   e[i] = &infos[key % num_orbitals];
+            key /= num_orbitals;
+        }
+    };
+
+    // Keep only keys that can be non-zero (parity and triangle conditions for k1 and k2),
+    // and only one of each mirrored pair.
+    std::vector<long long int> keys;
+    std::array<const OrbitalInfo*, 6> e;
+    for(long long int key = 0; key < num_keys; key++)
+    {
+        expand_key(key, e);
+        if((e[0]->L() + e[1]->L() + e[2]->L() + e[3]->L() + e[4]->L() + e[5]->L())%2
+           || (kmin(*e[0], *e[3]) > kmax(*e[0], *e[3])) || (kmin(*e[2], *e[5]) > kmax(*e[2], *e[5])))
+            continue;
+
+        long long int mirrored_key = GetMirroredReducedKey(*e[0], *e[1], *e[2], *e[3], *e[4], *e[5]);
+        if(mirrored_key < 0 || key <= mirrored_key)
+            keys.push_back(key);
+    }
+
+    unsigned int i;
+#ifdef AMBIT_USE_OPENMP
+    #pragma omp parallel for private(i, e) schedule(dynamic)
+#endif
+    for(i = 0; i < keys.size(); i++)
+    {
+        expand_key(keys[i], e);
+        std::vector<double> values = CalculateReducedSigma3(*e[0], *e[1], *e[2], *e[3], *e[4], *e[5]);
+
+        // Only keep non-zero entries
+        auto nonzero = std::find_if(values.begin(), values.end(), [](double x){ return x != 0.; });
+        if(nonzero != values.end())
+        {
+#ifdef AMBIT_USE_OPENMP
+            #pragma omp critical(SIGMA3_REDUCED_TABLE)
+#endif
+            reduced_table[keys[i]].swap(values);
+        }
+    }
+
+    return GetReducedTableSize();
+}
+
+unsigned int Sigma3Calculator::GetReducedTableSize() const
+{
+    unsigned int total = 0;
+    for(const auto& pair: reduced_table)
+        total += pair.second.size();
+
+    return total;
+}
+
+bool Sigma3Calculator::HasReducedTable(pOrbitalMapConst table_orbitals) const
+{
+    if(reduced_index.empty() || reduced_index.size() != table_orbitals->size())
+        return false;
+
+    for(const auto& pair: *table_orbitals)
+    {
+        if(reduced_index.find(pair.first) == reduced_index.end())
+            return false;
+    }
+
+    return true;
+}
+
+void Sigma3Calculator::ClearReducedTable()
+{
+    reduced_index.clear();
+    reduced_table.clear();
+    num_reduced_J = 0;
+}
+
+std::vector<double> Sigma3Calculator::GetBasisSignature() const
+{
+    std::vector<double> signature;
+
+    if(include_core)
+        for(const auto& pair: *deep)
+            signature.push_back(pair.second->Energy());
+    if(include_valence)
+        for(const auto& pair: *high)
+            signature.push_back(pair.second->Energy());
+
+    for(const auto& pair: ValenceEnergies)
+        signature.push_back(pair.second);
+
+    signature.push_back(delta);
+    return signature;
+}
+
+void Sigma3Calculator::Read(const std::string& filename, pOrbitalMapConst table_orbitals)
+{
+    ClearReducedTable();
+
+    FILE* fp = file_err_handler->fopen(filename.c_str(), "rb");
+    if(!fp)
+        return;
+
+    OrbitalIndex old_index, old_state_index;
+    ReadOrbitalIndexes(old_index, fp);
+    ReadOrbitalIndexes(old_state_index, fp);
+
+    int old_include_core, old_include_valence, old_kstep;
+    unsigned int old_num_reduced_J;
+    file_err_handler->fread(&old_include_core, sizeof(int), 1, fp);
+    file_err_handler->fread(&old_include_valence, sizeof(int), 1, fp);
+    file_err_handler->fread(&old_kstep, sizeof(int), 1, fp);
+    file_err_handler->fread(&old_num_reduced_J, sizeof(unsigned int), 1, fp);
+
+    unsigned int signature_size;
+    file_err_handler->fread(&signature_size, sizeof(unsigned int), 1, fp);
+    std::vector<double> old_signature(signature_size);
+    file_err_handler->fread(old_signature.data(), sizeof(double), signature_size, fp);
+
+    if(old_include_core != include_core || old_include_valence != include_valence || old_kstep != kstep)
+    {
+        *logstream << "Sigma3Calculator::Read(): " << filename << " was made with different options; ignoring." << std::endl;
+        file_err_handler->fclose(fp);
+        return;
+    }
+
+    // Table orbitals must match exactly (as in HasReducedTable())
+    bool same_orbitals = (old_index.size() == table_orbitals->size());
+    for(const auto& pair: *table_orbitals)
+        same_orbitals = same_orbitals && old_index.count(pair.first);
+
+    if(!same_orbitals)
+    {
+        *logstream << "Sigma3Calculator::Read(): " << filename << " was made for different orbitals; ignoring." << std::endl;
+        file_err_handler->fclose(fp);
+        return;
+    }
+
+    // Basis must match: same orbitals in the same order, and same energies of internal and valence lines
+    std::vector<double> signature = GetBasisSignature();
+    bool same_basis = (old_state_index == orbitals->state_index) && (old_signature.size() == signature.size());
+    for(unsigned int i = 0; same_basis && i < signature.size(); i++)
+        same_basis = (fabs(old_signature[i] - signature[i]) <= 1.e-10 * mmax(1., fabs(signature[i])));
+
+    if(!same_basis)
+    {
+        *logstream << "Sigma3Calculator::Read(): " << filename << " was made with a different basis; ignoring." << std::endl;
+        file_err_handler->fclose(fp);
+        return;
+    }
+
+    reduced_index = old_index;
+    num_reduced_J = old_num_reduced_J;
+
+    unsigned int num_entries;
+    file_err_handler->fread(&num_entries, sizeof(unsigned int), 1, fp);
+
+    for(unsigned int i = 0; i < num_entries; i++)
+    {
+        long long int key;
+        unsigned int size;
+        file_err_handler->fread(&key, sizeof(long long int), 1, fp);
+        file_err_handler->fread(&size, sizeof(unsigned int), 1, fp);
+
+        std::vector<double>& values = reduced_table[key];
+        values.resize(size);
+        file_err_handler->fread(values.data(), sizeof(double), size, fp);
+    }
+
+    file_err_handler->fclose(fp);
+}
+
+void Sigma3Calculator::Write(const std::string& filename) const
+{
+    if(ProcessorRank == 0)
+    {
+        FILE* fp = file_err_handler->fopen(filename.c_str(), "wb");
+
+        WriteOrbitalIndexes(reduced_index, fp);
+        WriteOrbitalIndexes(orbitals->state_index, fp);
+
+        int temp = include_core;
+        file_err_handler->fwrite(&temp, sizeof(int), 1, fp);
+        temp = include_valence;
+        file_err_handler->fwrite(&temp, sizeof(int), 1, fp);
+        file_err_handler->fwrite(&kstep, sizeof(int), 1, fp);
+        file_err_handler->fwrite(&num_reduced_J, sizeof(unsigned int), 1, fp);
+
+        std::vector<double> signature = GetBasisSignature();
+        unsigned int signature_size = signature.size();
+        file_err_handler->fwrite(&signature_size, sizeof(unsigned int), 1, fp);
+        file_err_handler->fwrite(signature.data(), sizeof(double), signature_size, fp);
+
+        unsigned int num_entries = reduced_table.size();
+        file_err_handler->fwrite(&num_entries, sizeof(unsigned int), 1, fp);
+
+        for(const auto& pair: reduced_table)
+        {
+            unsigned int size = pair.second.size();
+            file_err_handler->fwrite(&pair.first, sizeof(long long int), 1, fp);
+            file_err_handler->fwrite(&size, sizeof(unsigned int), 1, fp);
+            file_err_handler->fwrite(pair.second.data(), sizeof(double), size, fp);
+        }
+
+        file_err_handler->fclose(fp);
+    }
+}
 }
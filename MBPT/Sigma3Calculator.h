@@ -4,6 +4,7 @@
 #include "MBPTCalculator.h"
 #include "SlaterIntegrals.h"
 #include "Configuration/ElectronInfo.h"
+#include <unordered_map>
 
 namespace Ambit
 {
@@ -18,6 +19,11 @@ namespace Ambit
     Sigma3Calculator is different to other MBPT calculators since these diagrams are calculated on the fly,
     rather than being pre-calculated and stored.
     Sigma3Calculator has the GetMatrixElement() method that can be used directly in ManyBodyOperator.
+
+    Optionally, the reduced (M-independent) part of the diagrams can be tabulated for a small set of
+    orbitals (typically those in the leading configurations) using CalculateReducedTable().
+    The table stores, for each set of six orbitals, the sum over internal lines for each (k1, k2, J_n),
+    so that matrix elements involving only these orbitals reduce to a short sum over 3j-symbols.
  */
 class Sigma3Calculator : public MBPTCalculator
 {
@@ -48,6 +54,26 @@ public:
     double GetMatrixElement(const ElectronInfo& e1, const ElectronInfo& e2, const ElectronInfo& e3,
                             const ElectronInfo& e4, const ElectronInfo& e5, const ElectronInfo& e6) const;
 
+    /** Tabulate reduced diagrams for all combinations of six orbitals from table_orbitals.
+        Replaces any existing table. Integrals must already be calculated (UpdateIntegrals()).
+        Return number of values stored.
+     */
+    unsigned int CalculateReducedTable(pOrbitalMapConst table_orbitals);
+
+    /** Number of values stored in the reduced table. */
+    unsigned int GetReducedTableSize() const;
+
+    /** Return true if a reduced table exists for exactly the orbitals in table_orbitals. */
+    bool HasReducedTable(pOrbitalMapConst table_orbitals) const;
+
+    void ClearReducedTable();
+
+    /** Read reduced table for table_orbitals. Table is discarded if it was made with different
+        options, for a different set of table orbitals, or with a different basis.
+     */
+    void Read(const std::string& filename, pOrbitalMapConst table_orbitals);
+    void Write(const std::string& filename) const;
+
 protected:
     /** Get the single diagram above (not the line permutations).
         Assumes momentum projections are okay:
@@ -58,12 +84,51 @@ protected:
     double GetSecondOrderSigma3(const ElectronInfo& e1, const ElectronInfo& e2, const ElectronInfo& e3,
                                 const ElectronInfo& e4, const ElectronInfo& e5, const ElectronInfo& e6) const;
 
+    /** Get the single diagram using reduced values from the table.
+        If mirrored, reduced is the entry of the mirrored key (see GetMirroredReducedKey()).
+     */
+    double GetSecondOrderSigma3(const ElectronInfo& e1, const ElectronInfo& e2, const ElectronInfo& e3,
+                                const ElectronInfo& e4, const ElectronInfo& e5, const ElectronInfo& e6,
+                                const std::vector<double>& reduced, bool mirrored) const;
+
+    /** Calculate reduced diagram for all (k1, k2, J_n), stored in order given by GetReducedIndex().
+        The non-perturbative check of TermRatio() is applied to the reduced numerator.
+     */
+    std::vector<double> CalculateReducedSigma3(const OrbitalInfo& e1, const OrbitalInfo& e2, const OrbitalInfo& e3,
+                                               const OrbitalInfo& e4, const OrbitalInfo& e5, const OrbitalInfo& e6) const;
+
+    /** Index of (k1, k2, 2J_n) in a reduced table entry. k1 and k2 are offset from kmin(e1, e4) and kmin(e3, e6). */
+    inline unsigned int GetReducedIndex(int k1_offset, int k2_offset, int nk2, int two_Jn) const
+    {   return ((k1_offset/kstep) * nk2 + k2_offset/kstep) * num_reduced_J + (two_Jn - 1)/2;
+    }
+
+    /** Key of six orbitals in reduced table, or -1 if any orbital is not in the table. */
+    long long int GetReducedKey(const OrbitalInfo& e1, const OrbitalInfo& e2, const OrbitalInfo& e3,
+                                const OrbitalInfo& e4, const OrbitalInfo& e5, const OrbitalInfo& e6) const;
+
+    /** Key of the mirrored diagram (e3, e5, e1, e6, e2, e4), which has the same reduced values with
+        k1 and k2 exchanged if e2 and e5 have the same valence energy. Only the smaller of the two keys
+        is stored in the reduced table.
+        Returns -1 if there is no such symmetry or any orbital is not in the table.
+     */
+    long long int GetMirroredReducedKey(const OrbitalInfo& e1, const OrbitalInfo& e2, const OrbitalInfo& e3,
+                                        const OrbitalInfo& e4, const OrbitalInfo& e5, const OrbitalInfo& e6) const;
+
+    /** Energies of the internal lines and valence energies used by the diagrams, together with delta.
+        Stored with the reduced table to identify the basis it was made with.
+     */
+    std::vector<double> GetBasisSignature() const;
+
     bool include_core;
     bool include_valence;
     pSlaterIntegrals two_body;
 
     pOrbitalMapConst deep;
     pOrbitalMapConst high;
+
+    OrbitalIndex reduced_index;     //!< Orbitals included in reduced table
+    unsigned int num_reduced_J;     //!< Number of J_n values stored per (k1, k2)
+    std::unordered_map<long long int, std::vector<double>> reduced_table;
 };
 
 typedef std::shared_ptr<Sigma3Calculator> pSigma3Calculator;
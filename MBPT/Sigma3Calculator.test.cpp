@@ -0,0 +1,110 @@
+#include "Sigma3Calculator.h"
+#include "gtest/gtest.h"
+#include "Include.h"
+#include "Atom/MultirunOptions.h"
+#include "HartreeFock/Core.h"
+#include "Basis/BasisGenerator.h"
+#include <array>
+#include <cstdio>
+
+using namespace Ambit;
+
+TEST(Sigma3CalculatorTester, ReducedTable)
+{
+    pLattice lattice(new Lattice(1000, 1.e-6, 50.));
+
+    // MgII
+    std::string user_input_string = std::string() +
+        "NuclearRadius = 3.7188\n" +
+        "NuclearThickness = 2.3\n" +
+        "Z = 12\n" +
+        "[HF]\n" +
+        "N = 10\n" +
+        "Configuration = '1s2 2s2 2p6'\n" +
+        "[Basis]\n" +
+        "--bspline-basis\n" +
+        "ValenceBasis = 4spd\n" +
+        "BSpline/Rmax = 45.0\n";
+
+    std::stringstream user_input_stream(user_input_string);
+    MultirunOptions userInput(user_input_stream, "//", "\n", ",");
+
+    BasisGenerator basis_generator(lattice, userInput);
+    pCore core = basis_generator.GenerateHFCore();
+    lattice->resize(core->LargestOrbitalSize());
+    pOrbitalManagerConst orbitals = basis_generator.GenerateBasis();
+    pHartreeY hartreeY = basis_generator.GetHartreeY();
+
+    pSlaterIntegrals two_body_integrals(new SlaterIntegralsMap(orbitals, hartreeY));
+    Sigma3Calculator sigma3(orbitals, two_body_integrals);
+    sigma3.UpdateIntegrals();
+
+    // Table orbitals: 3s, 3p
+    pOrbitalMap table_orbitals = std::make_shared<OrbitalMap>(lattice);
+    for(const OrbitalInfo& info: {OrbitalInfo(3, -1), OrbitalInfo(3, 1), OrbitalInfo(3, -2)})
+        table_orbitals->AddState(orbitals->valence->GetState(info));
+
+    // All (e1 e2 e3 | e4 e5 e6) with e_i in {3s, 3p1/2, 3p3/2} x (M) and fixed orbitals
+    std::vector<OrbitalInfo> infos = {OrbitalInfo(3, -1), OrbitalInfo(3, 1), OrbitalInfo(3, -2),
+                                      OrbitalInfo(3, -1), OrbitalInfo(3, 1), OrbitalInfo(3, -2)};
+    std::vector<std::array<ElectronInfo, 6>> electrons;
+    for(int m1 = -infos[0].TwoJ(); m1 <= infos[0].TwoJ(); m1 += 2)
+    for(int m2 = -infos[1].TwoJ(); m2 <= infos[1].TwoJ(); m2 += 2)
+    for(int m3 = -infos[2].TwoJ(); m3 <= infos[2].TwoJ(); m3 += 2)
+    for(int m4 = -infos[3].TwoJ(); m4 <= infos[3].TwoJ(); m4 += 2)
+    for(int m5 = -infos[4].TwoJ(); m5 <= infos[4].TwoJ(); m5 += 2)
+    {
+        int m6 = m1 + m2 + m3 - m4 - m5;
+        if(abs(m6) <= infos[5].TwoJ())
+            electrons.push_back({ElectronInfo(3, -1, m1), ElectronInfo(3, 1, m2), ElectronInfo(3, -2, m3),
+                                 ElectronInfo(3, -1, m4), ElectronInfo(3, 1, m5), ElectronInfo(3, -2, m6)});
+    }
+
+    // Calculate on the fly
+    std::vector<double> direct;
+    for(const auto& e: electrons)
+        direct.push_back(sigma3.GetMatrixElement(e[0], e[1], e[2], e[3], e[4], e[5]));
+
+    double largest = 0.;
+    for(double value: direct)
+        largest = mmax(largest, fabs(value));
+    ASSERT_GT(largest, 0.);
+
+    // Tabulated values should be the same
+    EXPECT_GT(sigma3.CalculateReducedTable(table_orbitals), 0);
+    EXPECT_TRUE(sigma3.HasReducedTable(table_orbitals));
+
+    for(unsigned int i = 0; i < electrons.size(); i++)
+    {
+        const auto& e = electrons[i];
+        EXPECT_NEAR(direct[i], sigma3.GetMatrixElement(e[0], e[1], e[2], e[3], e[4], e[5]), 1.e-10 * largest);
+    }
+
+    // Stored table is only accepted for the same orbitals and basis
+    std::string filename = "Sigma3CalculatorTest.sigma3";
+    sigma3.Write(filename);
+
+    Sigma3Calculator sigma3_read(orbitals, two_body_integrals);
+    sigma3_read.UpdateIntegrals();
+    sigma3_read.Read(filename, table_orbitals);
+    EXPECT_TRUE(sigma3_read.HasReducedTable(table_orbitals));
+    EXPECT_EQ(sigma3.GetReducedTableSize(), sigma3_read.GetReducedTableSize());
+
+    const auto& e = electrons.front();
+    EXPECT_NEAR(direct.front(), sigma3_read.GetMatrixElement(e[0], e[1], e[2], e[3], e[4], e[5]), 1.e-10 * largest);
+
+    pOrbitalMap other_orbitals = std::make_shared<OrbitalMap>(*table_orbitals);
+    other_orbitals->AddState(orbitals->valence->GetState(OrbitalInfo(3, 2)));
+    sigma3_read.Read(filename, other_orbitals);
+    EXPECT_FALSE(sigma3_read.HasReducedTable(table_orbitals));
+    EXPECT_EQ(0, sigma3_read.GetReducedTableSize());
+
+    // Different energy denominators are a different basis
+    Sigma3Calculator sigma3_shifted(orbitals, two_body_integrals);
+    sigma3_shifted.UpdateIntegrals();
+    sigma3_shifted.SetEnergyShift(0.01);
+    sigma3_shifted.Read(filename, table_orbitals);
+    EXPECT_FALSE(sigma3_shifted.HasReducedTable(table_orbitals));
+
+    std::remove(filename.c_str());
+}
@@ -8,11 +8,11 @@ typedef Eigen::Map<const Eigen::VectorXd, Eigen::Unaligned, Eigen::InnerStride<>
 typedef Eigen::Map<const Eigen::ArrayXd, Eigen::Unaligned, Eigen::InnerStride<>> EigenArrayMapped;
 
 SigmaPotential::SigmaPotential(pLattice lattice):
-    LatticeObserver(lattice), start(0), matrix_size(0), stride(4)
+    LatticeObserver(lattice), compressed(false), start(0), matrix_size(0), stride(4)
 {}
 
 SigmaPotential::SigmaPotential(pLattice lattice, unsigned int end_point, unsigned int start_point, unsigned int stride):
-    LatticeObserver(lattice), start(start_point), matrix_size(0), stride(stride)
+    LatticeObserver(lattice), compressed(false), start(start_point), matrix_size(0), stride(stride)
 {
     resize_and_clear(end_point);
 }
@@ -22,6 +22,11 @@ SigmaPotential::~SigmaPotential()
 
 void SigmaPotential::clear()
 {
+    if(compressed)
+    {   resize_and_clear(size());
+        return;
+    }
+
     ff.setZero();
     fg.setZero();
     gf.setZero();
@@ -33,6 +38,9 @@ void SigmaPotential::resize_and_clear(unsigned int new_size)
     if(new_size > lattice->size())
         new_size = lattice->size();
 
+    compressed = false;
+    ff_factors = fg_factors = gf_factors = gg_factors = LowRankFactors();
+
     matrix_size = (new_size - start)/stride;
     ff = SigmaMatrix::Zero(matrix_size, matrix_size);
     if(use_fg)
@@ -59,13 +67,23 @@ void SigmaPotential::Alert()
     if(lattice->size() < size())
     {
         matrix_size = (lattice->size() - start)/stride;
-        ff.noalias() = ff.topLeftCorner(matrix_size, matrix_size);
-        if(use_fg)
-        {   fg.noalias() = fg.topLeftCorner(matrix_size, matrix_size);
-            gf.noalias() = gf.topLeftCorner(matrix_size, matrix_size);
+        if(compressed)
+        {   for(LowRankFactors* factors: {&ff_factors, &fg_factors, &gf_factors, &gg_factors})
+            {   if(factors->left.rows())
+                {   factors->left = factors->left.topRows(matrix_size).eval();
+                    factors->right = factors->right.topRows(matrix_size).eval();
+                }
+            }
+        }
+        else
+        {   ff.noalias() = ff.topLeftCorner(matrix_size, matrix_size);
+            if(use_fg)
+            {   fg.noalias() = fg.topLeftCorner(matrix_size, matrix_size);
+                gf.noalias() = gf.topLeftCorner(matrix_size, matrix_size);
+            }
+            if(use_gg)
+                gg.noalias() = gg.topLeftCorner(matrix_size, matrix_size);
         }
-        if(use_gg)
-            gg.noalias() = gg.topLeftCorner(matrix_size, matrix_size);
 
         Rgrid.resize(matrix_size);
         dRgrid.resize(matrix_size);
@@ -92,6 +110,9 @@ void SigmaPotential::IncludeLower(bool include_fg, bool include_gg)
 
 void SigmaPotential::AddToSigma(const SpinorFunction& s1, const SpinorFunction& s2, double coeff)
 {
+    if(compressed)
+        Decompress();
+
     // PRE: s1.size() & s2.size() >= size()
     // Map used subset of f1, f2 on to Eigen vectors
     EigenVectorMapped f1(s1.f.data()+start, matrix_size, Eigen::InnerStride<>(stride));
@@ -115,6 +136,9 @@ void SigmaPotential::AddToSigma(const SpinorFunction& s1, const SpinorFunction&
 
 void SigmaPotential::AddToSigma(const std::vector<double>& f1, const std::vector<double>& f2, double coeff)
 {
+    if(compressed)
+        Decompress();
+
     // PRE: s1.size() & s2.size() >= size()
     // Map used subset of f1, f2 on to Eigen vectors
     EigenVectorMapped mapped_f1(f1.data()+start, matrix_size, Eigen::InnerStride<>(stride));
@@ -123,6 +147,70 @@ void SigmaPotential::AddToSigma(const std::vector<double>& f1, const std::vector
     ff.noalias() += coeff * mapped_f1 * mapped_f2.transpose();
 }
 
+void SigmaPotential::AddToSigma(const std::vector<SpinorFunction>& s1, const std::vector<SpinorFunction>& s2, const std::vector<double>& coeff)
+{
+    // PRE: s1[i].size() & s2[i].size() >= size()
+    unsigned int num_terms = coeff.size();
+    if(num_terms == 0)
+        return;
+
+    if(compressed)
+        Decompress();
+
+    // Collect used subsets of functions as columns, with coefficients included on the left
+    Eigen::MatrixXd f1(matrix_size, num_terms), f2(matrix_size, num_terms);
+    for(unsigned int i = 0; i < num_terms; i++)
+    {   f1.col(i) = coeff[i] * EigenVectorMapped(s1[i].f.data()+start, matrix_size, Eigen::InnerStride<>(stride));
+        f2.col(i) = EigenVectorMapped(s2[i].f.data()+start, matrix_size, Eigen::InnerStride<>(stride));
+    }
+
+    ff.noalias() += f1 * f2.transpose();
+
+    if(use_fg || use_gg)
+    {
+        Eigen::MatrixXd g1(matrix_size, num_terms), g2(matrix_size, num_terms);
+        for(unsigned int i = 0; i < num_terms; i++)
+        {   g1.col(i) = coeff[i] * EigenVectorMapped(s1[i].g.data()+start, matrix_size, Eigen::InnerStride<>(stride));
+            g2.col(i) = EigenVectorMapped(s2[i].g.data()+start, matrix_size, Eigen::InnerStride<>(stride));
+        }
+
+        if(use_fg)
+        {   fg.noalias() += f1 * g2.transpose();
+            gf.noalias() += g1 * f2.transpose();
+        }
+        if(use_gg)
+            gg.noalias() += g1 * g2.transpose();
+    }
+}
+
+const SigmaPotential& SigmaPotential::operator+=(const SigmaPotential& other)
+{
+    if(compressed)
+        Decompress();
+
+    if(other.compressed)
+    {   // Add other through its low-rank factors
+        ff.noalias() += other.ff_factors.left * other.ff_factors.right.transpose();
+        if(use_fg)
+        {   fg.noalias() += other.fg_factors.left * other.fg_factors.right.transpose();
+            gf.noalias() += other.gf_factors.left * other.gf_factors.right.transpose();
+        }
+        if(use_gg)
+            gg.noalias() += other.gg_factors.left * other.gg_factors.right.transpose();
+    }
+    else
+    {   ff += other.ff;
+        if(use_fg)
+        {   fg += other.fg;
+            gf += other.gf;
+        }
+        if(use_gg)
+            gg += other.gg;
+    }
+
+    return *this;
+}
+
 SpinorFunction SigmaPotential::ApplyTo(const SpinorFunction& a) const
 {
     // PRE: a.size() >= size()
@@ -134,7 +222,7 @@ SpinorFunction SigmaPotential::ApplyTo(const SpinorFunction& a) const
 
     // coefficient-wise multiplication
     Eigen::VectorXd fadr = (fa * dr * double(stride)).matrix();
-    Eigen::VectorXd sigma_a_f = ff * fadr;
+    Eigen::VectorXd sigma_a_f = Multiply(ff, ff_factors, fadr);
 
     if(use_fg)
     {
@@ -142,14 +230,14 @@ SpinorFunction SigmaPotential::ApplyTo(const SpinorFunction& a) const
         Eigen::VectorXd gadr = (ga * dr * double(stride)).matrix();
 
         // Add fg part to upper
-        sigma_a_f += fg * gadr;
+        sigma_a_f += Multiply(fg, fg_factors, gadr);
 
         // Add gf part to lower
-        Eigen::VectorXd sigma_a_g = gf * fadr;
+        Eigen::VectorXd sigma_a_g = Multiply(gf, gf_factors, fadr);
 
         // Add gg part to lower
         if(use_gg)
-            sigma_a_g += gg * gadr;
+            sigma_a_g += Multiply(gg, gg_factors, gadr);
 
         if(stride == 1)
             std::copy(sigma_a_g.data(), sigma_a_g.data()+matrix_size, ret.g.begin()+start);
@@ -177,6 +265,84 @@ SpinorFunction SigmaPotential::ApplyTo(const SpinorFunction& a) const
     return ret;
 }
 
+void SigmaPotential::Compress(double tolerance)
+{
+    if(compressed)
+        Decompress();
+
+    // Threshold is relative to the dominant ff quadrant
+    double threshold = tolerance * ff.norm();
+
+    ff_factors = GetLowRankFactors(ff, threshold);
+    ff.resize(0, 0);
+
+    if(use_fg)
+    {   fg_factors = GetLowRankFactors(fg, threshold);
+        gf_factors = GetLowRankFactors(gf, threshold);
+        fg.resize(0, 0);
+        gf.resize(0, 0);
+    }
+    if(use_gg)
+    {   gg_factors = GetLowRankFactors(gg, threshold);
+        gg.resize(0, 0);
+    }
+
+    compressed = true;
+}
+
+void SigmaPotential::Decompress()
+{
+    if(!compressed)
+        return;
+
+    ff = ff_factors.Expand();
+    if(use_fg)
+    {   fg = fg_factors.Expand();
+        gf = gf_factors.Expand();
+    }
+    if(use_gg)
+        gg = gg_factors.Expand();
+
+    ff_factors = fg_factors = gf_factors = gg_factors = LowRankFactors();
+    compressed = false;
+}
+
+unsigned int SigmaPotential::GetRank() const
+{
+    unsigned int rank = 0;
+    if(compressed)
+    {   for(const LowRankFactors* factors: {&ff_factors, &fg_factors, &gf_factors, &gg_factors})
+            rank = mmax(rank, (unsigned int)factors->left.cols());
+    }
+
+    return rank;
+}
+
+auto SigmaPotential::GetLowRankFactors(const SigmaMatrix& full, double threshold) -> LowRankFactors
+{
+    Eigen::BDCSVD<Eigen::MatrixXd> svd(full, Eigen::ComputeThinU | Eigen::ComputeThinV);
+    const Eigen::VectorXd& singular_values = svd.singularValues();
+
+    // Singular values are in decreasing order
+    int rank = 0;
+    while(rank < singular_values.size() && singular_values(rank) > threshold)
+        rank++;
+
+    LowRankFactors factors;
+    factors.left = svd.matrixU().leftCols(rank) * singular_values.head(rank).asDiagonal();
+    factors.right = svd.matrixV().leftCols(rank);
+
+    return factors;
+}
+
+Eigen::VectorXd SigmaPotential::Multiply(const SigmaMatrix& full, const LowRankFactors& factors, const Eigen::VectorXd& x) const
+{
+    if(compressed)
+        return factors.left * (factors.right.transpose() * x);
+    else
+        return full * x;
+}
+
 bool SigmaPotential::Read(const std::string& filename)
 {
     FILE* fp = file_err_handler->fopen(filename.c_str(), "rb");
@@ -220,15 +386,25 @@ void SigmaPotential::Write(const std::string& filename) const
         file_err_handler->fwrite(&use_fg, sizeof(bool), 1, fp);
         file_err_handler->fwrite(&use_gg, sizeof(bool), 1, fp);
 
-        // Write data
-        file_err_handler->fwrite(ff.data(), sizeof(double), matrix_size * matrix_size, fp);
+        // Write data; compressed matrices are written in full so that the file format is unchanged
+        auto write_matrix = [&](const SigmaMatrix& full, const LowRankFactors& factors)
+        {
+            if(compressed)
+            {   SigmaMatrix expanded = factors.Expand();
+                file_err_handler->fwrite(expanded.data(), sizeof(double), matrix_size * matrix_size, fp);
+            }
+            else
+                file_err_handler->fwrite(full.data(), sizeof(double), matrix_size * matrix_size, fp);
+        };
+
+        write_matrix(ff, ff_factors);
 
         if(use_fg)
-        {   file_err_handler->fwrite(fg.data(), sizeof(double), matrix_size * matrix_size, fp);
-            file_err_handler->fwrite(gf.data(), sizeof(double), matrix_size * matrix_size, fp);
+        {   write_matrix(fg, fg_factors);
+            write_matrix(gf, gf_factors);
         }
         if(use_gg)
-            file_err_handler->fwrite(gg.data(), sizeof(double), matrix_size * matrix_size, fp);
+            write_matrix(gg, gg_factors);
 
         file_err_handler->fclose(fp);
     }
@@ -47,6 +47,17 @@ public:
      */
     void AddToSigma(const std::vector<double>& f1, const std::vector<double>& f2, double coeff);
 
+    /** Sigma(r1, r2) += Sum_i s1[i](r1) * s2[i](r2) * coeff[i]
+        Much faster than adding each term separately since it is done as a single matrix product.
+        PRE: s1[i].size() & s2[i].size() >= size()
+     */
+    void AddToSigma(const std::vector<SpinorFunction>& s1, const std::vector<SpinorFunction>& s2, const std::vector<double>& coeff);
+
+    /** Add other sigma, which must have the same dimensions.
+        This sigma is decompressed; a compressed other is added through its low-rank factors.
+     */
+    const SigmaPotential& operator+=(const SigmaPotential& other);
+
     /** Return Integral[ Sigma(r1, r2). a(r2). dr2].
         PRE: a.size() >= size()
         Direct integration is hard-coded here for efficiency when using Eigen, therefore lattice is
@@ -54,15 +65,46 @@ public:
      */
     SpinorFunction ApplyTo(const SpinorFunction& a) const;
 
+    /** Replace each stored quadrant by a truncated singular value decomposition, discarding singular
+        values smaller than tolerance * |ff| (Frobenius norm). Since Sigma is smooth the
+        resulting rank r is much smaller than size(), and ApplyTo() costs O(r N) rather than O(N^2).
+        Subsequent calls to AddToSigma() restore the full (approximated) matrices.
+     */
+    void Compress(double tolerance);
+
+    /** Restore full matrices from the low-rank factors. */
+    void Decompress();
+
+    bool IsCompressed() const { return compressed; }
+
+    /** Largest rank of the low-rank factors, or zero if not compressed. */
+    unsigned int GetRank() const;
+
     /** Attempt to read file. Return false if file not found, in which case SigmaPotential is not changed. */
     bool Read(const std::string& filename);
     void Write(const std::string& filename) const;
 
+protected:
+    /** Low-rank approximation of a quadrant: matrix = left * right^T, with rank = left.cols(). */
+    struct LowRankFactors
+    {   SigmaMatrix left, right;
+        SigmaMatrix Expand() const { return left * right.transpose(); }
+    };
+
+    /** Truncated SVD of full, keeping singular values larger than threshold. */
+    static LowRankFactors GetLowRankFactors(const SigmaMatrix& full, double threshold);
+
+    /** Return quadrant * x, using the low-rank factors if compressed. */
+    Eigen::VectorXd Multiply(const SigmaMatrix& full, const LowRankFactors& factors, const Eigen::VectorXd& x) const;
+
 protected:
     // A matrix for each quadrant of Sigma
-    SigmaMatrix ff, fg, gf, gg; //!< Matrices of size matrix_size or zero if not used
+    SigmaMatrix ff, fg, gf, gg; //!< Matrices of size matrix_size or zero if not used (or compressed)
     bool use_fg, use_gg;
 
+    bool compressed;
+    LowRankFactors ff_factors, fg_factors, gf_factors, gg_factors;
+
     unsigned int start;         //!< start point on lattice
     unsigned int matrix_size;   //!< matrix_size = (end_point - start)/stride
     unsigned int stride;
@@ -1,4 +1,5 @@
 #include "Include.h"
+#include "HartreeFock/OrbitalBank.h"
 
 #ifdef AMBIT_USE_OPENMP
     #include <omp.h>
@@ -42,12 +43,30 @@ unsigned int SlaterIntegrals<MapType>::CalculateTwoElectronIntegrals(pOrbitalMap
 
     unsigned int i1, i2, i3, i4;
     int k;
-    pOrbitalConst s1, s2, s3, s4;
+    pOrbitalConst s1, s2, s3;
 
     std::set<KeyType> found_keys;   // For check_size_only
     if(check_size_only)
         hartreeY_operator->SetLightWeightMode(true);
 
+    // Orbitals 4 are packed into a contiguous bank with one row for each orbital in map order,
+    // so that all < 4 | Y^k_{31} | 2 > for a given orbital 2 are integrated in one batch.
+    // states_4 translates bank rows to state_index. The bank isn't needed to count integrals.
+    std::vector<unsigned int> states_4;
+    std::vector<int> L_4, two_j_4;
+    states_4.reserve(orbital_map_4->size());
+    L_4.reserve(orbital_map_4->size());
+    two_j_4.reserve(orbital_map_4->size());
+    for(const auto& pair: *orbital_map_4)
+    {   states_4.push_back(orbitals->state_index.at(pair.first));
+        L_4.push_back(pair.first.L());
+        two_j_4.push_back(pair.first.TwoJ());
+    }
+
+    pOrbitalBankConst bank_4;
+    if(!check_size_only)
+        bank_4 = std::make_shared<OrbitalBank>(*orbital_map_4);
+
     // Get Y^k_{31}
     auto it_1 = orbital_map_1->begin();
 #ifdef AMBIT_USE_OPENMP
@@ -78,12 +97,15 @@ unsigned int SlaterIntegrals<MapType>::CalculateTwoElectronIntegrals(pOrbitalMap
 
             // Limits on k. This is the expensive part to calculate
 #ifdef AMBIT_USE_OPENMP
-            #pragma omp task firstprivate(i1, i3, s1, s3) private(k, i2, i4, s2, s4)
+            #pragma omp task firstprivate(i1, i3, s1, s3) private(k, i2, i4, s2)
             {
             k = hartreeY_operators[omp_get_thread_num()]->SetOrbitals(s3, s1);
 #else
             k = hartreeY_operator->SetOrbitals(s3, s1);
 #endif
+            std::vector<unsigned int> new_indices_4;
+            std::vector<KeyType> new_keys;
+
             while(k != -1)
             {
                 auto it_2 = orbital_map_2->begin();
@@ -92,16 +114,17 @@ unsigned int SlaterIntegrals<MapType>::CalculateTwoElectronIntegrals(pOrbitalMap
                     i2 = orbitals->state_index.at(it_2->first);
                     s2 = it_2->second;
 
-                    auto it_4 = orbital_map_4->begin();
-                    while(it_4 != orbital_map_4->end())
+                    new_indices_4.clear();
+                    new_keys.clear();
+
+                    for(unsigned int n4 = 0; n4 < states_4.size(); n4++)
                     {
-                        i4 = orbitals->state_index.at(it_4->first);
-                        s4 = it_4->second;
+                        i4 = states_4[n4];
 
                         // Check max_pqn conditions and k conditions
-                        if(((s1->L() + s2->L() + s3->L() + s4->L())%2 == 0) &&
-                           (2 * k >= abs(s2->TwoJ() - s4->TwoJ())) &&
-                           (2 * k <= s2->TwoJ() + s4->TwoJ()))
+                        if(((s1->L() + s2->L() + s3->L() + L_4[n4])%2 == 0) &&
+                           (2 * k >= abs(s2->TwoJ() - two_j_4[n4])) &&
+                           (2 * k <= s2->TwoJ() + two_j_4[n4]))
                         {
                             KeyType key = GetKey(k, i1, i2, i3, i4);
 
@@ -112,18 +135,23 @@ unsigned int SlaterIntegrals<MapType>::CalculateTwoElectronIntegrals(pOrbitalMap
                             else
                             {   // Check that this integral doesn't already exist
                                 if(TwoElectronIntegrals.find(key) == TwoElectronIntegrals.end())
-                                {
-#ifdef AMBIT_USE_OPENMP
-                                    double radial = hartreeY_operators[omp_get_thread_num()]->GetMatrixElement(*s4, *s2);
-                                    #pragma omp critical(TWO_ELECTRON_SLATER)
-#else
-                                    double radial = hartreeY_operator->GetMatrixElement(*s4, *s2);
-#endif
-                                    TwoElectronIntegrals.insert(std::pair<KeyType, double>(key, radial));
+                                {   new_indices_4.push_back(n4);
+                                    new_keys.push_back(key);
                                 }
                             }
                         }
-                        it_4++;
+                    }
+
+                    if(new_keys.size())
+                    {
+#ifdef AMBIT_USE_OPENMP
+                        std::vector<double> radial = hartreeY_operators[omp_get_thread_num()]->GetMatrixElements(*bank_4, new_indices_4, *s2);
+                        #pragma omp critical(TWO_ELECTRON_SLATER)
+#else
+                        std::vector<double> radial = hartreeY_operator->GetMatrixElements(*bank_4, new_indices_4, *s2);
+#endif
+                        for(unsigned int n = 0; n < new_keys.size(); n++)
+                            TwoElectronIntegrals.insert(std::pair<KeyType, double>(new_keys[n], radial[n]));
                     }
                     it_2++;
                 }
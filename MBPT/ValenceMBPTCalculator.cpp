@@ -117,6 +117,9 @@ double ValenceMBPTCalculator::CalculateTwoElectronValence(unsigned int k, const
     with non-random-access iterators */
     for(ii = 0; ii < excited->size(); ++ii)
     {
+        // Each thread uses its own instance (see MathConstant::Instance)
+        MathConstant* thread_constants = MathConstant::Instance();
+
         auto it_alpha = excited->begin();
         std::advance(it_alpha, ii);
         const OrbitalInfo& salpha = it_alpha->first;
@@ -138,15 +141,15 @@ double ValenceMBPTCalculator::CalculateTwoElectronValence(unsigned int k, const
                 double energy_denominator = (ValenceEnergy - Ealpha - Ebeta + delta);
 
                 int exponent = (sa.TwoJ() + sb.TwoJ() + sc.TwoJ() + sd.TwoJ() + salpha.TwoJ() + sbeta.TwoJ())/2;
-                coeff_alphabeta *= constants->minus_one_to_the_power(exponent + k + 1);
+                coeff_alphabeta *= thread_constants->minus_one_to_the_power(exponent + k + 1);
 
                 k1 = kmin(sa, salpha);
                 k1max = kmax(sa, salpha);
 
                 while(k1 <= k1max)
                 {
-                    double coeff_ab = constants->Electron3j(sa.TwoJ(), salpha.TwoJ(), k1) *
-                                      constants->Electron3j(sb.TwoJ(), sbeta.TwoJ(), k1);
+                    double coeff_ab = thread_constants->Electron3j(sa.TwoJ(), salpha.TwoJ(), k1) *
+                                      thread_constants->Electron3j(sb.TwoJ(), sbeta.TwoJ(), k1);
 
                     if(coeff_ab)
                     {
@@ -157,12 +160,12 @@ double ValenceMBPTCalculator::CalculateTwoElectronValence(unsigned int k, const
 
                         while(k2 <= k2max)
                         {
-                            double coeff = constants->Electron3j(salpha.TwoJ(), sc.TwoJ(), k2) *
-                                           constants->Electron3j(sbeta.TwoJ(), sd.TwoJ(), k2);
+                            double coeff = thread_constants->Electron3j(salpha.TwoJ(), sc.TwoJ(), k2) *
+                                           thread_constants->Electron3j(sbeta.TwoJ(), sd.TwoJ(), k2);
 
                             if(coeff)
-                                coeff = coeff * constants->Wigner6j(sc.J(), sa.J(), k, k1, k2, salpha.J())
-                                              * constants->Wigner6j(sd.J(), sb.J(), k, k1, k2, sbeta.J());
+                                coeff = coeff * thread_constants->Wigner6j(sc.J(), sa.J(), k, k1, k2, salpha.J())
+                                              * thread_constants->Wigner6j(sd.J(), sb.J(), k, k1, k2, sbeta.J());
                             if(coeff)
                             {
                                 coeff = coeff * coeff_ab * coeff_alphabeta;
@@ -3,6 +3,8 @@
 #endif
 #include "Include.h"
 #include "Eigensolver.h"
+#include <algorithm>
+#include <vector>
 
 #define SMALL_LIM 1000
 
@@ -85,7 +87,7 @@ void Eigensolver::SolveSmallSymmetric(double* matrix, double* eigenvalues, unsig
     }
 }
 
-void Eigensolver::SolveLargeSymmetric(Matrix* matrix, double* eigenvalues, double* eigenvectors, unsigned int N, unsigned int num_solutions)
+void Eigensolver::SolveLargeSymmetric(Matrix* matrix, double* eigenvalues, double* eigenvectors, unsigned int N, unsigned int num_solutions, unsigned int num_initial_vectors)
 {
     static int n, lim;
     static double *diag;
@@ -112,7 +114,6 @@ void Eigensolver::SolveLargeSymmetric(Matrix* matrix, double* eigenvalues, doubl
     iselec = new int[lim];    // unused if lowest eigenvalues are wanted
     for(i=0; i<lim; i++)
         iselec[i] = 0;
-    niv = 0;
     mblock = num_solutions;
     maxiter = 20000;
     hiend = false;
@@ -120,6 +121,14 @@ void Eigensolver::SolveLargeSymmetric(Matrix* matrix, double* eigenvalues, doubl
     worksize = 2*n*lim + lim*lim + (ihigh+10)*lim + ihigh;
     work = new double[worksize];
 
+    // Initial estimates go in the first niv columns of work (niv = 0 => unit vectors)
+    niv = 0;
+    if(num_initial_vectors)
+    {   num_initial_vectors = mmin(num_initial_vectors, (unsigned int)lim);
+        std::copy(eigenvectors, eigenvectors + num_initial_vectors * N, work);
+        niv = OrthonormaliseInitialVectors(work, num_initial_vectors, N, diag, num_solutions);
+    }
+
     intworksize = 7*lim;
     intwork = new int[intworksize];
     
@@ -151,7 +160,7 @@ void Eigensolver::SolveLargeSymmetric(Matrix* matrix, double* eigenvalues, doubl
 }
 
 #ifdef AMBIT_USE_MPI
-void Eigensolver::MPISolveLargeSymmetric(Matrix* matrix, double* eigenvalues, double* eigenvectors, unsigned int N, unsigned int num_solutions)
+void Eigensolver::MPISolveLargeSymmetric(Matrix* matrix, double* eigenvalues, double* eigenvectors, unsigned int N, unsigned int num_solutions, unsigned int num_initial_vectors)
 {
     static int n, lim;
     static double *diag;
@@ -187,7 +196,6 @@ void Eigensolver::MPISolveLargeSymmetric(Matrix* matrix, double* eigenvalues, do
         iselec = new int[lim];    // unused if lowest eigenvalues are wanted
         for(i=0; i<lim; i++)
             iselec[i] = 0;
-        niv = 0;
         mblock = num_solutions;
         maxiter = 20000;
         hiend = false;
@@ -197,6 +205,14 @@ void Eigensolver::MPISolveLargeSymmetric(Matrix* matrix, double* eigenvalues, do
         for(i=0; i<worksize; i++)
             work[i] = 0.;
 
+        // Initial estimates go in the first niv columns of work (niv = 0 => unit vectors)
+        niv = 0;
+        if(num_initial_vectors)
+        {   num_initial_vectors = mmin(num_initial_vectors, (unsigned int)lim);
+            std::copy(eigenvectors, eigenvectors + num_initial_vectors * N, work);
+            niv = OrthonormaliseInitialVectors(work, num_initial_vectors, N, diag, num_solutions);
+        }
+
         intworksize = 7*lim;
         intwork = new int[intworksize];
         for(i=0; i<intworksize; i++)
@@ -282,6 +298,74 @@ void Eigensolver::MPISolveLargeSymmetric(Matrix* matrix, double* eigenvalues, do
 }
 #endif
 
+unsigned int Eigensolver::OrthonormaliseInitialVectors(double* vectors, unsigned int num_vectors, unsigned int N, const double* diag, unsigned int min_vectors) const
+{
+    // Project out previous vectors (twice, for numerical stability) and normalise.
+    // Return false if vector is linearly dependent on previous vectors.
+    auto orthonormalise = [&](double* v, unsigned int num_previous)
+    {
+        double original_norm = 0.;
+        for(unsigned int j = 0; j < N; j++)
+            original_norm += v[j] * v[j];
+
+        for(int pass = 0; pass < 2; pass++)
+        {   for(unsigned int k = 0; k < num_previous; k++)
+            {
+                const double* u = vectors + k * N;
+                double overlap = 0.;
+                for(unsigned int j = 0; j < N; j++)
+                    overlap += u[j] * v[j];
+                for(unsigned int j = 0; j < N; j++)
+                    v[j] -= overlap * u[j];
+            }
+        }
+
+        double norm = 0.;
+        for(unsigned int j = 0; j < N; j++)
+            norm += v[j] * v[j];
+
+        if(norm <= 1.e-6 * original_norm || norm == 0.)
+            return false;
+
+        norm = 1./sqrt(norm);
+        for(unsigned int j = 0; j < N; j++)
+            v[j] *= norm;
+        return true;
+    };
+
+    unsigned int num_kept = 0;
+    for(unsigned int i = 0; i < num_vectors; i++)
+    {
+        double* v = vectors + num_kept * N;
+        if(i != num_kept)
+            std::copy(vectors + i * N, vectors + (i+1) * N, v);
+
+        if(orthonormalise(v, num_kept))
+            num_kept++;
+    }
+
+    if(num_kept < min_vectors)
+    {
+        // Fill up with unit vectors, starting from the smallest diagonal elements
+        std::vector<unsigned int> order(N);
+        for(unsigned int j = 0; j < N; j++)
+            order[j] = j;
+        std::sort(order.begin(), order.end(), [diag](unsigned int a, unsigned int b){ return diag[a] < diag[b]; });
+
+        for(unsigned int j = 0; j < N && num_kept < min_vectors; j++)
+        {
+            double* v = vectors + num_kept * N;
+            std::fill(v, v + N, 0.);
+            v[order[j]] = 1.;
+
+            if(orthonormalise(v, num_kept))
+                num_kept++;
+        }
+    }
+
+    return num_kept;
+}
+
 bool Eigensolver::SolveSimultaneousEquations(double* matrix, double* vector, unsigned int N)
 {
     if(N)
@@ -24,21 +24,24 @@ public:
         PRE: Matrix.GetSize() == N
              eigenvalues[num_solutions], eigenvectors[num_solutions * N]
              Only calculates lowest num_solutions
+             If num_initial_vectors > 0, the first num_initial_vectors * N elements of eigenvectors
+             are used as starting estimates (e.g. solutions of a similar matrix).
         POST: eigenvectors[i*N + j], i=(0, num_solutions-1), j=(0, N-1) is the eigenvector 
               of the original matrix with eigenvalue "eigenvalues[i]".
               Eigenvalues are sorted in ascending order.
      */
-    void SolveLargeSymmetric(Matrix* matrix, double* eigenvalues, double* eigenvectors, unsigned int N, unsigned int num_solutions);
+    void SolveLargeSymmetric(Matrix* matrix, double* eigenvalues, double* eigenvectors, unsigned int N, unsigned int num_solutions, unsigned int num_initial_vectors = 0);
 
     /** Solve a double symmetric matrix using Davidson algorithm on a distributed architecture.
         PRE: Matrix.GetSize() == N
              eigenvalues[num_solutions], eigenvectors[num_solutions * N]
              Only calculates lowest num_solutions
+             Starting estimates are used as in SolveLargeSymmetric() (only those on the root process matter).
         POST: eigenvectors[i*N + j], i=(0, num_solutions-1), j=(0, N-1) is the eigenvector 
               of the original matrix with eigenvalue "eigenvalues[i]".
               Eigenvalues are sorted in ascending order.
      */
-    void MPISolveLargeSymmetric(Matrix* matrix, double* eigenvalues, double* eigenvectors, unsigned int N, unsigned int num_solutions);
+    void MPISolveLargeSymmetric(Matrix* matrix, double* eigenvalues, double* eigenvectors, unsigned int N, unsigned int num_solutions, unsigned int num_initial_vectors = 0);
 
     /** Solve a matrix equation in the form A*x = B, using lapack routine "dgesv".
         PRE: A = matrix[N][N]
@@ -59,6 +62,15 @@ public:
               Eigenvalues are sorted in ascending order.                  
      */
     bool SolveMatrixEquation(double* A_matrix, double* B_matrix, double* eigenvalues, unsigned int N);
+
+protected:
+    /** Orthonormalise starting vectors[num_vectors * N] for the Davidson method (Gram-Schmidt),
+        discarding any that are linearly dependent. If fewer than min_vectors remain, add unit vectors
+        corresponding to the smallest diagonal elements diag[N].
+        PRE: vectors has space for max(num_vectors, min_vectors) * N elements.
+        Return number of starting vectors.
+     */
+    unsigned int OrthonormaliseInitialVectors(double* vectors, unsigned int num_vectors, unsigned int N, const double* diag, unsigned int min_vectors) const;
 };
 
 }
@@ -23,6 +23,8 @@ ExpLattice::ExpLattice(unsigned int numpoints, double r_min, double H):
     {   r[i] = lattice_to_real(i);
         dr[i] = calculate_dr(r[i]);
     }
+
+    CalculateSimpsonWeights();
 }
 
 bool ExpLattice::operator==(const ExpLattice& other) const
@@ -16,6 +16,8 @@ Lattice::Lattice(unsigned int numpoints, double r_min, double r_max):
     {   r[i] = lattice_to_real(i);
         dr[i] = calculate_dr(r[i]);
     }
+
+    CalculateSimpsonWeights();
 }
 
 Lattice::Lattice(FILE* binary_infile)
@@ -32,6 +34,7 @@ Lattice::Lattice(FILE* binary_infile)
     file_err_handler->fread(dr.data(), sizeof(double), num_points, binary_infile);
 
     original_size = num_points;
+    CalculateSimpsonWeights();
 }
 
 unsigned int Lattice::resize(unsigned int new_size)
@@ -50,6 +53,7 @@ unsigned int Lattice::resize(unsigned int new_size)
         {   r[i] = lattice_to_real(i);
             dr[i] = calculate_dr(r[i]);
         }
+        CalculateSimpsonWeights(old_size);
 
         // Do powers of r
         for(unsigned int k = 0; k < r_power.size(); k++)
@@ -142,6 +146,20 @@ const double* Lattice::Calculate_Rpower(unsigned int k)
     return r_power[kminustwo].data();
 }
 
+void Lattice::CalculateSimpsonWeights(unsigned int start)
+{
+    simpson_weights.resize(dr.size());
+    for(unsigned int i = start; i < dr.size(); i++)
+    {
+        if(i == 0)
+            simpson_weights[i] = dr[i];
+        else if(i%2)
+            simpson_weights[i] = 4./3. * dr[i];
+        else
+            simpson_weights[i] = 2./3. * dr[i];
+    }
+}
+
 void Lattice::Subscribe(LatticeObserver* observer)
 {
     // Often (but not always) last to subscribe is first to unsubscribe.
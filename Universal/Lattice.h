@@ -59,6 +59,11 @@ public:
     const double* R() const { return r.data(); }
     const double* dR() const { return dr.data(); }
 
+    /** Return dR multiplied by the weights of Simpson's rule, from 0 to size()-1:
+            dR[0], 4/3 dR[1], 2/3 dR[2], 4/3 dR[3], ...
+     */
+    const double* SimpsonWeights() const { return simpson_weights.data(); }
+
     /** Return all points of R^k, from 0 to size()-1.
         PRE: k > 0
       */
@@ -94,6 +99,9 @@ protected:
      */
     const double* Calculate_Rpower(unsigned int k);
 
+    /** Calculate simpson_weights for points from start to the end of dr. */
+    void CalculateSimpsonWeights(unsigned int start = 0);
+
     void Notify();
 
 protected:
@@ -103,6 +111,7 @@ protected:
     // Current size and points
     unsigned int num_points;
     std::vector<double> r, dr;
+    std::vector<double> simpson_weights;
 
     // r_power[k-2] = R^k, defined for k >= 2.
     std::vector<std::vector<double>> r_power;
@@ -4,18 +4,15 @@
 #include <algorithm>
 #include <gsl/gsl_sf_coupling.h>
 
-#ifdef AMBIT_USE_OPENMP
-#include <omp.h>
-#endif
-
 namespace Ambit
 {
 MathConstant* MathConstant::Instance()
 {
 #ifdef AMBIT_USE_OPENMP
-    // each OpenMP thread should get its own MathConstant Instance to maintain thread-safety when caching 3j/6j symbol values
-    static std::unique_ptr<MathConstant[]> instances (new MathConstant[omp_get_max_threads()]());
-    return &(instances[omp_get_thread_num()]);
+    // each OpenMP thread should get its own MathConstant Instance to maintain thread-safety when caching 3j/6j symbol values.
+    // Use thread storage rather than omp_get_thread_num(), which is zero for every thread inside a nested (inactive) region.
+    static thread_local MathConstant instance;
+    return &instance;
 #else
     // Obviously only return one instance if we're not using OpenMP
     static MathConstant instance;
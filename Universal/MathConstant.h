@@ -18,9 +18,16 @@ namespace Ambit
 class MathConstant
 {
 public:
+    /** With OpenMP there is one instance per thread (thread_local storage), since the caches
+        of 3j symbols are not thread-safe. Each instance is built when its thread first asks
+        for it, and stored symbols are not shared between threads.
+        Pointers must not be passed to other threads: call Instance() inside each parallel region.
+     */
     static MathConstant* Instance();
 
-    /** Reset and free used memory. Useful for testing. */
+    /** Reset and free used memory. Useful for testing.
+        With OpenMP this only affects the instance of the calling thread.
+     */
     void Reset();
 
     // Mathematical constants and conversion factors